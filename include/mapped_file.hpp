@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+// Private, copy-on-write memory mapping of an entire file
+// Writes through the mapping are never written back to the file
+
+class MappedFile {
+
+public:
+
+    explicit MappedFile(const std::string& fileName);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    const char* data() const noexcept;
+
+    char* data() noexcept;
+
+    size_t size() const noexcept;
+
+private:
+
+    char* _data;
+
+    size_t _size;
+
+};
+
+inline const char* MappedFile::data() const noexcept {
+    return _data;
+}
+
+inline char* MappedFile::data() noexcept {
+    return _data;
+}
+
+inline size_t MappedFile::size() const noexcept {
+    return _size;
+}
@@ -1,9 +1,12 @@
 #pragma once
 
-#include <map>
+#include <algorithm>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "vector_math.hpp"
@@ -11,12 +14,15 @@
 #include "mesh/attribute.hpp"
 #include "mesh/attribute_buffer.hpp"
 #include "mesh/attribute_view.hpp"
+#include "mesh/bounds.hpp"
+#include "mesh/index_buffer.hpp"
 
-#if (defined (__clang__) || defined (__GNUC__))
-#include <cxxabi.h>
-#define CXX_ABI_INCLUDED
-#endif
 
+// A level of detail of a mesh, a coarser triangle list over the same vertices, e.g. from buildLodChain (mesh_simplify.hpp)
+struct MeshLod {
+    MeshIndexBuffer indices;
+    float error;  // how far its surface may be from the mesh's, in the units of the positions
+};
 
 class Mesh {
 
@@ -28,11 +34,32 @@ public:
 
     Mesh();
 
-    explicit Mesh(size_t numVertices);
+    // the index buffer starts out as narrow as numVertices allows
+    // every attribute buffer, the indices and the bookkeeping of the mesh are allocated from resource, which must outlive the mesh
+    // e.g. meshes of a scene can share a std::pmr::monotonic_buffer_resource, released all at once when the scene is unloaded
+    // memory resources are not thread safe, unless they are synchronized like std::pmr::synchronized_pool_resource
+    explicit Mesh(size_t numVertices, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     template<typename T>
     TypedMeshAttributeBuffer<T>& createAttributeBuffer(MeshAttribute attribute);
 
+    // create a buffer referencing numVertices() elements of external storage, without copying
+    // storageOwner is held by the buffer to keep the storage alive
+    // if the buffer is later resized, it copies its elements into storage of its own
+    template<typename T>
+    TypedMeshAttributeBuffer<T>& createAttributeBuffer(MeshAttribute attribute, T* externalData, std::shared_ptr<const void> storageOwner);
+
+    // create a buffer whose element type is chosen at runtime, e.g. from a file
+    MeshAttributeBuffer& createAttributeBuffer(MeshAttribute attribute, MeshAttributeComponentType componentType, int numComponents);
+
+    // replace the buffer for attribute with a new, value-initialized buffer of a different type
+    // the new buffer keeps the index of the old one, which is returned so its data can still be converted
+    MeshAttributeBufferPtr replaceAttributeBuffer(MeshAttribute attribute, MeshAttributeComponentType componentType, int numComponents);
+
+    void removeAttributeBuffer(MeshAttribute attribute);
+
+    bool hasAttributeBuffer(MeshAttribute attribute) const noexcept;
+
     template<typename T>
     TypedMeshAttributeBuffer<T>& getAttributeBuffer(MeshAttribute attribute);
 
@@ -61,18 +88,62 @@ public:
 
     void setNumVertices(size_t numVertices);
 
-    std::vector<index_t>& indices() noexcept;
+    MeshIndexBuffer& indices() noexcept;
+
+    const MeshIndexBuffer& indices() const noexcept;
 
-    const std::vector<index_t>& indices() const noexcept;
+    MeshIndexType indexType() const noexcept;
 
     bool hasIndices() const noexcept;
 
+    // levels of detail, finest first, stored in mesh files along with the mesh
+    // they index the mesh's vertices, and are not updated when the vertices or indices change
+    size_t numLods() const noexcept;
+
+    MeshLod& lod(size_t level);
+
+    const MeshLod& lod(size_t level) const;
+
+    // add a level coarser than the others, with no indices yet, of the mesh's index type
+    MeshLod& addLod(float error);
+
+    void clearLods() noexcept;
+
+    // true if any attribute buffer, the index buffer or the indices of a level of detail are dirty
+    bool isDirty() const noexcept;
+
+    // mark every buffer clean, once the mesh matches the file it was read from or saved to
+    void markClean() noexcept;
+
+    // the file the dirty flags describe the changes since, the one the mesh was read from or last saved to
+    // empty for meshes that were built in memory or read from a stream
+    const std::pmr::string& fileName() const noexcept;
+
+    void setFileName(std::string_view fileName);
+
+    // bounds of the vec3 POSITION buffer, computed on first use and cached until the positions are accessed non-const,
+    // resized or replaced, see MeshAttributeBuffer::revision()
+    // throws std::invalid_argument if the mesh has no vec3 POSITION buffer
+    // computing fills the cache, so concurrent calls are only safe once hasCachedBounds() is true
+    const MeshBounds& bounds() const;
+
+    // cache bounds already known for the current positions, e.g. stored in the mesh file
+    // throws std::invalid_argument if the mesh has no vec3 POSITION buffer
+    void setBounds(const MeshBounds& bounds);
+
+    // true if bounds() won't have to compute anything
+    bool hasCachedBounds() const noexcept;
+
+    std::pmr::memory_resource* memoryResource() const noexcept;
+
 private:
 
     // Internal methods to make implementation of buffer accesses consistent
     
     std::optional<uint32_t> bufferIndex(MeshAttribute) const;
 
+    void setBufferIndex(MeshAttribute attribute, uint32_t index);
+
     // Static helper methods allow templating for const / non-const access
 
     template<typename SELF_T, typename T, template <typename TT> typename RET_T>
@@ -81,16 +152,34 @@ private:
     template<typename SELF_T, typename T, template <typename TT> typename RET_T>
     static RET_T<T>& getAttributeBuffer(SELF_T* self, MeshAttribute attribute);
 
+    // construct a TypedMeshAttributeBuffer<T> in memory from the mesh's resource
+    template<typename T, typename ... Args>
+    MeshAttributeBufferPtr allocateAttributeBuffer(Args&& ... args) const;
+
+    MeshAttributeBufferPtr newAttributeBuffer(MeshAttribute attribute, MeshAttributeComponentType componentType, int numComponents) const;
+
     // Member data
 
-    std::vector<std::unique_ptr<MeshAttributeBuffer>> _buffers;
+    std::pmr::vector<MeshAttributeBufferPtr> _buffers;
     
-    std::map<MeshAttribute, uint32_t> _bufferIndices;
+    // buffer index of each attribute, indexed by attribute id, which are compact so this stays small
+    std::pmr::vector<uint32_t> _bufferIndices;
 
-    std::vector<index_t> _indices;
+    static constexpr uint32_t NO_BUFFER = UINT32_MAX;
+
+    MeshIndexBuffer _indices;
+
+    std::pmr::vector<MeshLod> _lods;
+
+    std::pmr::string _fileName;
 
     size_t _numVertices;
 
+    // valid while the position buffer is at _boundsRevision
+    mutable std::optional<MeshBounds> _bounds;
+
+    mutable uint64_t _boundsRevision;
+
 };
 
 // Inline implementation
@@ -98,11 +187,17 @@ private:
 // Constructors
 
 inline Mesh::Mesh() :
-        _numVertices(0) {
+        Mesh(0) {
 }
 
-inline Mesh::Mesh(size_t numVertices) :
-        _numVertices(numVertices) {
+inline Mesh::Mesh(size_t numVertices, std::pmr::memory_resource* resource) :
+        _buffers(resource),
+        _bufferIndices(resource),
+        _indices(minimumIndexType(numVertices), resource),
+        _lods(resource),
+        _fileName(resource),
+        _numVertices(numVertices),
+        _boundsRevision(0) {
 }
 
 // Inline functions
@@ -134,70 +229,159 @@ inline void Mesh::setNumVertices(size_t numVertices) {
     }
 }
 
-inline std::vector<Mesh::index_t>& Mesh::indices() noexcept {
+inline MeshIndexBuffer& Mesh::indices() noexcept {
     return _indices;
 }
 
-inline const std::vector<Mesh::index_t>& Mesh::indices() const noexcept {
+inline const MeshIndexBuffer& Mesh::indices() const noexcept {
     return _indices;
 }
 
+inline MeshIndexType Mesh::indexType() const noexcept {
+    return _indices.indexType();
+}
+
 inline bool Mesh::hasIndices() const noexcept {
     return !_indices.empty();
 }
 
+inline size_t Mesh::numLods() const noexcept {
+    return _lods.size();
+}
+
+inline MeshLod& Mesh::lod(size_t level) {
+    return _lods[level];
+}
+
+inline const MeshLod& Mesh::lod(size_t level) const {
+    return _lods[level];
+}
+
+inline MeshLod& Mesh::addLod(float error) {
+    _lods.push_back(MeshLod { MeshIndexBuffer(_indices.indexType(), memoryResource()), error });
+    return _lods.back();
+}
+
+inline void Mesh::clearLods() noexcept {
+    _lods.clear();
+}
+
+inline bool Mesh::isDirty() const noexcept {
+    return _indices.isDirty() || std::any_of(_buffers.begin(), _buffers.end(), [] (const auto& buffer) { return buffer->isDirty(); }) ||
+        std::any_of(_lods.begin(), _lods.end(), [] (const MeshLod& lod) { return lod.indices.isDirty(); });
+}
+
+inline std::pmr::memory_resource* Mesh::memoryResource() const noexcept {
+    return _buffers.get_allocator().resource();
+}
+
+inline void Mesh::markClean() noexcept {
+    _indices.markClean();
+    for (auto& lod : _lods) {
+        lod.indices.markClean();
+    }
+    for (auto& buffer : _buffers) {
+        buffer->markClean();
+    }
+}
+
+inline const std::pmr::string& Mesh::fileName() const noexcept {
+    return _fileName;
+}
+
+inline void Mesh::setFileName(std::string_view fileName) {
+    _fileName = fileName;
+}
+
+inline const MeshBounds& Mesh::bounds() const {
+    const auto& positions = getAttributeBuffer<vec3>(MeshAttribute::POSITION);
+    if (!_bounds || _boundsRevision != positions.revision()) {
+        _bounds = computeBounds(positions.begin(), positions.size());
+        _boundsRevision = positions.revision();
+    }
+    return *_bounds;
+}
+
+inline void Mesh::setBounds(const MeshBounds& bounds) {
+    _boundsRevision = getAttributeBuffer<vec3>(MeshAttribute::POSITION).revision();
+    _bounds = bounds;
+}
+
+inline bool Mesh::hasCachedBounds() const noexcept {
+    std::optional<uint32_t> index = bufferIndex(MeshAttribute::POSITION);
+    return _bounds && index && _buffers[index.value()]->revision() == _boundsRevision;
+}
+
 inline std::optional<uint32_t> Mesh::bufferIndex(MeshAttribute attribute) const {
-    if (auto it = _bufferIndices.find(attribute); it != _bufferIndices.end()) {
-        return it->second;
+    uint32_t id = static_cast<uint32_t>(attribute);
+    if (id < _bufferIndices.size() && _bufferIndices[id] != NO_BUFFER) {
+        return _bufferIndices[id];
     }
     return std::nullopt;
 }
 
+inline void Mesh::setBufferIndex(MeshAttribute attribute, uint32_t index) {
+    uint32_t id = static_cast<uint32_t>(attribute);
+    if (id >= _bufferIndices.size()) {
+        _bufferIndices.resize(id + 1, NO_BUFFER);
+    }
+    _bufferIndices[id] = index;
+}
+
 // Template implementation
 
 template<typename SELF_T, typename T, template <typename TT> typename RET_T>
 inline RET_T<T>* Mesh::getTypedBuffer(SELF_T* self, uint32_t index) {
-    return dynamic_cast<RET_T<T>*>(self->_buffers[index].get());
+    MeshAttributeBuffer* buffer = self->_buffers[index].get();
+    return buffer->hasElementType<T>() ? static_cast<RET_T<T>*>(buffer) : nullptr;
 }
 
 template<typename SELF_T, typename T, template <typename TT> typename RET_T>
 inline RET_T<T>& Mesh::getAttributeBuffer(SELF_T* self, MeshAttribute attribute) {
-
-    // https://stackoverflow.com/questions/1055452/c-get-name-of-type-in-template
-    static const auto tName = [] (void) {
-        std::string tname = typeid(T).name();
-#ifdef CXX_ABI_INCLUDED
-        int status;
-        auto dname = abi::__cxa_demangle(tname.c_str(), NULL, NULL, &status);
-        if (status == 0) {
-            tname = dname;
-            free(dname);
-        } else {
-#endif
-            tname += " (Name may be mangled)";
-#ifdef CXX_ABI_INCLUDED
-        }
-#endif
-        return tname;
-    };
-
     if (std::optional<uint32_t> index = self->bufferIndex(attribute)) {
         RET_T<T>* pRet = getTypedBuffer<SELF_T, T, RET_T>(self, index.value());
         if (pRet) return *pRet;
-        const auto& info = typeid(T);
-        throw std::invalid_argument(std::string("Buffer for mesh attribute: ") + attributeName(attribute) + " does not match type: " + tName());
+        const MeshAttributeBuffer& buffer = *self->_buffers[index.value()];
+        throw std::invalid_argument(std::string("Buffer for mesh attribute: ") + attributeName(attribute) + " of type: " +
+            componentTypeName(buffer.componentType()) + " x" + std::to_string(buffer.numComponents()) + " does not match type: " +
+            componentTypeName(ComponentTypeHelper<T>::componentType) + " x" + std::to_string(ComponentTypeHelper<T>::numComponents));
     }
     throw std::invalid_argument(std::string("Mesh has no buffer for attribute: ") + attributeName(attribute));
 }
 
+template<typename T, typename ... Args>
+inline MeshAttributeBufferPtr Mesh::allocateAttributeBuffer(Args&& ... args) const {
+    using BUFFER_T = TypedMeshAttributeBuffer<T>;
+    std::pmr::memory_resource* resource = memoryResource();
+    void* storage = resource->allocate(sizeof(BUFFER_T), alignof(BUFFER_T));
+    try {
+        BUFFER_T* buffer = new (storage) BUFFER_T(std::forward<Args>(args)..., resource);
+        return MeshAttributeBufferPtr(buffer, MeshAttributeBufferDeleter(resource, sizeof(BUFFER_T), alignof(BUFFER_T)));
+    } catch (...) {
+        resource->deallocate(storage, sizeof(BUFFER_T), alignof(BUFFER_T));
+        throw;
+    }
+}
+
 template<typename T>
 inline TypedMeshAttributeBuffer<T>& Mesh::createAttributeBuffer(MeshAttribute attribute) {
     if (std::optional<uint32_t> index = bufferIndex(attribute)) {
         throw std::invalid_argument(std::string("Mesh already has buffer for attribute: ") + attributeName(attribute));
     }
     uint32_t index = _buffers.size();
-    _bufferIndices.insert(std::make_pair(attribute, index));
-    _buffers.emplace_back(new TypedMeshAttributeBuffer<T>(attribute, _numVertices));
+    setBufferIndex(attribute, index);
+    _buffers.push_back(allocateAttributeBuffer<T>(attribute, _numVertices));
+    return *static_cast<TypedMeshAttributeBuffer<T>*>(_buffers.back().get());
+}
+
+template<typename T>
+inline TypedMeshAttributeBuffer<T>& Mesh::createAttributeBuffer(MeshAttribute attribute, T* externalData, std::shared_ptr<const void> storageOwner) {
+    if (std::optional<uint32_t> index = bufferIndex(attribute)) {
+        throw std::invalid_argument(std::string("Mesh already has buffer for attribute: ") + attributeName(attribute));
+    }
+    uint32_t index = _buffers.size();
+    setBufferIndex(attribute, index);
+    _buffers.push_back(allocateAttributeBuffer<T>(attribute, _numVertices, externalData, std::move(storageOwner)));
     return *static_cast<TypedMeshAttributeBuffer<T>*>(_buffers.back().get());
 }
 
@@ -225,6 +409,52 @@ inline const MeshAttributeBuffer& Mesh::getAttributeBuffer(MeshAttribute attribu
     throw std::invalid_argument(std::string("Mesh has no buffer for attribute: ") + attributeName(attribute));
 }
 
+inline MeshAttributeBufferPtr Mesh::newAttributeBuffer(MeshAttribute attribute, MeshAttributeComponentType componentType, int numComponents) const {
+    return dispatchElementType(componentType, numComponents, [&] (auto tag) {
+        using T = typename decltype(tag)::type;
+        return allocateAttributeBuffer<T>(attribute, _numVertices);
+    });
+}
+
+inline MeshAttributeBuffer& Mesh::createAttributeBuffer(MeshAttribute attribute, MeshAttributeComponentType componentType, int numComponents) {
+    if (std::optional<uint32_t> index = bufferIndex(attribute)) {
+        throw std::invalid_argument(std::string("Mesh already has buffer for attribute: ") + attributeName(attribute));
+    }
+    auto buffer = newAttributeBuffer(attribute, componentType, numComponents);
+    uint32_t index = _buffers.size();
+    setBufferIndex(attribute, index);
+    _buffers.push_back(std::move(buffer));
+    return *_buffers.back();
+}
+
+inline MeshAttributeBufferPtr Mesh::replaceAttributeBuffer(MeshAttribute attribute, MeshAttributeComponentType componentType, int numComponents) {
+    if (std::optional<uint32_t> index = bufferIndex(attribute)) {
+        MeshAttributeBufferPtr buffer = newAttributeBuffer(attribute, componentType, numComponents);
+        _buffers[index.value()].swap(buffer);
+        // the new buffer's revision starts over, so it can't be told apart from the old one
+        if (attribute == MeshAttribute::POSITION) _bounds.reset();
+        return buffer;
+    }
+    throw std::invalid_argument(std::string("Mesh has no buffer for attribute: ") + attributeName(attribute));
+}
+
+inline void Mesh::removeAttributeBuffer(MeshAttribute attribute) {
+    std::optional<uint32_t> index = bufferIndex(attribute);
+    if (!index) {
+        throw std::invalid_argument(std::string("Mesh has no buffer for attribute: ") + attributeName(attribute));
+    }
+    _buffers.erase(_buffers.begin() + index.value());
+    setBufferIndex(attribute, NO_BUFFER);
+    if (attribute == MeshAttribute::POSITION) _bounds.reset();
+    for (uint32_t& i : _bufferIndices) {
+        if (i != NO_BUFFER && i > index.value()) --i;
+    }
+}
+
+inline bool Mesh::hasAttributeBuffer(MeshAttribute attribute) const noexcept {
+    return bufferIndex(attribute).has_value();
+}
+
 inline MeshAttributeBuffer& Mesh::getAttributeBuffer(uint32_t index) {
     return *_buffers[index];
 }
@@ -1,19 +1,53 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 
-enum class MeshAttribute {
-    POSITION, NORMAL, COLOR, TEXCOORD, BONE_INDS, BONE_WEIGHTS
+// the predefined attributes, any other attribute is created by interning its name with internAttribute
+// interned attributes get compact ids following the predefined ones, so they can index flat arrays
+enum class MeshAttribute : uint32_t {
+    POSITION, NORMAL, COLOR, TEXCOORD, BONE_INDS, BONE_WEIGHTS, TANGENT
 };
 
+// the id of a name interned with internAttribute
+// the same name always gives the same attribute within a process, but not across processes,
+// so attributes are stored by name in files and caches
+inline MeshAttribute internAttribute(std::string_view name);
+
+// the name an attribute was interned with, as stored in mesh files
+// the predefined attributes are named "position", "normal", "color", "texCoord", "boneInds", "boneWeights" and "tangent"
+inline const std::string& attributeIdentifier(MeshAttribute attribute);
+
+// one more than the largest attribute id handed out so far
+inline uint32_t attributeIdCount();
+
 enum class MeshAttributeComponentType : uint8_t {
     FLOAT = 0,
     INT = 1,
-    UINT = 2
+    UINT = 2,
+    HALF = 3,     // IEEE 754 binary16
+    SNORM8 = 4,   // signed normalized, [-1, 1]
+    UNORM8 = 5,   // unsigned normalized, [0, 1]
+    SNORM16 = 6,
+    UNORM16 = 7
+};
+
+// type of one attribute of a stored mesh, as listed by the readers of mesh files and mesh packs
+struct MeshAttributeLayout {
+    MeshAttribute attribute;
+    MeshAttributeComponentType componentType;
+    int numComponents;
 };
 
-inline constexpr const char* attributeName(MeshAttribute attribute) {
+// display name, for messages
+inline const char* attributeName(MeshAttribute attribute) {
     switch(attribute) {
     case MeshAttribute::POSITION:
         return "Position";
@@ -27,11 +61,112 @@ inline constexpr const char* attributeName(MeshAttribute attribute) {
         return "Bone indices";
     case MeshAttribute::BONE_WEIGHTS:
         return "Bone weights";
+    case MeshAttribute::TANGENT:
+        return "Tangent";
+    default:
+        return attributeIdentifier(attribute).c_str();
+    }
+}
+
+inline constexpr const char* componentTypeName(MeshAttributeComponentType componentType) {
+    switch (componentType) {
+    case MeshAttributeComponentType::FLOAT:
+        return "float";
+    case MeshAttributeComponentType::INT:
+        return "int";
+    case MeshAttributeComponentType::UINT:
+        return "uint";
+    case MeshAttributeComponentType::HALF:
+        return "half";
+    case MeshAttributeComponentType::SNORM8:
+        return "snorm8";
+    case MeshAttributeComponentType::UNORM8:
+        return "unorm8";
+    case MeshAttributeComponentType::SNORM16:
+        return "snorm16";
+    case MeshAttributeComponentType::UNORM16:
+        return "unorm16";
     default:
-        return "Unknown";
+        return "unknown";
     }
 }
 
 // inline constexpr size_t attributeSize(MeshAttribute attribute) {
 
-// }
\ No newline at end of file
+// }
+
+// Inline implementation
+
+namespace detail {
+
+// process wide table of attribute names, read far more often than written
+// names live in a deque so references to them stay valid as more are interned
+class MeshAttributeRegistry {
+
+public:
+
+    MeshAttributeRegistry() {
+        for (const char* name : { "position", "normal", "color", "texCoord", "boneInds", "boneWeights", "tangent" }) {
+            intern(name);
+        }
+    }
+
+    MeshAttribute intern(std::string_view name) {
+        std::string key(name);
+        {
+            std::shared_lock lock(_mutex);
+            if (auto it = _ids.find(key); it != _ids.end()) {
+                return static_cast<MeshAttribute>(it->second);
+            }
+        }
+        if (name.empty()) {
+            throw std::invalid_argument("Attribute name is empty");
+        }
+        std::unique_lock lock(_mutex);
+        auto [it, inserted] = _ids.try_emplace(std::move(key), static_cast<uint32_t>(_names.size()));
+        if (inserted) {
+            _names.push_back(it->first);
+        }
+        return static_cast<MeshAttribute>(it->second);
+    }
+
+    const std::string& name(MeshAttribute attribute) const {
+        std::shared_lock lock(_mutex);
+        uint32_t id = static_cast<uint32_t>(attribute);
+        if (id >= _names.size()) {
+            throw std::invalid_argument("Attribute id was never interned: " + std::to_string(id));
+        }
+        return _names[id];
+    }
+
+    uint32_t size() const {
+        std::shared_lock lock(_mutex);
+        return static_cast<uint32_t>(_names.size());
+    }
+
+private:
+
+    mutable std::shared_mutex _mutex;
+    std::unordered_map<std::string, uint32_t> _ids;
+    std::deque<std::string> _names;
+
+};
+
+inline MeshAttributeRegistry& attributeRegistry() {
+    static MeshAttributeRegistry registry;
+    return registry;
+}
+
+}
+
+inline MeshAttribute internAttribute(std::string_view name) {
+    return detail::attributeRegistry().intern(name);
+}
+
+inline const std::string& attributeIdentifier(MeshAttribute attribute) {
+    return detail::attributeRegistry().name(attribute);
+}
+
+inline uint32_t attributeIdCount() {
+    return detail::attributeRegistry().size();
+}
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <algorithm>
+#include <memory>
+#include <memory_resource>
 #include <stdexcept>
 #include <vector>
 
@@ -11,7 +13,9 @@
 #include "mesh/component_type_helper.hpp"
 
 
-// Virtual base class for mesh attribute buffers
+// Base class for mesh attribute buffers
+// The element type is stored in the buffer, so querying it and addressing elements never make a virtual call.
+// Only resizing and destruction, which depend on the typed storage, are virtual.
 
 class MeshAttributeBuffer {
 
@@ -29,30 +33,69 @@ public:
 
     void* elementPtr(size_t i);
 
-    virtual MeshAttributeComponentType componentType() const noexcept = 0;
+    MeshAttributeComponentType componentType() const noexcept;
 
-    virtual int numComponents() const noexcept = 0;
+    int numComponents() const noexcept;
 
     size_t elementSize() const noexcept;
 
+    // id of the buffer's element type, see elementTypeId()
+    ElementTypeId elementType() const noexcept;
+
+    // true if this is a TypedMeshAttributeBuffer<T>
+    template<typename T>
+    bool hasElementType() const noexcept;
+
     MeshAttribute getAttribute() const noexcept;
 
+    // true if the elements may have changed since the last markClean(), which readers and saveMesh() call
+    // any non-const access to the elements marks the buffer dirty, new buffers start out dirty
+    bool isDirty() const noexcept;
+
+    // for writes through a pointer obtained before the last markClean(), or before the mesh's bounds were last computed
+    void markDirty() noexcept;
+
+    void markClean() noexcept;
+
+    // incremented by every non-const access to the elements, unlike the dirty flag it is never reset
+    // so anything computed from the elements, like Mesh::bounds(), can tell if it is stale
+    uint64_t revision() const noexcept;
+
 protected:
 
-    explicit MeshAttributeBuffer(MeshAttribute attrib);
+    MeshAttributeBuffer(MeshAttribute attrib, MeshAttributeComponentType componentType, int numComponents, size_t elementSize, ElementTypeId elementType);
 
     void* _data;
 
     MeshAttribute _attrib;
 
+    bool _dirty;
+
+    uint64_t _revision;
+
+    MeshAttributeComponentType _componentType;
+
+    int _numComponents;
+
+    size_t _elementSize;
+
+    ElementTypeId _elementType;
+
 private:
 
     virtual void resize(size_t numElements) = 0;
 
 };
 
-inline MeshAttributeBuffer::MeshAttributeBuffer(MeshAttribute attrib) :
-        _attrib(attrib) {
+inline MeshAttributeBuffer::MeshAttributeBuffer(MeshAttribute attrib, MeshAttributeComponentType componentType, int numComponents,
+        size_t elementSize, ElementTypeId elementType) :
+        _attrib(attrib),
+        _dirty(true),
+        _revision(0),
+        _componentType(componentType),
+        _numComponents(numComponents),
+        _elementSize(elementSize),
+        _elementType(elementType) {
 }
 
 inline const void* MeshAttributeBuffer::data() const {
@@ -60,15 +103,17 @@ inline const void* MeshAttributeBuffer::data() const {
 }
 
 inline void* MeshAttributeBuffer::data() {
+    markDirty();
     return _data;
 }
 
 inline const void* MeshAttributeBuffer::elementPtr(size_t i) const {
-    return (unsigned char*) _data + i * elementSize();
+    return (unsigned char*) _data + i * _elementSize;
 }
 
 inline void* MeshAttributeBuffer::elementPtr(size_t i) {
-    return (unsigned char*) _data + i * elementSize();
+    markDirty();
+    return (unsigned char*) _data + i * _elementSize;
 }
 
 inline constexpr size_t componentSize(MeshAttributeComponentType type) {
@@ -79,18 +124,98 @@ inline constexpr size_t componentSize(MeshAttributeComponentType type) {
         return sizeof(int32_t);
     case MeshAttributeComponentType::UINT:
         return sizeof(uint32_t);
+    case MeshAttributeComponentType::HALF:
+    case MeshAttributeComponentType::SNORM16:
+    case MeshAttributeComponentType::UNORM16:
+        return sizeof(uint16_t);
+    case MeshAttributeComponentType::SNORM8:
+    case MeshAttributeComponentType::UNORM8:
+        return sizeof(uint8_t);
     }
     return 0;
 }
 
+inline MeshAttributeComponentType MeshAttributeBuffer::componentType() const noexcept {
+    return _componentType;
+}
+
+inline int MeshAttributeBuffer::numComponents() const noexcept {
+    return _numComponents;
+}
+
 inline size_t MeshAttributeBuffer::elementSize() const noexcept {
-    return componentSize(componentType()) * numComponents();
+    return _elementSize;
+}
+
+inline ElementTypeId MeshAttributeBuffer::elementType() const noexcept {
+    return _elementType;
+}
+
+template<typename T>
+inline bool MeshAttributeBuffer::hasElementType() const noexcept {
+    return _elementType == elementTypeId<T>();
 }
 
 inline MeshAttribute MeshAttributeBuffer::getAttribute() const noexcept {
     return _attrib;
 }
 
+inline bool MeshAttributeBuffer::isDirty() const noexcept {
+    return _dirty;
+}
+
+inline void MeshAttributeBuffer::markDirty() noexcept {
+    _dirty = true;
+    ++_revision;
+}
+
+inline void MeshAttributeBuffer::markClean() noexcept {
+    _dirty = false;
+}
+
+inline uint64_t MeshAttributeBuffer::revision() const noexcept {
+    return _revision;
+}
+
+// Destroys a buffer Mesh allocated from a memory resource, and returns its memory to the resource
+
+class MeshAttributeBufferDeleter {
+
+public:
+
+    MeshAttributeBufferDeleter() noexcept;
+
+    MeshAttributeBufferDeleter(std::pmr::memory_resource* resource, size_t size, size_t alignment) noexcept;
+
+    void operator()(MeshAttributeBuffer* buffer) const noexcept;
+
+private:
+
+    std::pmr::memory_resource* _resource;
+
+    size_t _size, _alignment;
+
+};
+
+using MeshAttributeBufferPtr = std::unique_ptr<MeshAttributeBuffer, MeshAttributeBufferDeleter>;
+
+inline MeshAttributeBufferDeleter::MeshAttributeBufferDeleter() noexcept :
+        _resource(nullptr),
+        _size(0),
+        _alignment(0) {
+}
+
+inline MeshAttributeBufferDeleter::MeshAttributeBufferDeleter(std::pmr::memory_resource* resource, size_t size, size_t alignment) noexcept :
+        _resource(resource),
+        _size(size),
+        _alignment(alignment) {
+}
+
+inline void MeshAttributeBufferDeleter::operator()(MeshAttributeBuffer* buffer) const noexcept {
+    buffer->~MeshAttributeBuffer();
+    _resource->deallocate(buffer, _size, _alignment);
+}
+
 // Templated child class for buffers of various element types
 
 template<typename T>
@@ -100,20 +225,23 @@ public:
 
     friend class Mesh;
 
-    using value_type = T;
-
-    using iterator = typename std::vector<T>::iterator;
-    using const_iterator = typename std::vector<T>::const_iterator;
-
-    // used to know how to interpret underlying data in vertex buffers
+    static_assert(sizeof(T) == componentSize(ComponentTypeHelper<T>::componentType) * ComponentTypeHelper<T>::numComponents,
+        "Mesh attribute element types must not be padded.");
 
-    MeshAttributeComponentType componentType() const noexcept override;
+    using value_type = T;
 
-    int numComponents() const noexcept override;
+    using iterator = T*;
+    using const_iterator = const T*;
 
     // const access to underlying vector
+    // only valid for buffers that own their storage, see ownsStorage()
     
-    const std::vector<T>& elements() const noexcept;
+    const std::pmr::vector<T>& elements() const;
+
+    size_t size() const noexcept;
+
+    // false if the buffer references external storage, e.g. a mapped file
+    bool ownsStorage() const noexcept;
 
     // iterator access for range-for and STL algorithm compatibility
 
@@ -154,11 +282,22 @@ public:
 
 private:
 
-    explicit TypedMeshAttributeBuffer(MeshAttribute attrib, size_t numElements);
+    // elements are allocated from resource
+    TypedMeshAttributeBuffer(MeshAttribute attrib, size_t numElements, std::pmr::memory_resource* resource);
+
+    // reference numElements elements at externalData without copying
+    // storageOwner is held to keep the external storage alive
+    // resource is only used once the buffer is resized and copies its elements
+    TypedMeshAttributeBuffer(MeshAttribute attrib, size_t numElements, T* externalData, std::shared_ptr<const void> storageOwner,
+        std::pmr::memory_resource* resource);
 
     void resize(size_t numElements) override;
 
-    std::vector<T> _elements;
+    std::pmr::vector<T> _elements;
+
+    size_t _numElements;
+
+    std::shared_ptr<const void> _storageOwner;
 
 };
 
@@ -167,100 +306,119 @@ private:
 // Constructors
 
 template<typename T>
-TypedMeshAttributeBuffer<T>::TypedMeshAttributeBuffer(MeshAttribute attrib, size_t numElements) :
-        MeshAttributeBuffer(attrib),
-        _elements(numElements) {
+TypedMeshAttributeBuffer<T>::TypedMeshAttributeBuffer(MeshAttribute attrib, size_t numElements, std::pmr::memory_resource* resource) :
+        MeshAttributeBuffer(attrib, ComponentTypeHelper<T>::componentType, ComponentTypeHelper<T>::numComponents, sizeof(T), elementTypeId<T>()),
+        _elements(numElements, std::pmr::polymorphic_allocator<T>(resource)),
+        _numElements(numElements) {
     _data = _elements.data();
 }
 
-// Overriden functions
-
 template<typename T>
-inline MeshAttributeComponentType TypedMeshAttributeBuffer<T>::componentType() const noexcept {
-    return ComponentTypeHelper<T>::componentType;
-}
-
-template<typename T>
-inline int TypedMeshAttributeBuffer<T>::numComponents() const noexcept {
-    return ComponentTypeHelper<T>::numComponents;
+TypedMeshAttributeBuffer<T>::TypedMeshAttributeBuffer(MeshAttribute attrib, size_t numElements, T* externalData, std::shared_ptr<const void> storageOwner,
+        std::pmr::memory_resource* resource) :
+        MeshAttributeBuffer(attrib, ComponentTypeHelper<T>::componentType, ComponentTypeHelper<T>::numComponents, sizeof(T), elementTypeId<T>()),
+        _elements(resource),
+        _numElements(numElements),
+        _storageOwner(std::move(storageOwner)) {
+    _data = externalData;
 }
 
 // Iterator access
 
 template<typename T>
 inline typename TypedMeshAttributeBuffer<T>::iterator TypedMeshAttributeBuffer<T>::begin() noexcept {
-    return _elements.begin();
+    markDirty();
+    return static_cast<T*>(_data);
 }
 
 template<typename T>
 inline typename TypedMeshAttributeBuffer<T>::const_iterator TypedMeshAttributeBuffer<T>::begin() const noexcept {
-    return _elements.begin();
+    return static_cast<const T*>(_data);
 }
 
 template<typename T>
 inline typename TypedMeshAttributeBuffer<T>::iterator TypedMeshAttributeBuffer<T>::end() noexcept {
-    return _elements.end();
+    return begin() + _numElements;
 }
 
 template<typename T>
 inline typename TypedMeshAttributeBuffer<T>::const_iterator TypedMeshAttributeBuffer<T>::end() const noexcept {
-    return _elements.end();
+    return begin() + _numElements;
 }
 
 template<typename T>
 inline typename TypedMeshAttributeBuffer<T>::const_iterator TypedMeshAttributeBuffer<T>::cbegin() const noexcept {
-    return _elements.cbegin();
+    return begin();
 }
 
 template<typename T>
 inline typename TypedMeshAttributeBuffer<T>::const_iterator TypedMeshAttributeBuffer<T>::cend() const noexcept {
-    return _elements.cend();
+    return end();
 }
 
 // operator[]
 
 template<typename T>
 inline T& TypedMeshAttributeBuffer<T>::operator[](size_t i) noexcept {
-    return _elements[i];
+    markDirty();
+    return static_cast<T*>(_data)[i];
 }
 
 
 template<typename T>
 inline const T& TypedMeshAttributeBuffer<T>::operator[](size_t i) const noexcept {
-    return _elements[i];
+    return static_cast<const T*>(_data)[i];
 }
 
 // Other methods
 
 template<typename T>
-inline const std::vector<T>& TypedMeshAttributeBuffer<T>::elements() const noexcept {
+inline const std::pmr::vector<T>& TypedMeshAttributeBuffer<T>::elements() const {
+    if (!ownsStorage()) throw std::logic_error("Buffer does not own its storage.");
     return _elements;
 }
 
+template<typename T>
+inline size_t TypedMeshAttributeBuffer<T>::size() const noexcept {
+    return _numElements;
+}
+
+template<typename T>
+inline bool TypedMeshAttributeBuffer<T>::ownsStorage() const noexcept {
+    return _data == _elements.data();
+}
+
 template<typename T>
 inline void TypedMeshAttributeBuffer<T>::resize(size_t numElements) {
+    if (!ownsStorage()) {
+        // detach from external storage, keeping whatever elements still fit
+        _elements.assign(begin(), begin() + std::min(numElements, _numElements));
+        _storageOwner.reset();
+    }
     _elements.resize(numElements);
+    _numElements = numElements;
     _data = _elements.data();
+    markDirty();
 }
 
 template<typename T>
 template<typename ... Assign>
 inline std::enable_if_t<std::is_constructible_v<T, Assign...>>
 TypedMeshAttributeBuffer<T>::assign(Assign... val) noexcept {
-    _elements.assign(_elements.size(), value_type(val...));
+    std::fill(begin(), end(), value_type(val...));
 }
 
 template<typename T>
 void TypedMeshAttributeBuffer<T>::assign(const std::initializer_list<T>& il) {
-    if (il.size() != _elements.size()) throw std::invalid_argument("Initializer list size not equal to buffer size.");
-    _elements.assign(il);
+    if (il.size() != _numElements) throw std::invalid_argument("Initializer list size not equal to buffer size.");
+    std::copy(il.begin(), il.end(), begin());
 }
 
 template<typename T>
 template<typename Assign>
 std::enable_if_t<std::is_constructible_v<T, Assign>>
 TypedMeshAttributeBuffer<T>::assign(const std::initializer_list<Assign>& il) {
-    if (il.size() != _elements.size()) throw std::invalid_argument("Initializer list size not equal to buffer size.");
+    if (il.size() != _numElements) throw std::invalid_argument("Initializer list size not equal to buffer size.");
     // _elements.assign(il);
-    std::transform(il.begin(), il.end(), _elements.begin(), [] (const auto& av) { return value_type(av); });
+    std::transform(il.begin(), il.end(), begin(), [] (const auto& av) { return value_type(av); });
 }
@@ -1,177 +1,375 @@
-#pragma once
-
-#include <iostream>
-#include <tuple>
-
-#include <vvm/string.hpp>
-
-#include "attribute_buffer.hpp"
-
-
-
-template<typename ... Buffers>
-class MeshAttributeView {
-
-public:
-
-    class iterator;
-
-    MeshAttributeView(Buffers& ... buffers);
-
-    iterator begin();
-
-    iterator end();
-
-private:
-
-    std::tuple<Buffers& ...> _buffers;
-
-};
-
-namespace detail {
-
-template<typename T1, typename T2, typename Enable = void>
-struct conditional_const;
-
-template<typename T1, typename T2>
-struct conditional_const<T1, T2, typename std::enable_if_t<!std::is_const_v<T1>>> {
-    using type = std::remove_const_t<T2>;
-};
-
-template<typename T1, typename T2>
-struct conditional_const<T1, T2, typename std::enable_if_t<std::is_const_v<T1>>> {
-    using type = std::add_const_t<T2>;
-};
-
-template<typename T1, typename T2>
-using conditional_const_t = typename conditional_const<T1, T2>::type;
-
-}
-
-template<typename ... Buffers>
-class MeshAttributeView<Buffers...>::iterator {
-public:
-    class pointer_t;
-
-    // this could be implemented as a random access iterator, since it's just using an index into buffers
-    // but forward iterator is really all we need for the use case of just iterating the vertices, which is why this header exists
-    using iterator_category = std::forward_iterator_tag;
-    using difference_type = std::ptrdiff_t;
-    // conditional_const uses add_const/remove_const, which in turn means don't pass the reference type as T2, because
-    // reference to const is not actually a const type, instead pass the base type and put the reference outside
-    using value_type = std::tuple<detail::conditional_const_t<Buffers, typename Buffers::value_type>&...>;
-    using pointer = pointer_t;
-    using reference = value_type;
-
-    iterator(uint32_t index, Buffers& ... buffers);
-
-    reference operator*();
-
-    pointer operator->();
-
-    iterator& operator++();
-
-    iterator operator++(int);
-
-    bool operator==(const iterator& other) const;
-
-    bool operator!=(const iterator& other) const;
-
-private:
-    uint32_t _index;
-    const std::tuple<Buffers& ...>  _buffers;
-};
-
-// wrapper around a value, so we don't take a pointer to an rvalue
-template<typename ... Buffers>
-class MeshAttributeView<Buffers...>::iterator::pointer_t {
-public:
-    pointer_t(value_type&& v) :
-        _value(std::move(v)) {
-    }
-
-    pointer_t(const pointer_t&) = delete;
-
-    pointer_t(pointer_t&&) = default;
-
-    pointer_t& operator=(const pointer_t&) = delete;
-
-    pointer_t& operator=(pointer_t&&) = default;
-
-    value_type* operator->() {
-        return std::addressof(_value);
-    }
-
-    value_type& operator*() {
-        return *operator->();
-    }
-
-private:
-    value_type _value;
-};
-
-template<typename ... Buffers>
-MeshAttributeView<Buffers...>::MeshAttributeView(Buffers& ... buffers) :
-        _buffers(buffers...) {
-}
-
-template<typename ... Buffers>
-typename MeshAttributeView<Buffers...>::iterator MeshAttributeView<Buffers...>::begin() {
-    return std::apply([] (auto& ... args) { return iterator(0, args...); }, _buffers);
-}
-
-template<typename ... Buffers>
-typename MeshAttributeView<Buffers...>::iterator MeshAttributeView<Buffers...>::end() {
-    auto num = std::get<0>(_buffers).elements().size();
-    return std::apply([n = num] (auto& ... args) { return iterator(n, args...); }, _buffers);
-}
-
-template<typename ... Buffers>
-MeshAttributeView<Buffers...>::iterator::iterator(uint32_t index, Buffers& ... buffers) :
-        _index(index),
-        _buffers(buffers...) {
-}
-
-template<typename ... Buffers>
-typename MeshAttributeView<Buffers...>::iterator::reference MeshAttributeView<Buffers...>::iterator::operator*() {
-    return std::apply([i = _index] (auto& ... args) { return std::forward_as_tuple(args[i]...); }, _buffers);
-}
-
-template<typename ... Buffers>
-typename MeshAttributeView<Buffers...>::iterator::pointer MeshAttributeView<Buffers...>::iterator::operator->() {
-    return pointer_t(operator*());
-}
-
-template<typename ... Buffers>
-typename MeshAttributeView<Buffers...>::iterator& MeshAttributeView<Buffers...>::iterator::operator++() {
-    ++_index;
-    return *this;
-}
-
-template<typename ... Buffers>
-typename MeshAttributeView<Buffers...>::iterator MeshAttributeView<Buffers...>::iterator::operator++(int) {
-    iterator temp = *this;
-    operator++();
-    return temp;
-}
-
-template<typename ... Buffers>
-bool MeshAttributeView<Buffers...>::iterator::operator==(const iterator &other) const {
-    auto to_ptrs = [] (const auto& t) {
-        return std::apply([] (auto&... args) { return std::make_tuple((&args)...); }, t);
-    };
-    auto cmp_ptrs = [] (const auto& t1, const auto& t2) {
-        return std::apply([&t2] (const auto& ... args1) {
-            return std::apply([&args1...] (const auto& ... args2) {
-                return ((args1 == args2) && ...);
-            }, t2);
-        }, t1);
-    };
-    
-    return _index == other._index && cmp_ptrs(to_ptrs(_buffers), to_ptrs(other._buffers));
-}
-
-template<typename ... Buffers>
-bool MeshAttributeView<Buffers...>::iterator::operator!=(const iterator &other) const {
-    return !operator==(other);
-}
\ No newline at end of file
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <vvm/string.hpp>
+
+#include "attribute_buffer.hpp"
+#include "../parallel_for.hpp"
+
+
+namespace detail {
+
+template<typename T1, typename T2, typename Enable = void>
+struct conditional_const;
+
+template<typename T1, typename T2>
+struct conditional_const<T1, T2, typename std::enable_if_t<!std::is_const_v<T1>>> {
+    using type = std::remove_const_t<T2>;
+};
+
+template<typename T1, typename T2>
+struct conditional_const<T1, T2, typename std::enable_if_t<std::is_const_v<T1>>> {
+    using type = std::add_const_t<T2>;
+};
+
+template<typename T1, typename T2>
+using conditional_const_t = typename conditional_const<T1, T2>::type;
+
+}
+
+// A zip view over the elements of several attribute buffers of one mesh, e.g. positions and normals
+// The view holds a raw pointer into each buffer, so iterating it is just pointer increments, and the buffers must not be
+// resized while the view is in use
+// Besides random access iteration, the view can be walked in fixed size chunks, where each attribute of a chunk is a
+// contiguous array (structure of arrays), and split over threads with parallelFor
+template<typename ... Buffers>
+class MeshAttributeView {
+
+public:
+
+    class iterator;
+
+    // the element type of each buffer, const if the buffer is
+    template<typename Buffer>
+    using element_t = detail::conditional_const_t<Buffer, typename Buffer::value_type>;
+
+    // default number of vertices handed to each thread by the parallel methods
+    static constexpr size_t DEFAULT_MIN_RANGE_SIZE = 4096;
+
+    MeshAttributeView(Buffers& ... buffers);
+
+    iterator begin() const;
+
+    iterator end() const;
+
+    size_t size() const noexcept;
+
+    // tuple of references to the elements of vertex i
+    std::tuple<element_t<Buffers>&...> operator[](size_t i) const;
+
+    // call f(elements...) with references to the elements of every vertex
+    template<typename F>
+    void forEach(F&& f) const;
+
+    // call f(count, data...) for consecutive chunks of vertices, with a pointer to the first element of the chunk in each buffer
+    // count is std::integral_constant<size_t, N> for every full chunk, so loops over it have a constant trip count and vectorize,
+    // and a size_t for the remaining vertices at the end, if there are any
+    template<size_t N, typename F>
+    void forEachChunk(F&& f) const;
+
+    // forEach, with the vertices split into ranges on separate threads
+    // f is called concurrently and must only write to the elements it is given
+    template<typename F>
+    void parallelForEach(F&& f, size_t minRangeSize = DEFAULT_MIN_RANGE_SIZE, unsigned numThreads = 0) const;
+
+    // forEachChunk, with the chunks split into ranges on separate threads
+    // ranges are whole chunks, only the last range can end with a partial chunk
+    template<size_t N, typename F>
+    void parallelForEachChunk(F&& f, size_t minRangeSize = DEFAULT_MIN_RANGE_SIZE, unsigned numThreads = 0) const;
+
+private:
+
+    using pointers_t = std::tuple<element_t<Buffers>*...>;
+
+    // call f(count, data...) for the chunks in [begin, end), begin is a multiple of N
+    template<size_t N, typename F>
+    void forEachChunk(size_t begin, size_t end, F& f) const;
+
+    pointers_t _data;
+
+    size_t _size;
+
+};
+
+// random access iterator, dereferencing to a tuple of references
+// iterators of one view advance together, so comparing them only compares the first pointer
+// it works with std::for_each and friends, including the parallel execution policies, but since elements are tuples of
+// references, algorithms that swap whole elements like std::sort don't compile
+template<typename ... Buffers>
+class MeshAttributeView<Buffers...>::iterator {
+public:
+    class pointer_t;
+
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    // conditional_const uses add_const/remove_const, which in turn means don't pass the reference type as T2, because
+    // reference to const is not actually a const type, instead pass the base type and put the reference outside
+    using value_type = std::tuple<element_t<Buffers>&...>;
+    using pointer = pointer_t;
+    using reference = value_type;
+
+    iterator() = default;
+
+    iterator(const pointers_t& data, size_t index);
+
+    reference operator*() const;
+
+    pointer operator->() const;
+
+    reference operator[](difference_type n) const;
+
+    iterator& operator++();
+
+    iterator operator++(int);
+
+    iterator& operator--();
+
+    iterator operator--(int);
+
+    iterator& operator+=(difference_type n);
+
+    iterator& operator-=(difference_type n);
+
+    iterator operator+(difference_type n) const;
+
+    iterator operator-(difference_type n) const;
+
+    difference_type operator-(const iterator& other) const;
+
+    friend iterator operator+(difference_type n, const iterator& it) {
+        return it + n;
+    }
+
+    bool operator==(const iterator& other) const;
+
+    bool operator!=(const iterator& other) const;
+
+    bool operator<(const iterator& other) const;
+
+    bool operator>(const iterator& other) const;
+
+    bool operator<=(const iterator& other) const;
+
+    bool operator>=(const iterator& other) const;
+
+private:
+    pointers_t _data;
+};
+
+// wrapper around a value, so we don't take a pointer to an rvalue
+template<typename ... Buffers>
+class MeshAttributeView<Buffers...>::iterator::pointer_t {
+public:
+    pointer_t(value_type&& v) :
+        _value(std::move(v)) {
+    }
+
+    pointer_t(const pointer_t&) = delete;
+
+    pointer_t(pointer_t&&) = default;
+
+    pointer_t& operator=(const pointer_t&) = delete;
+
+    pointer_t& operator=(pointer_t&&) = default;
+
+    value_type* operator->() {
+        return std::addressof(_value);
+    }
+
+    value_type& operator*() {
+        return *operator->();
+    }
+
+private:
+    value_type _value;
+};
+
+// View implementation
+
+template<typename ... Buffers>
+MeshAttributeView<Buffers...>::MeshAttributeView(Buffers& ... buffers) :
+        _data(buffers.begin()...),
+        _size(std::get<0>(std::forward_as_tuple(buffers...)).size()) {
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator MeshAttributeView<Buffers...>::begin() const {
+    return iterator(_data, 0);
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator MeshAttributeView<Buffers...>::end() const {
+    return iterator(_data, _size);
+}
+
+template<typename ... Buffers>
+size_t MeshAttributeView<Buffers...>::size() const noexcept {
+    return _size;
+}
+
+template<typename ... Buffers>
+std::tuple<typename MeshAttributeView<Buffers...>::template element_t<Buffers>&...> MeshAttributeView<Buffers...>::operator[](size_t i) const {
+    return std::apply([i] (auto* ... data) { return std::forward_as_tuple(data[i]...); }, _data);
+}
+
+template<typename ... Buffers>
+template<typename F>
+void MeshAttributeView<Buffers...>::forEach(F&& f) const {
+    std::apply([&] (auto* ... data) {
+        for (size_t i = 0; i < _size; ++i) {
+            f(data[i]...);
+        }
+    }, _data);
+}
+
+template<typename ... Buffers>
+template<size_t N, typename F>
+void MeshAttributeView<Buffers...>::forEachChunk(size_t begin, size_t end, F& f) const {
+    static_assert(N > 0, "Chunk size must not be zero.");
+    std::apply([&] (auto* ... data) {
+        size_t i = begin;
+        for (; i + N <= end; i += N) {
+            f(std::integral_constant<size_t, N>(), (data + i)...);
+        }
+        if (i < end) {
+            f(end - i, (data + i)...);
+        }
+    }, _data);
+}
+
+template<typename ... Buffers>
+template<size_t N, typename F>
+void MeshAttributeView<Buffers...>::forEachChunk(F&& f) const {
+    forEachChunk<N>(0, _size, f);
+}
+
+template<typename ... Buffers>
+template<typename F>
+void MeshAttributeView<Buffers...>::parallelForEach(F&& f, size_t minRangeSize, unsigned numThreads) const {
+    parallelFor(_size, minRangeSize, [&] (size_t begin, size_t end) {
+        std::apply([&] (auto* ... data) {
+            for (size_t i = begin; i < end; ++i) {
+                f(data[i]...);
+            }
+        }, _data);
+    }, numThreads);
+}
+
+template<typename ... Buffers>
+template<size_t N, typename F>
+void MeshAttributeView<Buffers...>::parallelForEachChunk(F&& f, size_t minRangeSize, unsigned numThreads) const {
+    const size_t numChunks = (_size + N - 1) / N;
+    parallelFor(numChunks, std::max<size_t>(1, minRangeSize / N), [&] (size_t begin, size_t end) {
+        forEachChunk<N>(begin * N, std::min(end * N, _size), f);
+    }, numThreads);
+}
+
+// Iterator implementation
+
+template<typename ... Buffers>
+MeshAttributeView<Buffers...>::iterator::iterator(const pointers_t& data, size_t index) :
+        _data(std::apply([index] (auto* ... ptrs) { return pointers_t((ptrs + index)...); }, data)) {
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator::reference MeshAttributeView<Buffers...>::iterator::operator*() const {
+    return std::apply([] (auto* ... ptrs) { return std::forward_as_tuple(*ptrs...); }, _data);
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator::pointer MeshAttributeView<Buffers...>::iterator::operator->() const {
+    return pointer_t(operator*());
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator::reference MeshAttributeView<Buffers...>::iterator::operator[](difference_type n) const {
+    return std::apply([n] (auto* ... ptrs) { return std::forward_as_tuple(ptrs[n]...); }, _data);
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator& MeshAttributeView<Buffers...>::iterator::operator+=(difference_type n) {
+    std::apply([n] (auto*& ... ptrs) { ((ptrs += n), ...); }, _data);
+    return *this;
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator& MeshAttributeView<Buffers...>::iterator::operator-=(difference_type n) {
+    return operator+=(-n);
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator& MeshAttributeView<Buffers...>::iterator::operator++() {
+    return operator+=(1);
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator MeshAttributeView<Buffers...>::iterator::operator++(int) {
+    iterator temp = *this;
+    operator++();
+    return temp;
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator& MeshAttributeView<Buffers...>::iterator::operator--() {
+    return operator+=(-1);
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator MeshAttributeView<Buffers...>::iterator::operator--(int) {
+    iterator temp = *this;
+    operator--();
+    return temp;
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator MeshAttributeView<Buffers...>::iterator::operator+(difference_type n) const {
+    iterator temp = *this;
+    return temp += n;
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator MeshAttributeView<Buffers...>::iterator::operator-(difference_type n) const {
+    iterator temp = *this;
+    return temp -= n;
+}
+
+template<typename ... Buffers>
+typename MeshAttributeView<Buffers...>::iterator::difference_type MeshAttributeView<Buffers...>::iterator::operator-(const iterator& other) const {
+    return std::get<0>(_data) - std::get<0>(other._data);
+}
+
+template<typename ... Buffers>
+bool MeshAttributeView<Buffers...>::iterator::operator==(const iterator& other) const {
+    return std::get<0>(_data) == std::get<0>(other._data);
+}
+
+template<typename ... Buffers>
+bool MeshAttributeView<Buffers...>::iterator::operator!=(const iterator& other) const {
+    return !operator==(other);
+}
+
+template<typename ... Buffers>
+bool MeshAttributeView<Buffers...>::iterator::operator<(const iterator& other) const {
+    return std::get<0>(_data) < std::get<0>(other._data);
+}
+
+template<typename ... Buffers>
+bool MeshAttributeView<Buffers...>::iterator::operator>(const iterator& other) const {
+    return other < *this;
+}
+
+template<typename ... Buffers>
+bool MeshAttributeView<Buffers...>::iterator::operator<=(const iterator& other) const {
+    return !(other < *this);
+}
+
+template<typename ... Buffers>
+bool MeshAttributeView<Buffers...>::iterator::operator>=(const iterator& other) const {
+    return !(*this < other);
+}
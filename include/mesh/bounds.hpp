@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#include "vector_math.hpp"
+#include "vector_batch.hpp"
+
+
+// Bounding volumes of the positions of a mesh
+// the sphere is centered on the box, which is not the smallest sphere but is cheap and stable under small edits
+
+struct MeshBounds {
+    vec3 min;
+    vec3 max;
+    vec3 center;
+    float radius;
+};
+
+// bounds of count positions, all zero if count is zero
+// the radius is rounded up, so every position is inside the sphere despite float rounding
+inline MeshBounds computeBounds(const vec3* positions, size_t count) {
+    MeshBounds bounds { vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.0f), 0.0f };
+    if (count == 0) {
+        return bounds;
+    }
+    batch::minMax(positions, count, bounds.min, bounds.max);
+    bounds.center = (bounds.min + bounds.max) * 0.5f;
+    bounds.radius = std::nextafter(std::sqrt(batch::maxDistanceSquared(positions, count, bounds.center)), std::numeric_limits<float>::infinity());
+    return bounds;
+}
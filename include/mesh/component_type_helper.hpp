@@ -1,47 +1,168 @@
-#pragma once
-
-#include "vector_math.hpp"
-
-#include "mesh/attribute.hpp"
-
-
-// Helper type for TypedMeshAttributeBuffer to get its component info
-
-template<typename TT>
-struct ComponentTypeHelper;
-
-template<>
-struct ComponentTypeHelper<float> {
-    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::FLOAT;
-    static constexpr int numComponents = 1;
-};
-
-template<>
-struct ComponentTypeHelper<int> {
-    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::INT;
-    static constexpr int numComponents = 1;
-};
-
-template<>
-struct ComponentTypeHelper<unsigned int> {
-    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::UINT;
-    static constexpr int numComponents = 1;
-};
-
-template<int D>
-struct ComponentTypeHelper<vecmath::vector<float, D>> {
-    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::FLOAT;
-    static constexpr int numComponents = D;
-};
-
-template<int D>
-struct ComponentTypeHelper<vecmath::vector<int, D>> {
-    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::INT;
-    static constexpr int numComponents = D;
-};
-
-template<int D>
-struct ComponentTypeHelper<vecmath::vector<unsigned int, D>> {
-    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::UINT;
-    static constexpr int numComponents = D;
-};
\ No newline at end of file
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include "vector_math.hpp"
+
+#include "mesh/attribute.hpp"
+#include "mesh/packed_types.hpp"
+
+
+// Helper type for TypedMeshAttributeBuffer to get its component info
+
+template<typename TT>
+struct ComponentTypeHelper;
+
+template<>
+struct ComponentTypeHelper<float> {
+    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::FLOAT;
+    static constexpr int numComponents = 1;
+};
+
+template<>
+struct ComponentTypeHelper<int> {
+    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::INT;
+    static constexpr int numComponents = 1;
+};
+
+template<>
+struct ComponentTypeHelper<unsigned int> {
+    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::UINT;
+    static constexpr int numComponents = 1;
+};
+
+template<int D>
+struct ComponentTypeHelper<vecmath::vector<float, D>> {
+    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::FLOAT;
+    static constexpr int numComponents = D;
+};
+
+template<int D>
+struct ComponentTypeHelper<vecmath::vector<int, D>> {
+    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::INT;
+    static constexpr int numComponents = D;
+};
+
+template<int D>
+struct ComponentTypeHelper<vecmath::vector<unsigned int, D>> {
+    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::UINT;
+    static constexpr int numComponents = D;
+};
+
+// Unique id of an element type
+// buffers store the id of their element type, so typed access is a comparison instead of a dynamic_cast
+
+using ElementTypeId = const void*;
+
+template<typename T>
+struct ElementTypeIdHelper {
+    static constexpr char id = 0;
+};
+
+template<typename T>
+inline constexpr ElementTypeId elementTypeId() noexcept {
+    return &ElementTypeIdHelper<T>::id;
+}
+
+// Quantized types
+
+#define MAKE_PACKED_COMPONENT_TYPE_HELPER(T, TYPE) \
+template<> \
+struct ComponentTypeHelper<T> { \
+    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::TYPE; \
+    static constexpr int numComponents = 1; \
+}; \
+template<int D> \
+struct ComponentTypeHelper<PackedVector<T, D>> { \
+    static constexpr MeshAttributeComponentType componentType = MeshAttributeComponentType::TYPE; \
+    static constexpr int numComponents = D; \
+}
+
+MAKE_PACKED_COMPONENT_TYPE_HELPER(Half, HALF);
+MAKE_PACKED_COMPONENT_TYPE_HELPER(Snorm8, SNORM8);
+MAKE_PACKED_COMPONENT_TYPE_HELPER(Unorm8, UNORM8);
+MAKE_PACKED_COMPONENT_TYPE_HELPER(Snorm16, SNORM16);
+MAKE_PACKED_COMPONENT_TYPE_HELPER(Unorm16, UNORM16);
+
+#undef MAKE_PACKED_COMPONENT_TYPE_HELPER
+
+// Inverse mapping, from component type and count to the element type used by TypedMeshAttributeBuffer
+
+template<typename C, int D>
+struct ElementTypeHelper {
+    using type = vecmath::vector<C, D>;
+};
+
+template<typename C>
+struct ElementTypeHelper<C, 1> {
+    using type = C;
+};
+
+#define MAKE_PACKED_ELEMENT_TYPE_HELPER(T) \
+template<int D> \
+struct ElementTypeHelper<T, D> { \
+    using type = PackedVector<T, D>; \
+}; \
+template<> \
+struct ElementTypeHelper<T, 1> { \
+    using type = T; \
+}
+
+MAKE_PACKED_ELEMENT_TYPE_HELPER(Half);
+MAKE_PACKED_ELEMENT_TYPE_HELPER(Snorm8);
+MAKE_PACKED_ELEMENT_TYPE_HELPER(Unorm8);
+MAKE_PACKED_ELEMENT_TYPE_HELPER(Snorm16);
+MAKE_PACKED_ELEMENT_TYPE_HELPER(Unorm16);
+
+#undef MAKE_PACKED_ELEMENT_TYPE_HELPER
+
+template<typename T>
+struct ElementTypeTag {
+    using type = T;
+};
+
+namespace detail {
+
+template<typename C, typename F>
+inline decltype(auto) dispatchComponentCount(int numComponents, F&& f) {
+    switch (numComponents) {
+    case 1:
+        return f(ElementTypeTag<typename ElementTypeHelper<C, 1>::type>());
+    case 2:
+        return f(ElementTypeTag<typename ElementTypeHelper<C, 2>::type>());
+    case 3:
+        return f(ElementTypeTag<typename ElementTypeHelper<C, 3>::type>());
+    case 4:
+        return f(ElementTypeTag<typename ElementTypeHelper<C, 4>::type>());
+    default:
+        throw std::invalid_argument("Mesh attribute component count must be 1-4, given: " + std::to_string(numComponents));
+    }
+}
+
+}
+
+// call f with an ElementTypeTag<T>, where T is the element type for the given component type and count
+template<typename F>
+inline decltype(auto) dispatchElementType(MeshAttributeComponentType componentType, int numComponents, F&& f) {
+    switch (componentType) {
+    case MeshAttributeComponentType::FLOAT:
+        return detail::dispatchComponentCount<float>(numComponents, f);
+    case MeshAttributeComponentType::INT:
+        return detail::dispatchComponentCount<int>(numComponents, f);
+    case MeshAttributeComponentType::UINT:
+        return detail::dispatchComponentCount<unsigned int>(numComponents, f);
+    case MeshAttributeComponentType::HALF:
+        return detail::dispatchComponentCount<Half>(numComponents, f);
+    case MeshAttributeComponentType::SNORM8:
+        return detail::dispatchComponentCount<Snorm8>(numComponents, f);
+    case MeshAttributeComponentType::UNORM8:
+        return detail::dispatchComponentCount<Unorm8>(numComponents, f);
+    case MeshAttributeComponentType::SNORM16:
+        return detail::dispatchComponentCount<Snorm16>(numComponents, f);
+    case MeshAttributeComponentType::UNORM16:
+        return detail::dispatchComponentCount<Unorm16>(numComponents, f);
+    default:
+        throw std::invalid_argument("Unknown attribute component type: " + std::to_string(static_cast<int>(componentType)));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <stdexcept>
+#include <vector>
+
+
+// Width of the indices stored in a mesh index buffer
+// the values are the index sizes in bytes
+
+enum class MeshIndexType : uint8_t {
+    UINT16 = 2,
+    UINT32 = 4
+};
+
+inline constexpr size_t indexSize(MeshIndexType type) {
+    return static_cast<size_t>(type);
+}
+
+// the narrowest index type that can address every vertex of a mesh with numVertices vertices
+inline constexpr MeshIndexType minimumIndexType(size_t numVertices) {
+    return numVertices <= size_t(std::numeric_limits<uint16_t>::max()) + 1 ? MeshIndexType::UINT16 : MeshIndexType::UINT32;
+}
+
+// Index storage with a per-mesh index width
+//
+// Indices are read and written as uint32_t regardless of the storage width.
+// Writing an index too large for 16-bit storage widens the buffer to 32 bits, so callers never lose data.
+// For bulk work, visit() calls a function with a pointer to the typed storage instead.
+// Indices are allocated from the memory resource given on construction.
+
+class MeshIndexBuffer {
+
+public:
+
+    using value_type = uint32_t;
+
+    class const_iterator;
+
+    explicit MeshIndexBuffer(MeshIndexType indexType = MeshIndexType::UINT32,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    MeshIndexType indexType() const noexcept;
+
+    size_t indexSize() const noexcept;
+
+    // convert the stored indices to another width
+    // throws std::out_of_range if an index does not fit in the new width
+    void setIndexType(MeshIndexType indexType);
+
+    // convert to the narrowest width that holds every stored index
+    void narrow();
+
+    size_t size() const noexcept;
+
+    bool empty() const noexcept;
+
+    // size of the stored indices in bytes
+    size_t sizeBytes() const noexcept;
+
+    const void* data() const noexcept;
+
+    void* data() noexcept;
+
+    uint32_t operator[](size_t i) const;
+
+    void set(size_t i, uint32_t index);
+
+    void push_back(uint32_t index);
+
+    void resize(size_t numIndices);
+
+    void reserve(size_t numIndices);
+
+    void clear() noexcept;
+
+    template<typename InputIt>
+    void assign(InputIt first, InputIt last);
+
+    void assign(std::initializer_list<uint32_t> indices);
+
+    // call f with a uint16_t* or uint32_t* to the stored indices, depending on the index type
+    template<typename F>
+    decltype(auto) visit(F&& f);
+
+    template<typename F>
+    decltype(auto) visit(F&& f) const;
+
+    const_iterator begin() const noexcept;
+
+    const_iterator end() const noexcept;
+
+    // compares index values, not storage width
+    friend bool operator==(const MeshIndexBuffer& a, const MeshIndexBuffer& b);
+
+    friend bool operator!=(const MeshIndexBuffer& a, const MeshIndexBuffer& b);
+
+    // true if the indices or their width may have changed since the last markClean()
+    // any non-const access to the indices marks the buffer dirty, new buffers start out dirty
+    bool isDirty() const noexcept;
+
+    void markDirty() noexcept;
+
+    void markClean() noexcept;
+
+private:
+
+    MeshIndexType _indexType;
+
+    // only the vector matching _indexType is in use
+    std::pmr::vector<uint16_t> _indices16;
+    std::pmr::vector<uint32_t> _indices32;
+
+    bool _dirty;
+
+};
+
+// Iterator reading indices as uint32_t
+
+class MeshIndexBuffer::const_iterator {
+
+public:
+
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = uint32_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = uint32_t;
+
+    const_iterator() = default;
+
+    const_iterator(const MeshIndexBuffer* buffer, size_t i) : _buffer(buffer), _i(i) {}
+
+    uint32_t operator*() const { return (*_buffer)[_i]; }
+
+    uint32_t operator[](difference_type n) const { return (*_buffer)[_i + n]; }
+
+    const_iterator& operator++() { ++_i; return *this; }
+    const_iterator operator++(int) { const_iterator it = *this; ++_i; return it; }
+    const_iterator& operator--() { --_i; return *this; }
+    const_iterator operator--(int) { const_iterator it = *this; --_i; return it; }
+
+    const_iterator& operator+=(difference_type n) { _i += n; return *this; }
+    const_iterator& operator-=(difference_type n) { _i -= n; return *this; }
+
+    friend const_iterator operator+(const_iterator it, difference_type n) { return it += n; }
+    friend const_iterator operator+(difference_type n, const_iterator it) { return it += n; }
+    friend const_iterator operator-(const_iterator it, difference_type n) { return it -= n; }
+
+    friend difference_type operator-(const const_iterator& a, const const_iterator& b) {
+        return static_cast<difference_type>(a._i) - static_cast<difference_type>(b._i);
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._i == b._i; }
+    friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._i != b._i; }
+    friend bool operator<(const const_iterator& a, const const_iterator& b) { return a._i < b._i; }
+    friend bool operator>(const const_iterator& a, const const_iterator& b) { return a._i > b._i; }
+    friend bool operator<=(const const_iterator& a, const const_iterator& b) { return a._i <= b._i; }
+    friend bool operator>=(const const_iterator& a, const const_iterator& b) { return a._i >= b._i; }
+
+private:
+
+    const MeshIndexBuffer* _buffer = nullptr;
+
+    size_t _i = 0;
+
+};
+
+// Inline implementation
+
+inline MeshIndexBuffer::MeshIndexBuffer(MeshIndexType indexType, std::pmr::memory_resource* resource) :
+        _indexType(indexType),
+        _indices16(resource),
+        _indices32(resource),
+        _dirty(true) {
+    if (indexType != MeshIndexType::UINT16 && indexType != MeshIndexType::UINT32) {
+        throw std::invalid_argument("Invalid mesh index type.");
+    }
+}
+
+inline MeshIndexType MeshIndexBuffer::indexType() const noexcept {
+    return _indexType;
+}
+
+inline size_t MeshIndexBuffer::indexSize() const noexcept {
+    return ::indexSize(_indexType);
+}
+
+inline void MeshIndexBuffer::setIndexType(MeshIndexType indexType) {
+    if (indexType == _indexType) {
+        return;
+    }
+    if (indexType == MeshIndexType::UINT32) {
+        _indices32.assign(_indices16.begin(), _indices16.end());
+        _indices16.clear();
+        _indices16.shrink_to_fit();
+    } else if (indexType == MeshIndexType::UINT16) {
+        if (std::any_of(_indices32.begin(), _indices32.end(), [] (uint32_t index) { return index > std::numeric_limits<uint16_t>::max(); })) {
+            throw std::out_of_range("Mesh indices do not fit in 16 bits.");
+        }
+        _indices16.resize(_indices32.size());
+        std::transform(_indices32.begin(), _indices32.end(), _indices16.begin(), [] (uint32_t index) { return static_cast<uint16_t>(index); });
+        _indices32.clear();
+        _indices32.shrink_to_fit();
+    } else {
+        throw std::invalid_argument("Invalid mesh index type.");
+    }
+    _indexType = indexType;
+    _dirty = true;
+}
+
+inline void MeshIndexBuffer::narrow() {
+    if (_indexType == MeshIndexType::UINT32) {
+        uint32_t maxIndex = _indices32.empty() ? 0 : *std::max_element(_indices32.begin(), _indices32.end());
+        setIndexType(minimumIndexType(size_t(maxIndex) + 1));
+    }
+}
+
+inline size_t MeshIndexBuffer::size() const noexcept {
+    return _indexType == MeshIndexType::UINT16 ? _indices16.size() : _indices32.size();
+}
+
+inline bool MeshIndexBuffer::empty() const noexcept {
+    return size() == 0;
+}
+
+inline size_t MeshIndexBuffer::sizeBytes() const noexcept {
+    return size() * indexSize();
+}
+
+inline const void* MeshIndexBuffer::data() const noexcept {
+    return _indexType == MeshIndexType::UINT16 ? static_cast<const void*>(_indices16.data()) : _indices32.data();
+}
+
+inline void* MeshIndexBuffer::data() noexcept {
+    _dirty = true;
+    return _indexType == MeshIndexType::UINT16 ? static_cast<void*>(_indices16.data()) : _indices32.data();
+}
+
+inline uint32_t MeshIndexBuffer::operator[](size_t i) const {
+    return _indexType == MeshIndexType::UINT16 ? _indices16[i] : _indices32[i];
+}
+
+inline void MeshIndexBuffer::set(size_t i, uint32_t index) {
+    _dirty = true;
+    if (_indexType == MeshIndexType::UINT16 && index > std::numeric_limits<uint16_t>::max()) {
+        setIndexType(MeshIndexType::UINT32);
+    }
+    if (_indexType == MeshIndexType::UINT16) {
+        _indices16[i] = static_cast<uint16_t>(index);
+    } else {
+        _indices32[i] = index;
+    }
+}
+
+inline void MeshIndexBuffer::push_back(uint32_t index) {
+    _dirty = true;
+    if (_indexType == MeshIndexType::UINT16 && index > std::numeric_limits<uint16_t>::max()) {
+        setIndexType(MeshIndexType::UINT32);
+    }
+    if (_indexType == MeshIndexType::UINT16) {
+        _indices16.push_back(static_cast<uint16_t>(index));
+    } else {
+        _indices32.push_back(index);
+    }
+}
+
+inline void MeshIndexBuffer::resize(size_t numIndices) {
+    _dirty = true;
+    if (_indexType == MeshIndexType::UINT16) {
+        _indices16.resize(numIndices);
+    } else {
+        _indices32.resize(numIndices);
+    }
+}
+
+inline void MeshIndexBuffer::reserve(size_t numIndices) {
+    if (_indexType == MeshIndexType::UINT16) {
+        _indices16.reserve(numIndices);
+    } else {
+        _indices32.reserve(numIndices);
+    }
+}
+
+inline void MeshIndexBuffer::clear() noexcept {
+    _dirty = true;
+    _indices16.clear();
+    _indices32.clear();
+}
+
+template<typename InputIt>
+inline void MeshIndexBuffer::assign(InputIt first, InputIt last) {
+    clear();
+    for (; first != last; ++first) {
+        push_back(static_cast<uint32_t>(*first));
+    }
+}
+
+inline void MeshIndexBuffer::assign(std::initializer_list<uint32_t> indices) {
+    assign(indices.begin(), indices.end());
+}
+
+template<typename F>
+inline decltype(auto) MeshIndexBuffer::visit(F&& f) {
+    _dirty = true;
+    if (_indexType == MeshIndexType::UINT16) {
+        return f(_indices16.data());
+    }
+    return f(_indices32.data());
+}
+
+template<typename F>
+inline decltype(auto) MeshIndexBuffer::visit(F&& f) const {
+    if (_indexType == MeshIndexType::UINT16) {
+        return f(static_cast<const uint16_t*>(_indices16.data()));
+    }
+    return f(static_cast<const uint32_t*>(_indices32.data()));
+}
+
+inline MeshIndexBuffer::const_iterator MeshIndexBuffer::begin() const noexcept {
+    return const_iterator(this, 0);
+}
+
+inline MeshIndexBuffer::const_iterator MeshIndexBuffer::end() const noexcept {
+    return const_iterator(this, size());
+}
+
+inline bool operator==(const MeshIndexBuffer& a, const MeshIndexBuffer& b) {
+    if (a._indexType == b._indexType) {
+        return a._indexType == MeshIndexType::UINT16 ? a._indices16 == b._indices16 : a._indices32 == b._indices32;
+    }
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+inline bool operator!=(const MeshIndexBuffer& a, const MeshIndexBuffer& b) {
+    return !(a == b);
+}
+
+inline bool MeshIndexBuffer::isDirty() const noexcept {
+    return _dirty;
+}
+
+inline void MeshIndexBuffer::markDirty() noexcept {
+    _dirty = true;
+}
+
+inline void MeshIndexBuffer::markClean() noexcept {
+    _dirty = false;
+}
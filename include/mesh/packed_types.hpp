@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Storage types for quantized attribute components
+// These only hold the encoded bits, to convert to and from floats use the kernels in mesh_quantization.hpp
+
+struct Half {
+    uint16_t bits;
+};
+
+struct Snorm8 {
+    int8_t value;
+};
+
+struct Unorm8 {
+    uint8_t value;
+};
+
+struct Snorm16 {
+    int16_t value;
+};
+
+struct Unorm16 {
+    uint16_t value;
+};
+
+// tightly packed vector of D quantized components
+// vecmath vectors are meant for arithmetic, which these types don't support
+template<typename T, int D>
+struct PackedVector {
+    T components[D];
+
+    T& operator[](int i) noexcept { return components[i]; }
+
+    const T& operator[](int i) const noexcept { return components[i]; }
+};
+
+static_assert(sizeof(PackedVector<Half, 3>) == 3 * sizeof(uint16_t), "Packed vectors must not be padded.");
+static_assert(sizeof(PackedVector<Unorm8, 3>) == 3 * sizeof(uint8_t), "Packed vectors must not be padded.");
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mesh.hpp"
+
+
+struct MeshFileLayout;
+
+
+// Reads a raw mesh file a chunk of vertices or indices at a time, for meshes too large to fit in memory
+//
+// Each vertex chunk is a small Mesh holding the selected attributes of consecutive vertices,
+// so it can be viewed and processed like any other mesh, and written out again with MeshChunkWriter.
+// Memory use is bounded by the chunk size, whatever the size of the file.
+// Compressed files can't be read in chunks, since each of their streams only decodes as a whole.
+
+class MeshChunkReader {
+
+public:
+
+    // throws std::runtime_error if the file is compressed
+    explicit MeshChunkReader(const std::string& fileName);
+
+    ~MeshChunkReader();
+
+    size_t numVertices() const noexcept;
+
+    size_t numIndices() const noexcept;
+
+    // the index type stored in the file
+    MeshIndexType indexType() const noexcept;
+
+    // every attribute stored in the file
+    const std::vector<MeshAttributeLayout>& attributes() const noexcept;
+
+    // restrict the attributes read into vertex chunks, every attribute is read by default
+    // attributes missing from the file are ignored
+    void selectAttributes(const std::set<MeshAttribute>& attributes);
+
+    // replace the contents of chunk with the selected attributes of the next maxVertices vertices at most
+    // returns false, leaving chunk without vertices, once every vertex has been read
+    // pass the same chunk to every call so its buffers are reused
+    bool readVertices(Mesh& chunk, size_t maxVertices);
+
+    // file index of the first vertex of the last vertex chunk
+    size_t vertexOffset() const noexcept;
+
+    // replace the contents of chunk with the next maxIndices indices at most, in the file's index type
+    // returns false, leaving chunk empty, once every index has been read
+    bool readIndices(MeshIndexBuffer& chunk, size_t maxIndices);
+
+    // position of the first index of the last index chunk
+    size_t indexOffset() const noexcept;
+
+    // read vertices and indices from the beginning again
+    void rewind() noexcept;
+
+private:
+
+    // selected attributes that share a range of the file, e.g. interleaved ones, are read together
+    struct ReadGroup {
+        uint64_t offset;  // of the first element of the group's first attribute
+        uint64_t stride;
+        uint64_t span;    // bytes of each vertex covered by the group's attributes
+        std::vector<size_t> attributes;
+    };
+
+    void prepareChunk(Mesh& chunk) const;
+
+    std::ifstream _fs;
+
+    std::unique_ptr<MeshFileLayout> _layout;
+
+    std::vector<MeshAttributeLayout> _attributes;
+
+    std::vector<ReadGroup> _groups;
+
+    size_t _nextVertex, _vertexOffset;
+
+    size_t _nextIndex, _indexOffset;
+
+    // holds the file range of interleaved groups, reused between chunks
+    std::vector<char> _staging;
+
+};
+
+
+// Writes a raw, non-interleaved mesh file a chunk of vertices or indices at a time
+//
+// The vertex and index counts are fixed up front, so the whole layout of the file is known
+// and every chunk is written straight to its place. Vertices and indices can be written in any interleaving,
+// but each in order.
+
+class MeshChunkWriter {
+
+public:
+
+    MeshChunkWriter(const std::string& fileName, const std::vector<MeshAttributeLayout>& attributes,
+        size_t numVertices, size_t numIndices, MeshIndexType indexType);
+
+    // append the vertices of chunk, which needs a buffer of the file's type for each of the file's attributes
+    // throws std::invalid_argument if it hasn't, or if it holds more vertices than are left to write
+    void writeVertices(const Mesh& chunk);
+
+    // append indices, converted to the file's index type
+    // throws std::out_of_range if an index doesn't fit the file's index type,
+    // or std::invalid_argument if chunk holds more indices than are left to write
+    void writeIndices(const MeshIndexBuffer& chunk);
+
+    // throws std::runtime_error if fewer vertices or indices were written than the file was created with
+    void finish();
+
+private:
+
+    std::ofstream _fs;
+
+    std::vector<MeshAttributeLayout> _attributes;
+
+    std::vector<uint64_t> _sectionOffsets;
+
+    uint64_t _indexSectionOffset;
+
+    size_t _numVertices, _nextVertex;
+
+    size_t _numIndices, _nextIndex;
+
+    MeshIndexType _indexType;
+
+    MeshIndexBuffer _converted;
+
+};
+
+inline size_t MeshChunkReader::vertexOffset() const noexcept {
+    return _vertexOffset;
+}
+
+inline size_t MeshChunkReader::indexOffset() const noexcept {
+    return _indexOffset;
+}
+
+inline const std::vector<MeshAttributeLayout>& MeshChunkReader::attributes() const noexcept {
+    return _attributes;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Lossless compression for mesh vertex and index streams, with no external dependencies
+//
+// Attribute streams are split into byte planes (every first byte of each component, then every second byte...)
+// which groups the slowly varying sign/exponent bytes of neighbouring values together,
+// then compressed with a small LZ77 block codec in the style of LZ4, chosen for decoding speed.
+// Index streams are delta coded, zig-zag mapped and stored as variable length integers before the LZ pass,
+// since neighbouring triangles mostly reference nearby vertices.
+//
+// The codec keeps scratch memory between calls, so reuse one instance for many streams.
+
+class MeshStreamCodec {
+
+public:
+
+    // encode numBytes of attribute data made up of componentSize byte components, appending to out
+    void encodeAttributeStream(const void* data, size_t numBytes, size_t componentSize, std::vector<char>& out);
+
+    // decode an attribute stream into exactly numBytes at data
+    // throws std::runtime_error if the encoded data is malformed
+    void decodeAttributeStream(const char* encoded, size_t encodedSize, void* data, size_t numBytes, size_t componentSize);
+
+    void encodeIndexStream(const uint16_t* indices, size_t numIndices, std::vector<char>& out);
+
+    void encodeIndexStream(const uint32_t* indices, size_t numIndices, std::vector<char>& out);
+
+    // throws std::runtime_error if the encoded data is malformed, or holds indices too large for the output type
+    void decodeIndexStream(const char* encoded, size_t encodedSize, uint16_t* indices, size_t numIndices);
+
+    void decodeIndexStream(const char* encoded, size_t encodedSize, uint32_t* indices, size_t numIndices);
+
+private:
+
+    std::vector<char> _scratch;
+
+    std::vector<uint32_t> _hashTable;
+
+};
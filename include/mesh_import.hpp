@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+#include "mesh.hpp"
+
+
+// Importers for Wavefront OBJ and Stanford PLY files
+//
+// Files are memory mapped and parsed in parallel, each thread taking a range of whole lines
+// (or of fixed-size records in binary PLY files), so parsing throughput scales with the number of cores.
+// Every triangle corner becomes a vertex of position, normal, texture coordinate and color,
+// as far as the file has them, and corners with equal values are welded into one vertex with a hash table.
+// The welded vertices keep the order in which they are first used by the faces.
+//
+// Polygons are triangulated as fans. Lines, points, groups, materials and other unsupported
+// elements are ignored. Vertices no face uses are dropped, except in files without any faces,
+// e.g. point cloud scans, which import every vertex in file order and no indices.
+// All attributes are imported as floats, colors are scaled to [0, 1].
+//
+// numThreads = 0 uses one thread per hardware thread.
+// Malformed files throw std::runtime_error.
+
+// OBJ files may carry vertex colors as three extra components of "v" lines
+Mesh importObjMesh(const std::string& fileName, unsigned numThreads = 0);
+
+// ascii and binary PLY files, with vertex properties named x y z, nx ny nz, u v (or s t, texture_u texture_v)
+// and red green blue alpha, and faces in a vertex_indices (or vertex_index) list
+Mesh importPlyMesh(const std::string& fileName, unsigned numThreads = 0);
+
+// picks the importer by the file's extension, .obj or .ply
+// throws std::invalid_argument for other extensions
+Mesh importMesh(const std::string& fileName, unsigned numThreads = 0);
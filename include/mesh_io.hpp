@@ -1,41 +1,162 @@
-#pragma once
-
-#include <fstream>
-#include <string>
-
-#include "mesh.hpp"
-
-
-class MeshWriter {
-
-public:
-
-    enum class AttributeWriteScheme {
-        INTERLEAVED,     // faster to read directly into vertex buffers
-        NON_INTERLEAVED  // faster to read into mesh objects
-    };
-
-    explicit MeshWriter(const std::string& fileName);
-
-    void writeMesh(const Mesh& mesh, AttributeWriteScheme scheme = AttributeWriteScheme::INTERLEAVED);
-
-private:
-
-    std::ofstream _fs;
-
-};
-
-
-class MeshReader {
-
-public:
-
-    explicit MeshReader(const std::string& fileName);
-
-    Mesh readMesh();
-
-private:
-
-    std::ifstream _fs;
-
-};
\ No newline at end of file
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <set>
+#include <string>
+
+#include "mesh.hpp"
+
+
+class MappedFile;
+
+// receives the number of vertex and index buffer bytes processed so far, and the total
+using MeshIOProgressCallback = std::function<void(size_t bytesProcessed, size_t totalBytes)>;
+
+class MeshWriter {
+
+public:
+
+    enum class AttributeWriteScheme {
+        INTERLEAVED,     // faster to read directly into vertex buffers
+        NON_INTERLEAVED  // faster to read into mesh objects
+    };
+
+    enum class Encoding {
+        RAW,        // buffers written as they are in memory
+        COMPRESSED  // smaller files, see MeshStreamCodec. attributes are always written non-interleaved
+    };
+
+    using ProgressCallback = MeshIOProgressCallback;
+
+    explicit MeshWriter(const std::string& fileName);
+
+    // optional, called at most once per interval while writing, and once when the mesh is done
+    void setProgressCallback(ProgressCallback callback, std::chrono::milliseconds interval = std::chrono::milliseconds(250));
+
+    void setEncoding(Encoding encoding) noexcept;
+
+    void writeMesh(const Mesh& mesh, AttributeWriteScheme scheme = AttributeWriteScheme::INTERLEAVED);
+
+private:
+
+    std::ofstream _fs;
+
+    Encoding _encoding;
+
+    ProgressCallback _progressCallback;
+
+    std::chrono::milliseconds _progressInterval;
+
+    // staging block for interleaving vertices, reused between meshes
+    std::vector<char> _block;
+
+};
+
+
+class MeshReader {
+
+public:
+
+    using ProgressCallback = MeshIOProgressCallback;
+
+    explicit MeshReader(const std::string& fileName);
+
+    // read a mesh from the current position of an already open stream
+    // the stream must outlive the reader
+    explicit MeshReader(std::istream& stream);
+
+    // optional, called at most once per interval while reading, and once when the mesh is done
+    // an exception thrown from the callback aborts the read and propagates out of readMesh()
+    void setProgressCallback(ProgressCallback callback, std::chrono::milliseconds interval = std::chrono::milliseconds(250));
+
+    // meshes read afterwards allocate all of their storage from resource, see Mesh(size_t, std::pmr::memory_resource*)
+    void setMemoryResource(std::pmr::memory_resource* resource) noexcept;
+
+    Mesh readMesh();
+
+    // read only the buffers of the given attributes, attributes missing from the file are ignored
+    // sections of unselected attributes in compressed or non-interleaved files are seeked past, not read
+    Mesh readMesh(const std::set<MeshAttribute>& attributes);
+
+private:
+
+    Mesh readSelectedAttributes(const std::set<MeshAttribute>* attributes);
+
+    // empty for streams
+    std::string _fileName;
+
+    std::ifstream _file;
+
+    std::istream& _fs;
+
+    ProgressCallback _progressCallback;
+
+    std::chrono::milliseconds _progressInterval;
+
+    std::pmr::memory_resource* _memoryResource;
+
+};
+
+
+// Reads a mesh through a memory mapping of the file
+// Compressed files are decoded straight from the mapping into the attribute buffers.
+// Attributes stored contiguously (AttributeWriteScheme::NON_INTERLEAVED) are not copied,
+// their buffers reference the mapping directly and keep it alive.
+// Edits to those buffers are private to the mesh and are never written back to the file.
+// Interleaved attributes and the index buffer are still copied out of the mapping.
+
+class MappedMeshReader {
+
+public:
+
+    explicit MappedMeshReader(const std::string& fileName);
+
+    // meshes read afterwards allocate all of their storage from resource, see Mesh(size_t, std::pmr::memory_resource*)
+    // buffers mapped in place still reference the mapping
+    void setMemoryResource(std::pmr::memory_resource* resource) noexcept;
+
+    Mesh readMesh();
+
+private:
+
+    std::string _fileName;
+
+    std::shared_ptr<MappedFile> _file;
+
+    std::pmr::memory_resource* _memoryResource;
+
+};
+
+// How saveMesh() brought a file up to date
+enum class MeshSaveResult {
+    UNCHANGED,  // nothing was dirty, the file was not touched
+    PATCHED,    // only the dirty sections were overwritten in place
+    REWRITTEN   // the whole file was written again
+};
+
+// Save mesh over fileName, writing only the sections of dirty buffers where possible
+//
+// The dirty flags describe the changes since the mesh was read from or last saved to mesh.fileName(),
+// so sections are only reused if fileName is that same file, and every other file is always rewritten in full.
+// If the file is raw and still has the mesh's attributes, types, vertex count, index count and index type,
+// the dirty attribute sections and index section are patched in place, in whatever layout the file already has.
+// Patches are written to fileName.patch first and only then applied to the file, so one that is interrupted
+// is either finished or discarded by recoverMeshFile, and never leaves a half patched file behind.
+// Otherwise the mesh is written to fileName.tmp with scheme and encoding, which is then renamed over fileName,
+// so a failed rewrite never leaves a partial file behind.
+// The journal, the patched file and the new file are synced to disk before each next step, so this also holds
+// across a power loss, as long as the disk honors the sync.
+// Every buffer is marked clean and mesh.fileName() set to fileName after a successful save.
+MeshSaveResult saveMesh(const std::string& fileName, Mesh& mesh,
+    MeshWriter::AttributeWriteScheme scheme = MeshWriter::AttributeWriteScheme::INTERLEAVED,
+    MeshWriter::Encoding encoding = MeshWriter::Encoding::RAW);
+
+// finish a patch of fileName by saveMesh that was interrupted after its journal was complete, or discard one that wasn't
+// a journal locked by a save still in progress, in this process or another, is left to that save
+// the readers of mesh files by name and saveMesh call this first, other code reading the file directly should too
+// returns true if an interrupted patch was finished
+bool recoverMeshFile(const std::string& fileName);
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mesh.hpp"
+
+
+// Thrown from MeshLoader::Handle::get() when the load was cancelled
+
+class MeshLoadCancelled : public std::runtime_error {
+
+public:
+
+    explicit MeshLoadCancelled(const std::string& fileName);
+
+};
+
+
+// Decodes mesh files on a pool of worker threads
+// Only file IO and decoding happens on the workers, uploading the resulting
+// meshes (e.g. with MeshVertexBufferWriter) is left to the thread owning the GL context.
+// Each worker decodes its mesh on its own thread, the parallel parts of a read run inline (see ParallelWorkerScope).
+
+class MeshLoader {
+
+private:
+
+    struct LoadState {
+        std::atomic<size_t> bytesRead { 0 };
+        std::atomic<size_t> totalBytes { 0 };
+        std::atomic<bool> cancelRequested { false };
+    };
+
+public:
+
+    class Handle {
+
+    public:
+
+        friend class MeshLoader;
+
+        Handle() = default;
+
+        // true once get() will return without blocking
+        bool ready() const;
+
+        // fraction of the file decoded so far, in [0, 1]
+        float progress() const noexcept;
+
+        // request cancellation, get() will throw MeshLoadCancelled unless the load already finished
+        void cancel() noexcept;
+
+        // wait for the load to finish and take the mesh, can only be called once
+        // rethrows any exception from the load
+        Mesh get();
+
+        bool valid() const noexcept;
+
+    private:
+
+        Handle(std::shared_ptr<LoadState> state, std::future<Mesh>&& future);
+
+        std::shared_ptr<LoadState> _state;
+
+        std::future<Mesh> _future;
+
+    };
+
+    // numThreads = 0 uses one thread per hardware thread
+    explicit MeshLoader(unsigned int numThreads = 0);
+
+    // cancels loads that haven't started, waits for running ones
+    ~MeshLoader();
+
+    MeshLoader(const MeshLoader&) = delete;
+    MeshLoader(MeshLoader&&) = delete;
+
+    MeshLoader& operator=(const MeshLoader&) = delete;
+    MeshLoader& operator=(MeshLoader&&) = delete;
+
+    Handle load(const std::string& fileName);
+
+    unsigned int numThreads() const noexcept;
+
+private:
+
+    struct Job {
+        std::string fileName;
+        std::shared_ptr<LoadState> state;
+        std::promise<Mesh> promise;
+    };
+
+    void workerMain();
+
+    static void runJob(Job& job);
+
+    std::vector<std::thread> _workers;
+
+    std::deque<Job> _jobs;
+
+    std::mutex _mutex;
+
+    std::condition_variable _condition;
+
+    bool _stopping;
+
+};
+
+inline unsigned int MeshLoader::numThreads() const noexcept {
+    return _workers.size();
+}
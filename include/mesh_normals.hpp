@@ -0,0 +1,31 @@
+#pragma once
+
+#include "mesh.hpp"
+
+
+// Generation of vertex normals and tangents from the triangles of a mesh
+//
+// Both read vec3 POSITION buffers and the triangle list in indices(), or consecutive vertices taken three at a time
+// if the mesh has no indices. Results go into a vec3 NORMAL or vec4 TANGENT buffer, which is created if the mesh
+// has none and replaced if it has one of a different type. Calls that throw leave the mesh as it was.
+// Work is split across threads by vertex: a vertex-to-triangle adjacency is built first, then each thread sums the
+// triangles around its own vertices, so there are no atomics or shared partial sums.
+// numThreads = 0 uses one thread per hardware thread.
+
+enum class NormalWeighting {
+    AREA,   // each triangle counts in proportion to its area
+    ANGLE   // each triangle counts in proportion to its angle at the vertex, independent of tessellation
+};
+
+// normalized sums of the triangle normals around each vertex
+// vertices not used by any triangle, or only by degenerate ones, get a zero normal
+void generateNormals(Mesh& mesh, NormalWeighting weighting = NormalWeighting::ANGLE, unsigned numThreads = 0);
+
+// tangents following the MikkTSpace conventions, from POSITION, vec2 TEXCOORD and vec3 NORMAL
+// throws std::invalid_argument if the mesh is missing any of them, e.g. call generateNormals first
+// per triangle tangents are projected onto the vertex normal's plane, normalized and weighted by angle,
+// w is the bitangent sign, so bitangent = w * cross(normal, tangent.xyz)
+// unlike MikkTSpace, vertices are never split, so a vertex shared by triangles with mirrored texture coordinates
+// gets the sign of the larger share
+// vertices without usable texture coordinates get an arbitrary tangent perpendicular to the normal
+void generateTangents(Mesh& mesh, unsigned numThreads = 0);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+
+#include "mesh.hpp"
+
+
+// Reordering of triangles and vertices for faster drawing, without changing what is drawn
+//
+// The passes are meant to run in order: optimizeVertexCache, then optionally optimizeOverdraw, then optimizeVertexFetch.
+// Each reads the triangle list in indices(), meshes without indices are left as they are.
+// Triangles keep their winding, only the order they are drawn in changes.
+// simulateVertexCache measures the effect on the CPU, e.g. before and after optimizing.
+// Every function taking a cacheSize throws std::invalid_argument if it's less than 3.
+
+// the number of vertices the optimizations assume the post-transform cache holds
+// the results are close to the best for any real cache of around this size
+inline constexpr unsigned DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+// reorder the triangles so consecutive triangles share vertices, with Tipsify (Sander, Nehab and Barczak 2007)
+// runs in time linear in the number of triangles
+// throws std::invalid_argument if the indices are not a triangle list or reference vertices the mesh doesn't have
+void optimizeVertexCache(Mesh& mesh, unsigned cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+
+// reorder clusters of triangles so those facing away from the center of the mesh are drawn first,
+// and hide more of what is drawn after them from the depth test
+// clusters are the runs where the cache starts over, split further where that costs little,
+// so the vertex cache efficiency of optimizeVertexCache is kept within threshold, e.g. 1.05 gives up at most about 5%
+// needs a vec3 POSITION buffer, throws std::invalid_argument if the mesh has none or threshold is less than 1
+void optimizeOverdraw(Mesh& mesh, float threshold = 1.05f, unsigned cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+
+// reorder the vertices of every attribute buffer in the order the triangles first use them, and remap the indices
+// and those of the levels of detail, so the vertex fetch reads memory mostly in order
+// vertices no triangle uses are kept, after the others
+void optimizeVertexFetch(Mesh& mesh);
+
+// vertex cache efficiency of drawing the triangles of a mesh, on a FIFO cache of cacheSize vertices
+struct VertexCacheStats {
+    size_t numTriangles;
+    size_t numTransforms;  // cache misses, each a run of the vertex shader
+    double acmr;           // average cache miss ratio, transforms per triangle: 3 at worst, around 0.5 at best for large meshes
+    double atvr;           // average transform to vertex ratio, transforms per vertex used by the triangles: 1 at best
+};
+
+// meshes without indices draw their vertices in order, so every vertex is a miss
+VertexCacheStats simulateVertexCache(const Mesh& mesh, unsigned cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
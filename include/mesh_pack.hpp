@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mesh.hpp"
+
+
+// Mesh packs store many mesh files in one file, behind a table of contents
+// giving the name, location and attribute layout of each mesh.
+// See mesh_file_format.txt for the layout.
+
+
+class MeshPackWriter {
+
+public:
+
+    explicit MeshPackWriter(const std::string& fileName);
+
+    // queue an existing mesh file to be stored in the pack under the given name
+    void addMeshFile(const std::string& name, const std::string& meshFileName);
+
+    // write the table of contents, then the contents of every queued mesh file
+    void write();
+
+private:
+
+    std::ofstream _fs;
+
+    std::vector<std::pair<std::string, std::string>> _meshFiles;
+
+};
+
+
+class MeshPackReader {
+
+public:
+
+    struct Entry {
+        std::string name;
+        uint64_t offset, size;             // location in bytes of the embedded mesh file
+        uint64_t vertexCount, indexCount;
+        std::vector<MeshAttributeLayout> attributes;
+    };
+
+    // reads only the table of contents, meshes are read on demand
+    explicit MeshPackReader(const std::string& fileName);
+
+    const std::vector<Entry>& entries() const noexcept;
+
+    // nullptr if there's no mesh with this name
+    const Entry* findEntry(const std::string& name) const;
+
+    Mesh readMesh(const std::string& name);
+
+    Mesh readMesh(const Entry& entry);
+
+private:
+
+    std::ifstream _fs;
+
+    std::vector<Entry> _entries;
+
+    std::unordered_map<std::string, size_t> _entryIndices;
+
+};
+
+inline const std::vector<MeshPackReader::Entry>& MeshPackReader::entries() const noexcept {
+    return _entries;
+}
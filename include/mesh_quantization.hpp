@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+
+#include "mesh.hpp"
+
+
+// Conversion between float components and the packed component types
+//
+// Normalized types map [-1, 1] (snorm) or [0, 1] (unorm) onto the full integer range, the same way
+// the GPU converts them back when the vertex attribute is set up as normalized.
+// Values outside of the range are clamped, rounding is to nearest.
+// Half conversion is IEEE 754 binary16, round to nearest even, with infinities and NaNs preserved.
+//
+// The kernels use SSE2 (and F16C for halfs when the cpu supports it) or NEON where available,
+// with scalar fallbacks that produce the same results.
+
+void encodeHalf(const float* src, Half* dst, size_t count);
+void decodeHalf(const Half* src, float* dst, size_t count);
+
+void encodeSnorm8(const float* src, Snorm8* dst, size_t count);
+void decodeSnorm8(const Snorm8* src, float* dst, size_t count);
+
+void encodeUnorm8(const float* src, Unorm8* dst, size_t count);
+void decodeUnorm8(const Unorm8* src, float* dst, size_t count);
+
+void encodeSnorm16(const float* src, Snorm16* dst, size_t count);
+void decodeSnorm16(const Snorm16* src, float* dst, size_t count);
+
+void encodeUnorm16(const float* src, Unorm16* dst, size_t count);
+void decodeUnorm16(const Unorm16* src, float* dst, size_t count);
+
+// Octahedral normals
+//
+// Unit vectors are projected onto the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper one,
+// so the x and y of the projection fully describe the vector in two normalized components.
+// Vectors are read and written as 3 floats, the encoded forms are 2 components each, count is the number of vectors.
+// Vectors don't need to be unit length, a zero vector encodes as (0, 0, 1). Decoded vectors are normalized.
+
+void encodeOctahedralSnorm8(const float* src, Snorm8* dst, size_t count);
+void decodeOctahedralSnorm8(const Snorm8* src, float* dst, size_t count);
+
+void encodeOctahedralSnorm16(const float* src, Snorm16* dst, size_t count);
+void decodeOctahedralSnorm16(const Snorm16* src, float* dst, size_t count);
+
+// encode count float components into components of the given type at dst
+// throws std::invalid_argument for INT and UINT, which are not conversions of floats
+void encodeComponents(const float* src, void* dst, MeshAttributeComponentType componentType, size_t count);
+
+// decode count components of the given type at src into floats
+void decodeComponents(const void* src, MeshAttributeComponentType componentType, float* dst, size_t count);
+
+// replace a float attribute buffer of mesh with an encoded buffer of the given component type
+// the number of components and the buffer index are kept
+void quantizeAttribute(Mesh& mesh, MeshAttribute attribute, MeshAttributeComponentType componentType);
+
+// replace a quantized attribute buffer of mesh with a float buffer
+void dequantizeAttribute(Mesh& mesh, MeshAttribute attribute);
+
+// replace the vec3 float NORMAL buffer of mesh with octahedral normals of 2 SNORM8 or SNORM16 components
+// shaders reading the buffer have to unfold the normals themselves, see decodeOctahedralSnorm16
+// throws std::invalid_argument for other buffers or component types
+void encodeOctahedralNormals(Mesh& mesh, MeshAttributeComponentType componentType = MeshAttributeComponentType::SNORM16);
+
+// replace octahedral normals encoded by encodeOctahedralNormals with a vec3 float NORMAL buffer
+void decodeOctahedralNormals(Mesh& mesh);
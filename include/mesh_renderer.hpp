@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #include <vector>
@@ -21,6 +22,9 @@ struct RenderMeshMapping {
 
 };
 
+// size in bytes of one vertex in the layout of mapping, its attributes packed back to back in order
+size_t mappingVertexSize(const RenderMeshMapping& mapping);
+
 
 struct VertexBufferLayout {
     uint32_t vertexSize;
@@ -35,6 +39,7 @@ public:
         uintptr_t vboOffset, iboOffset;      // the offset in bytes into the vbo/ibo buffers
         size_t vboSize, iboSize;             // the size in bytes of the data in the vbo/ibo buffers
         uint32_t vertexOffset, indexOffset;  // the offset in elements of the first vertex/index represented by this block
+        MeshIndexType indexType;             // the width of the indices in this block, blocks of either width share the ibo
     };
 
     MeshRenderer(const RenderMeshMapping& mapping, size_t vboSize, size_t iboSize);
@@ -43,7 +48,12 @@ public:
 
     // const VertexBufferLayout& getVertexBufferLayout() const;
 
-    Block allocateMeshBlock(size_t numVertices, size_t numIndices);
+    // indices in a block are relative to the block's first vertex, they are drawn with vertexOffset as the base vertex
+    // so 16-bit indices work no matter where the block ends up in the vbo
+    Block allocateMeshBlock(size_t numVertices, size_t numIndices, MeshIndexType indexType = MeshIndexType::UINT32);
+
+    // draw the triangles of a block, the vertex array must be bound
+    void drawBlock(const Block& block) const;
 
     ogu::buffer& getVertexBuffer();
     ogu::buffer& getIndexBuffer();
@@ -65,7 +75,7 @@ private:
 
     std::vector<Block> _freeBlocks;
 
-    size_t _vertexSize, _indexSize;
+    size_t _vertexSize;
 
 };
 
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+
+#include "mesh.hpp"
+
+
+// Simplification of triangle meshes by edge collapse, guided by quadric error metrics (Garland and Heckbert 1997)
+//
+// Every collapse moves a vertex onto a neighbour, so the simplified triangles only use vertices of the input mesh
+// and no attribute is ever interpolated. Vertices sharing a position but differing in any attribute make up a seam,
+// e.g. of texture coordinates or hard edges in the normals. Seams and open borders only collapse along themselves,
+// and vertices where they meet or branch never move, so the seams of every attribute are kept.
+// Collapses that would turn a triangle over are skipped.
+// The edges are collapsed in passes: the cost of every edge is evaluated in parallel, then the cheapest of them that
+// don't touch each other are collapsed, so meshes of millions of triangles simplify in seconds.
+// Errors are distances in the units of the positions, of the simplified surface from the original.
+//
+// The mesh needs a vec3 POSITION buffer and indices, with vertices equal in every attribute welded into one, see weldVertices.
+// Every function throws std::invalid_argument if it has no such buffer, no indices or indices that are not a triangle list.
+// numThreads = 0 uses one thread per hardware thread.
+
+// a copy of mesh with its triangles simplified until at most targetTriangles are left,
+// or until the next collapse would take the error past maxError, whichever comes first
+// the copy only has the vertices its triangles use, in the same order, and no levels of detail
+// sets error, if given, to the error of the simplified triangles
+Mesh simplifyMesh(const Mesh& mesh, size_t targetTriangles, float maxError = std::numeric_limits<float>::infinity(),
+    float* error = nullptr, unsigned numThreads = 0);
+
+// replace the levels of detail of mesh with up to numLevels, each simplified from the one before to ratio times its triangles
+// stops early once a level would take the error past maxError or not get halfway to its triangle count
+// each level's error is the sum of the errors of the steps to it, which bounds its distance from the mesh
+// throws std::invalid_argument if ratio is not between 0 and 1
+void buildLodChain(Mesh& mesh, unsigned numLevels = 4, float ratio = 0.5f, float maxError = std::numeric_limits<float>::infinity(),
+    unsigned numThreads = 0);
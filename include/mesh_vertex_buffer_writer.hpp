@@ -10,7 +10,8 @@ public:
 
     explicit MeshVertexBufferWriter(const Mesh& mesh);
 
-    void write(MeshRenderer& meshRenderer) const;
+    // allocate a block in meshRenderer and upload the mesh to it, the block can be drawn with MeshRenderer::drawBlock
+    MeshRenderer::Block write(MeshRenderer& meshRenderer) const;
 
 private:
 
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "mesh.hpp"
+
+
+// Welding of duplicate vertices, e.g. of meshes imported or generated without indices
+//
+// Vertices are equal if every attribute buffer holds equal values for them. Each set of equal vertices is
+// collapsed into the first of them, so the welded vertices keep their relative order, and indices() is
+// remapped to match, or created for meshes without indices, which then draw the same triangles as before.
+// The indices of the levels of detail are remapped too.
+// Vertices are hashed in parallel and split into shards by hash, each shard deduplicated on its own thread
+// with a private open addressing table, so there are no locks and the result doesn't depend on the thread count.
+//
+// numThreads = 0 uses one thread per hardware thread.
+
+// with epsilon = 0 values are compared bitwise, so 0.0 and -0.0 stay apart but NaNs weld
+// with epsilon > 0 float components are snapped to a grid of that spacing first, and vertices in the same cell weld,
+// so they differ by less than epsilon in every component, but vertices closer than that may still stay apart
+// if a grid line falls between them; other component types are always compared bitwise
+// throws std::invalid_argument if epsilon is negative or the mesh has 2^32 vertices or more
+void weldVertices(Mesh& mesh, float epsilon = 0.0f, unsigned numThreads = 0);
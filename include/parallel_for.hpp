@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+
+namespace parallel_for_detail {
+
+// true on threads already running in parallel with the others of a pool or a parallelFor
+inline thread_local bool inParallelWorker = false;
+
+}
+
+// Marks the calling thread as a worker of a thread pool for as long as it lives, e.g. the threads of MeshLoader
+// parallelFor calls on the thread then run inline, since the pool already keeps the cores busy
+// and a pool of n workers each spawning n threads would oversubscribe them n times over.
+
+class ParallelWorkerScope {
+
+public:
+
+    ParallelWorkerScope() noexcept :
+            _previous(parallel_for_detail::inParallelWorker) {
+        parallel_for_detail::inParallelWorker = true;
+    }
+
+    ~ParallelWorkerScope() {
+        parallel_for_detail::inParallelWorker = _previous;
+    }
+
+    ParallelWorkerScope(const ParallelWorkerScope&) = delete;
+    ParallelWorkerScope& operator=(const ParallelWorkerScope&) = delete;
+
+private:
+
+    bool _previous;
+
+};
+
+// Split [0, count) into contiguous ranges and call f(begin, end) for each on its own thread
+// Ranges are at least minRangeSize long, so small inputs run on the calling thread without spawning anything.
+// numThreads = 0 uses one thread per hardware thread. The calling thread takes the first range.
+// Calls from inside f, or from a thread in a ParallelWorkerScope, run all of [0, count) on the calling thread.
+// The first exception thrown by f is rethrown once every range has finished.
+
+template<typename F>
+void parallelFor(size_t count, size_t minRangeSize, F&& f, unsigned numThreads = 0) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t numRanges = std::min<size_t>(numThreads, std::max<size_t>(1, count / std::max<size_t>(1, minRangeSize)));
+    if (numRanges <= 1 || parallel_for_detail::inParallelWorker) {
+        if (count > 0) {
+            f(size_t(0), count);
+        }
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(numRanges);
+    auto runRange = [&] (size_t r) {
+        ParallelWorkerScope worker;
+        try {
+            f(count * r / numRanges, count * (r + 1) / numRanges);
+        } catch (...) {
+            errors[r] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numRanges - 1);
+    try {
+        for (size_t r = 1; r < numRanges; ++r) {
+            threads.emplace_back(runRange, r);
+        }
+    } catch (...) {
+        // the threads already started reference f and errors, and destroying them unjoined would terminate
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        throw;
+    }
+    runRange(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include "mesh_renderer.hpp"
+
+
+// On-disk cache of meshes in the final vertex layout of a RenderMeshMapping, ready to copy into a MeshRenderer
+//
+// Entries are keyed by a hash of the source mesh file's contents, the mapping and the file format version,
+// so an edited source file or a changed mapping never hits a stale entry. A hit is a single sequential read
+// straight into the renderer's buffers, with no decoding or interleaving.
+// The cache is capped in size, the least recently used entries are evicted first.
+// Content hashes of source files are remembered by path, size, modification time, inode and change time,
+// so a warm load doesn't have to read the source file at all. A hash taken within a couple of seconds of
+// the file's last modification is re-checked on the next load, as a later write could share its timestamp.
+// Not thread safe, meant to be used from the thread owning the GL context.
+
+class RenderMeshCache {
+
+public:
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+        uint64_t bytesRead = 0;     // from cache entries
+        uint64_t bytesWritten = 0;  // to cache entries
+        uint64_t numEntries = 0;
+        uint64_t totalBytes = 0;
+        uint64_t maxBytes = 0;
+    };
+
+    // entries already in directory count towards maxBytes, evicting some of them if the cap shrank
+    RenderMeshCache(const std::filesystem::path& directory, uint64_t maxBytes);
+
+    // saves the remembered source file hashes
+    ~RenderMeshCache();
+
+    RenderMeshCache(const RenderMeshCache&) = delete;
+    RenderMeshCache& operator=(const RenderMeshCache&) = delete;
+
+    // allocate a block in meshRenderer and fill it with the mesh in meshFileName, from the cache if possible
+    // on a miss the file is loaded with RenderMeshLoader and stored for next time,
+    // failing to store it is reported but doesn't fail the load
+    MeshRenderer::Block load(const std::string& meshFileName, MeshRenderer& meshRenderer);
+
+    // remove every entry
+    void clear();
+
+    Stats stats() const noexcept;
+
+    void reportStats(std::ostream& os) const;
+
+private:
+
+    struct Entry {
+        uint64_t size;
+        std::filesystem::file_time_type lastUse;
+    };
+
+    // hash of a source file and what identified its contents when it was hashed
+    // the change time and file id are 0 where stat isn't available
+    struct SourceHash {
+        uint64_t size;
+        int64_t modificationTime;
+        int64_t changeTime;
+        uint64_t fileId;
+        int64_t hashTime;   // when the contents were hashed, in the units of modificationTime
+        uint64_t hash;
+    };
+
+    uint64_t sourceHash(const std::string& meshFileName);
+
+    std::string entryKey(const std::string& meshFileName, const RenderMeshMapping& mapping);
+
+    std::filesystem::path entryPath(const std::string& key) const;
+
+    std::optional<MeshRenderer::Block> readEntry(const std::string& key, const std::string& meshFileName, MeshRenderer& meshRenderer);
+
+    void storeEntry(const std::string& key, const char* vertices, size_t numVertices, size_t vertexSize,
+        const char* indices, size_t numIndices, MeshIndexType indexType);
+
+    void removeEntry(const std::string& key);
+
+    void evict();
+
+    void loadSourceHashes();
+
+    void saveSourceHashes() const;
+
+    std::filesystem::path _directory;
+
+    uint64_t _maxBytes;
+
+    uint64_t _totalBytes;
+
+    std::unordered_map<std::string, Entry> _entries;
+
+    std::unordered_map<std::string, SourceHash> _sourceHashes;
+
+    bool _sourceHashesChanged;
+
+    Stats _stats;
+
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mesh_renderer.hpp"
+
+
+class MappedFile;
+struct MeshFileLayout;
+
+// Loads a mesh file straight into the interleaved vertex layout of a RenderMeshMapping, without building a Mesh
+//
+// Meant for static geometry that only lives on the GPU. The file is mapped, so vertex data is copied once,
+// from the mapping into the destination, which can be a mapped vertex buffer or any CPU buffer.
+// When the file was written interleaved with the mapping's attributes in the mapping's order,
+// the whole vertex buffer is a single copy.
+// Compressed files work too, though each attribute stream has to be decoded to scratch memory first.
+
+class RenderMeshLoader {
+
+public:
+
+    explicit RenderMeshLoader(const std::string& fileName);
+
+    ~RenderMeshLoader();
+
+    size_t numVertices() const noexcept;
+
+    size_t numIndices() const noexcept;
+
+    // the index type stored in the file
+    MeshIndexType indexType() const noexcept;
+
+    // mapping of attribute in the type the file stores it with, so a RenderMeshMapping can be built from the header alone
+    // throws std::invalid_argument if the file has no buffer for attribute
+    RenderMeshMapping::AttributeMapping attributeMapping(MeshAttribute attribute) const;
+
+    // true if loading with mapping copies the file's vertex buffer in one piece
+    // throws like loadVertices if the file can't be loaded with mapping at all
+    bool matchesLayout(const RenderMeshMapping& mapping) const;
+
+    // write numVertices() vertices in the layout of mapping to vertexData
+    // throws std::invalid_argument if the file has no attribute for a mapping, or stores it with a different type
+    void loadVertices(const RenderMeshMapping& mapping, void* vertexData) const;
+
+    // write numIndices() indices of indexType to indexData, rebased by adding baseVertex
+    // throws std::out_of_range if a rebased index doesn't fit in indexType
+    void loadIndices(void* indexData, MeshIndexType indexType, uint32_t baseVertex = 0) const;
+
+    // allocate a block in meshRenderer and load into its buffers, using the narrowest index type the vertex count allows
+    // indices are not rebased, since drawBlock uses the block's vertex offset as the base vertex
+    MeshRenderer::Block load(MeshRenderer& meshRenderer) const;
+
+private:
+
+    std::unique_ptr<MappedFile> _file;
+
+    std::unique_ptr<MeshFileLayout> _layout;
+
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+
+// Gathering of strided (interleaved) vertex data into contiguous attribute buffers, or into another interleaved layout
+
+// one attribute to gather: numElements elements of elementSize bytes, srcStride bytes apart in src
+// and dstStride bytes apart in dst, 0 meaning tightly packed
+struct StridedCopy {
+    void* dst;
+    const void* src;
+    size_t srcStride;
+    size_t elementSize;
+    size_t dstStride = 0;
+};
+
+// gather elements [begin, end) of a single attribute, on the calling thread
+// 8, 12 and 16 byte elements gathered into packed destinations use SSE2 where available,
+// other sizes and layouts fall back to memcpy per element
+void gatherStrided(const StridedCopy& copy, size_t begin, size_t end);
+
+// gather numElements elements of every attribute, splitting the element range across threads
+// each thread works through its range in blocks small enough that the interleaved source stays in cache
+// while every attribute is gathered from it
+// numThreads = 0 uses one thread per hardware thread
+void deinterleave(const std::vector<StridedCopy>& copies, size_t numElements, unsigned numThreads = 0);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+
+#include "vector_math.hpp"
+
+
+// Batch versions of the vector math in vector_math.hpp, for running one operation over a whole attribute buffer
+// Each function has SSE, AVX2 and NEON paths, picked at runtime from what the CPU supports, and a scalar path which
+// is a plain loop over the vvm operations and gives the same results as calling them one vector at a time
+// The SIMD paths round like a straightforward loop would, without fused multiply-add or reciprocal estimates,
+// but may still differ from vvm in the last bit, e.g. where vvm orders a sum differently
+// Outputs may alias inputs exactly (in place), but must not partially overlap them
+
+namespace batch {
+
+enum class SimdLevel {
+    SCALAR,
+    SSE,
+    AVX2,
+    NEON
+};
+
+const char* simdLevelName(SimdLevel level);
+
+// the best level the CPU supports
+SimdLevel supportedSimdLevel();
+
+// the level the functions below currently use, initially supportedSimdLevel()
+SimdLevel simdLevel();
+
+// use level, e.g. SCALAR to compare against the reference results
+// throws std::invalid_argument if the CPU does not support level
+void setSimdLevel(SimdLevel level);
+
+// out[i] = (matrix * vec4(in[i], 1)).xyz, the w row of matrix is ignored, so there is no perspective divide
+void transformPoints(const mat4& matrix, const vec3* in, vec3* out, size_t count);
+
+// out[i] = (matrix * vec4(in[i], 0)).xyz, the result is not normalized
+void transformDirections(const mat4& matrix, const vec3* in, vec3* out, size_t count);
+
+// out[i] = normalize(in[i])
+void normalize(const vec3* in, vec3* out, size_t count);
+
+// out[i] = dot(a[i], b[i])
+void dot(const vec3* a, const vec3* b, float* out, size_t count);
+
+// out[i] = cross(a[i], b[i])
+void cross(const vec3* a, const vec3* b, vec3* out, size_t count);
+
+// componentwise minimum and maximum of in, e.g. the bounding box of positions
+// throws std::invalid_argument if count is zero, NaN components give unspecified results
+void minMax(const vec3* in, size_t count, vec3& min, vec3& max);
+
+// the largest squared distance from point to any of in, 0 if count is zero
+float maxDistanceSquared(const vec3* in, size_t count, const vec3& point);
+
+}
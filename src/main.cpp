@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
+#include <string>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -16,10 +20,16 @@
 #include <mesh_renderer.hpp>
 #include <mesh_vertex_buffer_writer.hpp>
 #include <mesh_io.hpp>
+#include <mesh_loader.hpp>
+#include <render_mesh_cache.hpp>
+#include <render_mesh_loader.hpp>
 
 #include "console_thread.hpp"
 
 
+// cap of the render mesh cache on disk
+static constexpr uint64_t RENDER_MESH_CACHE_SIZE = uint64_t(1) << 30;
+
 struct glfw_context {
 public:
     GLFWwindow* window;
@@ -63,14 +73,6 @@ std::string file_as_string(const std::string& filename) {
     };
 }
 
-static RenderMeshMapping::AttributeMapping getAttributeMapping(const MeshAttributeBuffer& attribBuffer) {
-    return {
-        .attribute = attribBuffer.getAttribute(),
-        .componentType = attribBuffer.componentType(),
-        .numComponents = attribBuffer.numComponents()
-    };
-}
-
 void printMeshVertices(const Mesh& mesh) {
     std::cout << "iterating vertices" << std::endl;
     for (auto&& [pos, norm, uv] : mesh.view<vec3, vec3, vec2>(MeshAttribute::POSITION, MeshAttribute::NORMAL, MeshAttribute::TEXCOORD)) {
@@ -83,6 +85,9 @@ void printMeshVertices(const Mesh& mesh) {
 }
 
 int main(int argc, char* argv[]) {
+    // only decode the mesh on the cpu side when something needs its data, drawing it doesn't
+    const bool printVertices = argc > 1 && std::string(argv[1]) == "--print-vertices";
+
     glfw_context context;
 
     if (glewInit() != GLEW_OK) {
@@ -182,27 +187,40 @@ int main(int argc, char* argv[]) {
     
     MeshWriter("test_mesh.mbin").writeMesh(testMesh);
 
-    testMesh = MeshReader("data/untitled.mbin").readMesh();
-
-    // printMeshVertices(testMesh);
-    // for (auto ind : testMesh.indices()) std::cout << ind << ",";
-    // std::cout << std::endl;    
-
-    // todo: auto generate
-    // easy to get the elements from the mesh, but the order matters
-    // and depends on shader access.
-    // eventually, shaders should be auto-generated too so no problem there i guess
-    RenderMeshMapping renderMeshMapping = {{
-        getAttributeMapping(testMesh.getAttributeBuffer(MeshAttribute::POSITION)),
-        getAttributeMapping(testMesh.getAttributeBuffer(MeshAttribute::NORMAL))}};
+    const std::string meshFileName = "data/untitled.mbin";
 
-    MeshRenderer meshRenderer(renderMeshMapping,
-        testMesh.vertexSize() * testMesh.numVertices(),
-        sizeof(Mesh::index_t) * testMesh.numIndices());
-    
-    MeshVertexBufferWriter(testMesh).write(meshRenderer);
+    // the mapping only needs the attribute types in the file header, so the mesh goes straight from
+    // the render mesh cache into the vertex buffer, and a warm start is a single read of the cache entry
+    RenderMeshCache renderMeshCache("cache", RENDER_MESH_CACHE_SIZE);
+    std::optional<MeshRenderer> meshRenderer;
+    MeshRenderer::Block meshBlock;
+    {
+        RenderMeshLoader header(meshFileName);
+
+        // todo: auto generate
+        // easy to get the elements from the file, but the order matters
+        // and depends on shader access.
+        // eventually, shaders should be auto-generated too so no problem there i guess
+        RenderMeshMapping renderMeshMapping = {{
+            header.attributeMapping(MeshAttribute::POSITION),
+            header.attributeMapping(MeshAttribute::NORMAL)}};
+
+        const MeshIndexType indexType = std::min(header.indexType(), minimumIndexType(header.numVertices()));
+        meshRenderer.emplace(renderMeshMapping,
+            header.numVertices() * mappingVertexSize(renderMeshMapping),
+            header.numIndices() * indexSize(indexType));
+
+        meshBlock = renderMeshCache.load(meshFileName, *meshRenderer);
+        meshRenderer->getVertexArray().bind();
+    }
+    renderMeshCache.reportStats(std::cout);
 
-    meshRenderer.getVertexArray().bind();
+    // decode on a worker thread so the window stays responsive
+    MeshLoader meshLoader;
+    MeshLoader::Handle meshLoad;
+    if (printVertices) {
+        meshLoad = meshLoader.load(meshFileName);
+    }
 
     vvm::v3f camera_position = {0, 0, 3};
 
@@ -237,13 +255,15 @@ int main(int argc, char* argv[]) {
         });
         program.bindUniformBuffer("matrices", matrices_ubo);
 
+        if (meshLoad.valid() && meshLoad.ready()) {
+            printMeshVertices(meshLoad.get());
+        }
+
         glViewport(0, 0, width, height);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        if (testMesh.hasIndices()) {
-            glDrawElements(GL_TRIANGLES, testMesh.numIndices(), GL_UNSIGNED_INT, nullptr);
-        } else {
-            glDrawArrays(GL_TRIANGLES, 0, testMesh.numVertices());
+        if (meshRenderer) {
+            meshRenderer->drawBlock(meshBlock);
         }
 
         glfwSwapBuffers(context.window);
@@ -0,0 +1,92 @@
+#include <mapped_file.hpp>
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& fileName) :
+        _data(nullptr),
+        _size(0) {
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot read file: " + fileName);
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw std::runtime_error("Cannot get size of file: " + fileName);
+    }
+    _size = static_cast<size_t>(fileSize.QuadPart);
+
+    if (_size > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) {
+            throw std::runtime_error("Cannot map file: " + fileName);
+        }
+        _data = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+        CloseHandle(mapping);
+        if (!_data) {
+            throw std::runtime_error("Cannot map file: " + fileName);
+        }
+    } else {
+        CloseHandle(file);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (_data) {
+        UnmapViewOfFile(_data);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& fileName) :
+        _data(nullptr),
+        _size(0) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot read file: " + fileName);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot get size of file: " + fileName);
+    }
+    _size = static_cast<size_t>(st.st_size);
+
+    // mmap of length 0 is an error, an empty file just maps to nothing
+    if (_size > 0) {
+        void* ptr = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map file: " + fileName);
+        }
+        _data = static_cast<char*>(ptr);
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (_data) {
+        munmap(_data, _size);
+    }
+}
+
+#endif
@@ -0,0 +1,293 @@
+#include <mesh_chunk_io.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <strided_copy.hpp>
+
+#include "mesh_file_format.hpp"
+
+
+// MeshChunkReader
+
+MeshChunkReader::MeshChunkReader(const std::string& fileName) :
+        _fs(fileName, std::ios::in | std::ios::binary),
+        _nextVertex(0),
+        _vertexOffset(0),
+        _nextIndex(0),
+        _indexOffset(0) {
+    if (!_fs) {
+        throw std::runtime_error("Cannot read file: " + fileName);
+    }
+
+    _layout = std::make_unique<MeshFileLayout>(readStreamLayout(_fs));
+    if (_layout->encoding != MeshFileEncoding::RAW) {
+        throw std::runtime_error("Compressed mesh files can't be read in chunks: " + fileName);
+    }
+
+    for (size_t i = 0; i < _layout->attribData.size(); ++i) {
+        const AttribData& data = _layout->attribData[i];
+        _attributes.push_back(MeshAttributeLayout { getAttributeFromName(_layout->attribNames[i]),
+            static_cast<MeshAttributeComponentType>(data.componentType), data.numComponents });
+    }
+
+    std::set<MeshAttribute> all;
+    for (const auto& layout : _attributes) {
+        all.insert(layout.attribute);
+    }
+    selectAttributes(all);
+}
+
+MeshChunkReader::~MeshChunkReader() = default;
+
+size_t MeshChunkReader::numVertices() const noexcept {
+    return _layout->vertexCount;
+}
+
+size_t MeshChunkReader::numIndices() const noexcept {
+    return _layout->indexCount;
+}
+
+MeshIndexType MeshChunkReader::indexType() const noexcept {
+    return _layout->indexType;
+}
+
+void MeshChunkReader::selectAttributes(const std::set<MeshAttribute>& attributes) {
+    std::vector<size_t> selected;
+    for (size_t i = 0; i < _attributes.size(); ++i) {
+        if (attributes.count(_attributes[i].attribute) > 0) {
+            selected.push_back(i);
+        }
+    }
+    std::sort(selected.begin(), selected.end(), [this] (size_t a, size_t b) {
+        return _layout->attribSections[a].offset < _layout->attribSections[b].offset;
+    });
+
+    // attributes join the previous group if they have its stride and start within its first vertex
+    _groups.clear();
+    for (size_t i : selected) {
+        const uint64_t offset = _layout->attribSections[i].offset;
+        const uint64_t stride = _layout->attribData[i].vertexBufferStride;
+        const uint64_t elementSize = attribElementSize(_layout->attribData[i]);
+        if (_groups.empty() || _groups.back().stride != stride || offset - _groups.back().offset >= stride) {
+            _groups.push_back(ReadGroup { offset, stride, 0, {} });
+        }
+        ReadGroup& group = _groups.back();
+        group.span = std::max(group.span, offset - group.offset + elementSize);
+        group.attributes.push_back(i);
+    }
+}
+
+// give chunk a buffer for each selected attribute, and nothing else
+void MeshChunkReader::prepareChunk(Mesh& chunk) const {
+    size_t numSelected = 0;
+    bool matches = true;
+    for (const auto& group : _groups) {
+        for (size_t i : group.attributes) {
+            const MeshAttributeLayout& layout = _attributes[i];
+            try {
+                const MeshAttributeBuffer& buffer = chunk.getAttributeBuffer(layout.attribute);
+                matches = matches && buffer.componentType() == layout.componentType && buffer.numComponents() == layout.numComponents;
+            } catch (std::invalid_argument&) {
+                matches = false;
+            }
+            ++numSelected;
+        }
+    }
+    if (matches && chunk.numAttributes() == numSelected) {
+        return;
+    }
+
+    chunk = Mesh();
+    for (const auto& group : _groups) {
+        for (size_t i : group.attributes) {
+            chunk.createAttributeBuffer(_attributes[i].attribute, _attributes[i].componentType, _attributes[i].numComponents);
+        }
+    }
+}
+
+bool MeshChunkReader::readVertices(Mesh& chunk, size_t maxVertices) {
+    if (maxVertices == 0) {
+        throw std::invalid_argument("Vertex chunks need room for at least one vertex.");
+    }
+
+    const size_t count = std::min(maxVertices, numVertices() - _nextVertex);
+    _vertexOffset = _nextVertex;
+
+    prepareChunk(chunk);
+    chunk.indices().clear();
+    chunk.setNumVertices(count);
+    if (count == 0) {
+        return false;
+    }
+
+    _fs.clear();
+    for (const auto& group : _groups) {
+        const uint64_t first = group.offset + _nextVertex * group.stride;
+        const size_t numBytes = (count - 1) * group.stride + group.span;
+        _fs.seekg(first);
+
+        // contiguous attributes are read straight into their buffers
+        if (group.attributes.size() == 1 && group.span == group.stride) {
+            void* data = chunk.getAttributeBuffer(_attributes[group.attributes[0]].attribute).data();
+            if (!_fs.read(static_cast<char*>(data), numBytes)) {
+                throw std::runtime_error("Mesh file is truncated.");
+            }
+            continue;
+        }
+
+        _staging.resize(numBytes);
+        if (!_fs.read(_staging.data(), numBytes)) {
+            throw std::runtime_error("Mesh file is truncated.");
+        }
+        std::vector<StridedCopy> copies;
+        for (size_t i : group.attributes) {
+            copies.push_back(StridedCopy { chunk.getAttributeBuffer(_attributes[i].attribute).data(),
+                _staging.data() + (_layout->attribSections[i].offset - group.offset), group.stride, attribElementSize(_layout->attribData[i]) });
+        }
+        deinterleave(copies, count);
+    }
+
+    _nextVertex += count;
+    return true;
+}
+
+bool MeshChunkReader::readIndices(MeshIndexBuffer& chunk, size_t maxIndices) {
+    if (maxIndices == 0) {
+        throw std::invalid_argument("Index chunks need room for at least one index.");
+    }
+
+    const size_t count = std::min(maxIndices, numIndices() - _nextIndex);
+    _indexOffset = _nextIndex;
+
+    chunk.clear();
+    chunk.setIndexType(indexType());
+    if (count == 0) {
+        return false;
+    }
+    chunk.resize(count);
+
+    _fs.clear();
+    _fs.seekg(_layout->indexSection.offset + _nextIndex * ::indexSize(indexType()));
+    if (!_fs.read(static_cast<char*>(chunk.data()), chunk.sizeBytes())) {
+        throw std::runtime_error("Mesh file is truncated.");
+    }
+
+    _nextIndex += count;
+    return true;
+}
+
+void MeshChunkReader::rewind() noexcept {
+    _nextVertex = 0;
+    _vertexOffset = 0;
+    _nextIndex = 0;
+    _indexOffset = 0;
+}
+
+// MeshChunkWriter
+
+MeshChunkWriter::MeshChunkWriter(const std::string& fileName, const std::vector<MeshAttributeLayout>& attributes,
+        size_t numVertices, size_t numIndices, MeshIndexType indexType) :
+        _fs(fileName, std::ios::out | std::ios::binary),
+        _attributes(attributes),
+        _numVertices(numVertices),
+        _nextVertex(0),
+        _numIndices(numIndices),
+        _nextIndex(0),
+        _indexType(indexType),
+        _converted(indexType) {
+    if (!_fs) {
+        throw std::runtime_error("Cannot write file: " + fileName);
+    }
+    if (attributes.size() > UINT8_MAX) {
+        throw std::invalid_argument("Mesh files can't hold more than 255 attributes.");
+    }
+
+    // same layout as MeshWriter writes for non-interleaved meshes
+    HeaderDataV2 header;
+    header.version = MESH_FILE_VERSION;
+    header.headerSize = HEADER_V2_SIZE;
+    header.encoding = MeshFileEncoding::RAW;
+    header.indexType = indexType;
+    header.attribCount = attributes.size();
+    header.vertexCount = numVertices;
+    header.indexCount = numIndices;
+
+    std::vector<char> table(HEADER_V2_SIZE + ATTRIB_ENTRY_SIZE * attributes.size());
+    uint64_t position = alignFileOffset(table.size());
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        const size_t elementSize = componentSize(attributes[i].componentType) * attributes[i].numComponents;
+        AttribEntry entry;
+        entry.name = getAttributeName(attributes[i].attribute);
+        entry.componentType = static_cast<uint8_t>(attributes[i].componentType);
+        entry.numComponents = attributes[i].numComponents;
+        entry.section = MeshFileSection { position, elementSize * numVertices };
+        entry.stride = elementSize;
+        packAttribEntry(table.data() + HEADER_V2_SIZE + i * ATTRIB_ENTRY_SIZE, entry);
+
+        _sectionOffsets.push_back(position);
+        position = alignFileOffset(position + entry.section.size);
+    }
+
+    _indexSectionOffset = position;
+    header.indexSection = numIndices > 0 ? MeshFileSection { position, numIndices * ::indexSize(indexType) } : MeshFileSection { 0, 0 };
+    packFileHeaderV2(table.data(), header);
+
+    _fs.write(table.data(), table.size());
+}
+
+void MeshChunkWriter::writeVertices(const Mesh& chunk) {
+    const size_t count = chunk.numVertices();
+    if (count > _numVertices - _nextVertex) {
+        throw std::invalid_argument("Vertex chunk holds more vertices than are left to write.");
+    }
+
+    for (size_t i = 0; i < _attributes.size(); ++i) {
+        const MeshAttributeLayout& layout = _attributes[i];
+        const MeshAttributeBuffer& buffer = chunk.getAttributeBuffer(layout.attribute);
+        if (buffer.componentType() != layout.componentType || buffer.numComponents() != layout.numComponents) {
+            throw std::invalid_argument(std::string("Vertex chunk buffer has a different type than the file for attribute: ") +
+                attributeName(layout.attribute));
+        }
+        _fs.seekp(_sectionOffsets[i] + _nextVertex * buffer.elementSize());
+        _fs.write(static_cast<const char*>(buffer.data()), count * buffer.elementSize());
+    }
+
+    if (!_fs) {
+        throw std::runtime_error("Write error.");
+    }
+    _nextVertex += count;
+}
+
+void MeshChunkWriter::writeIndices(const MeshIndexBuffer& chunk) {
+    const size_t count = chunk.size();
+    if (count > _numIndices - _nextIndex) {
+        throw std::invalid_argument("Index chunk holds more indices than are left to write.");
+    }
+
+    const MeshIndexBuffer* indices = &chunk;
+    if (chunk.indexType() != _indexType) {
+        _converted.assign(chunk.begin(), chunk.end());
+        _converted.setIndexType(_indexType);
+        indices = &_converted;
+    }
+
+    _fs.seekp(_indexSectionOffset + _nextIndex * ::indexSize(_indexType));
+    _fs.write(static_cast<const char*>(indices->data()), indices->sizeBytes());
+
+    if (!_fs) {
+        throw std::runtime_error("Write error.");
+    }
+    _nextIndex += count;
+}
+
+void MeshChunkWriter::finish() {
+    if (_nextVertex != _numVertices || _nextIndex != _numIndices) {
+        throw std::runtime_error("Mesh file was finished before all of its vertices and indices were written.");
+    }
+    _fs.flush();
+    if (!_fs) {
+        throw std::runtime_error("Write error.");
+    }
+}
@@ -0,0 +1,278 @@
+#include <mesh_codec.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+
+// LZ block format, close to LZ4:
+//   sequence := token [literal length bytes] literals [offset (2 bytes) [match length bytes]]
+//   token high nibble: literal count, low nibble: match length - MIN_MATCH, 15 means more length bytes follow
+//   length bytes are added to the nibble until a byte below 255 is read
+//   the final sequence only has literals
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr size_t HASH_BITS = 16;
+
+// matches are not searched for at the very end of the input, which keeps the match loop free of bounds checks
+static constexpr size_t END_LITERALS = 12;
+
+static inline uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(uint32_t));
+    return v;
+}
+
+static inline uint32_t hash32(uint32_t v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void writeLength(std::vector<char>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+static void writeSequence(std::vector<char>& out, const unsigned char* literals, size_t numLiterals, size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength >= MIN_MATCH ? matchLength - MIN_MATCH : 0;
+    unsigned char token = (std::min<size_t>(numLiterals, 15) << 4) | std::min<size_t>(matchCode, 15);
+    out.push_back(static_cast<char>(token));
+    if (numLiterals >= 15) writeLength(out, numLiterals - 15);
+    out.insert(out.end(), literals, literals + numLiterals);
+    if (matchLength >= MIN_MATCH) {
+        out.push_back(static_cast<char>(offset & 0xff));
+        out.push_back(static_cast<char>(offset >> 8));
+        if (matchCode >= 15) writeLength(out, matchCode - 15);
+    }
+}
+
+static void lzCompress(const unsigned char* src, size_t size, std::vector<char>& out, std::vector<uint32_t>& hashTable) {
+    hashTable.assign(size_t(1) << HASH_BITS, 0);
+
+    const unsigned char* anchor = src;
+    const unsigned char* ip = src;
+    const unsigned char* const end = src + size;
+    const unsigned char* const matchLimit = size > END_LITERALS ? end - END_LITERALS : src;
+
+    // positions are stored + 1 so 0 can mean empty
+    while (ip < matchLimit) {
+        uint32_t h = hash32(read32(ip));
+        uint32_t candidate = hashTable[h];
+        hashTable[h] = static_cast<uint32_t>(ip - src) + 1;
+
+        if (candidate == 0) {
+            ++ip;
+            continue;
+        }
+        const unsigned char* ref = src + candidate - 1;
+        if (static_cast<size_t>(ip - ref) > MAX_OFFSET || read32(ref) != read32(ip)) {
+            ++ip;
+            continue;
+        }
+
+        size_t length = MIN_MATCH;
+        while (ip + length < matchLimit && ref[length] == ip[length]) ++length;
+
+        writeSequence(out, anchor, ip - anchor, ip - ref, length);
+        ip += length;
+        anchor = ip;
+    }
+
+    writeSequence(out, anchor, end - anchor, 0, 0);
+}
+
+static void lzDecompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize) {
+    const unsigned char* ip = src;
+    const unsigned char* const ipEnd = src + srcSize;
+    unsigned char* op = dst;
+    unsigned char* const opEnd = dst + dstSize;
+
+    auto malformed = [] () { return std::runtime_error("Compressed mesh stream is malformed."); };
+
+    auto readLength = [&] (size_t length) {
+        if (length == 15) {
+            unsigned char b;
+            do {
+                if (ip == ipEnd) throw malformed();
+                b = *ip++;
+                length += b;
+            } while (b == 255);
+        }
+        return length;
+    };
+
+    while (ip < ipEnd) {
+        unsigned char token = *ip++;
+
+        size_t numLiterals = readLength(token >> 4);
+        if (numLiterals > static_cast<size_t>(ipEnd - ip) || numLiterals > static_cast<size_t>(opEnd - op)) throw malformed();
+        memcpy(op, ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+
+        if (ip == ipEnd) break;  // final sequence
+
+        if (ipEnd - ip < 2) throw malformed();
+        size_t offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+        size_t length = readLength(token & 0x0f) + MIN_MATCH;
+
+        if (offset == 0 || offset > static_cast<size_t>(op - dst) || length > static_cast<size_t>(opEnd - op)) throw malformed();
+        const unsigned char* ref = op - offset;
+        if (offset >= length) {
+            memcpy(op, ref, length);
+        } else if (offset == 1) {
+            // runs of one repeated byte are common in the high byte planes
+            memset(op, *ref, length);
+        } else {
+            // overlapping match repeats the last offset bytes, copy the pattern in growing chunks
+            size_t copied = 0;
+            while (copied < length) {
+                size_t n = std::min(length - copied, offset + copied);
+                memcpy(op + copied, ref, n);
+                copied += n;
+            }
+        }
+        op += length;
+    }
+
+    if (op != opEnd) throw malformed();
+}
+
+// byte plane transposition, numBytes must be a multiple of planeCount
+
+static void splitBytePlanes(const unsigned char* src, unsigned char* dst, size_t numBytes, size_t planeCount) {
+    const size_t numWords = numBytes / planeCount;
+    for (size_t p = 0; p < planeCount; ++p) {
+        unsigned char* plane = dst + p * numWords;
+        const unsigned char* s = src + p;
+        for (size_t i = 0; i < numWords; ++i, s += planeCount) {
+            plane[i] = *s;
+        }
+    }
+}
+
+static void mergeBytePlanes(const unsigned char* src, unsigned char* dst, size_t numBytes, size_t planeCount) {
+    const size_t numWords = numBytes / planeCount;
+    if (planeCount == 4) {
+        // all the current component types, gather one whole word at a time
+        const unsigned char* p0 = src;
+        const unsigned char* p1 = src + numWords;
+        const unsigned char* p2 = src + 2 * numWords;
+        const unsigned char* p3 = src + 3 * numWords;
+        for (size_t i = 0; i < numWords; ++i, dst += 4) {
+            dst[0] = p0[i];
+            dst[1] = p1[i];
+            dst[2] = p2[i];
+            dst[3] = p3[i];
+        }
+        return;
+    }
+    for (size_t p = 0; p < planeCount; ++p) {
+        const unsigned char* plane = src + p * numWords;
+        unsigned char* d = dst + p;
+        for (size_t i = 0; i < numWords; ++i, d += planeCount) {
+            *d = plane[i];
+        }
+    }
+}
+
+void MeshStreamCodec::encodeAttributeStream(const void* data, size_t numBytes, size_t componentSize, std::vector<char>& out) {
+    if (componentSize == 0 || numBytes % componentSize != 0) {
+        throw std::invalid_argument("Attribute stream size must be a multiple of the component size.");
+    }
+    _scratch.resize(numBytes);
+    splitBytePlanes(static_cast<const unsigned char*>(data), reinterpret_cast<unsigned char*>(_scratch.data()), numBytes, componentSize);
+    lzCompress(reinterpret_cast<const unsigned char*>(_scratch.data()), numBytes, out, _hashTable);
+}
+
+void MeshStreamCodec::decodeAttributeStream(const char* encoded, size_t encodedSize, void* data, size_t numBytes, size_t componentSize) {
+    if (componentSize == 0 || numBytes % componentSize != 0) {
+        throw std::invalid_argument("Attribute stream size must be a multiple of the component size.");
+    }
+    _scratch.resize(numBytes);
+    lzDecompress(reinterpret_cast<const unsigned char*>(encoded), encodedSize, reinterpret_cast<unsigned char*>(_scratch.data()), numBytes);
+    mergeBytePlanes(reinterpret_cast<const unsigned char*>(_scratch.data()), static_cast<unsigned char*>(data), numBytes, componentSize);
+}
+
+// index streams are coded the same for 16 and 32-bit indices, so either width can decode the other's streams
+template<typename INDEX_T>
+static void encodeIndices(const INDEX_T* indices, size_t numIndices, std::vector<char>& out,
+        std::vector<char>& scratch, std::vector<uint32_t>& hashTable) {
+    // at most 5 varint bytes per index
+    scratch.resize(numIndices * 5);
+    unsigned char* op = reinterpret_cast<unsigned char*>(scratch.data());
+
+    uint32_t previous = 0;
+    for (size_t i = 0; i < numIndices; ++i) {
+        int32_t delta = static_cast<int32_t>(indices[i] - previous);
+        uint32_t zigzag = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+        while (zigzag >= 0x80) {
+            *op++ = static_cast<unsigned char>(zigzag | 0x80);
+            zigzag >>= 7;
+        }
+        *op++ = static_cast<unsigned char>(zigzag);
+        previous = indices[i];
+    }
+
+    size_t varintSize = op - reinterpret_cast<unsigned char*>(scratch.data());
+
+    // the decoder needs the size of the varint stream to size its LZ output
+    uint64_t size64 = varintSize;
+    out.insert(out.end(), reinterpret_cast<const char*>(&size64), reinterpret_cast<const char*>(&size64) + sizeof(uint64_t));
+    lzCompress(reinterpret_cast<const unsigned char*>(scratch.data()), varintSize, out, hashTable);
+}
+
+template<typename INDEX_T>
+static void decodeIndices(const char* encoded, size_t encodedSize, INDEX_T* indices, size_t numIndices, std::vector<char>& scratch) {
+    auto malformed = [] () { return std::runtime_error("Compressed mesh stream is malformed."); };
+
+    uint64_t varintSize;
+    if (encodedSize < sizeof(uint64_t)) throw malformed();
+    memcpy(&varintSize, encoded, sizeof(uint64_t));
+    if (varintSize > numIndices * 5) throw malformed();
+
+    scratch.resize(varintSize);
+    lzDecompress(reinterpret_cast<const unsigned char*>(encoded) + sizeof(uint64_t), encodedSize - sizeof(uint64_t),
+        reinterpret_cast<unsigned char*>(scratch.data()), varintSize);
+
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(scratch.data());
+    const unsigned char* const ipEnd = ip + varintSize;
+
+    uint32_t previous = 0;
+    for (size_t i = 0; i < numIndices; ++i) {
+        uint32_t zigzag = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (ip == ipEnd || shift > 28) throw malformed();
+            unsigned char b = *ip++;
+            zigzag |= static_cast<uint32_t>(b & 0x7f) << shift;
+            if (b < 0x80) break;
+        }
+        int32_t delta = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+        previous += static_cast<uint32_t>(delta);
+        if (previous > std::numeric_limits<INDEX_T>::max()) throw malformed();
+        indices[i] = static_cast<INDEX_T>(previous);
+    }
+
+    if (ip != ipEnd) throw malformed();
+}
+
+void MeshStreamCodec::encodeIndexStream(const uint16_t* indices, size_t numIndices, std::vector<char>& out) {
+    encodeIndices(indices, numIndices, out, _scratch, _hashTable);
+}
+
+void MeshStreamCodec::encodeIndexStream(const uint32_t* indices, size_t numIndices, std::vector<char>& out) {
+    encodeIndices(indices, numIndices, out, _scratch, _hashTable);
+}
+
+void MeshStreamCodec::decodeIndexStream(const char* encoded, size_t encodedSize, uint16_t* indices, size_t numIndices) {
+    decodeIndices(encoded, encodedSize, indices, numIndices, _scratch);
+}
+
+void MeshStreamCodec::decodeIndexStream(const char* encoded, size_t encodedSize, uint32_t* indices, size_t numIndices) {
+    decodeIndices(encoded, encodedSize, indices, numIndices, _scratch);
+}
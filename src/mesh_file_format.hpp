@@ -0,0 +1,522 @@
+#pragma once
+
+// Shared definitions for the binary mesh file format, see mesh_file_format.txt
+// Only meant to be included by the mesh IO implementation files
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <mesh/attribute.hpp>
+#include <mesh/attribute_buffer.hpp>
+#include <mesh/bounds.hpp>
+#include <mesh/index_buffer.hpp>
+
+
+// methods for translating mesh attributes and the names they are stored under
+// names which are not one of the predefined attributes are interned as new attributes
+
+inline std::string getAttributeName(MeshAttribute attrib) {
+    return attributeIdentifier(attrib);
+}
+
+inline MeshAttribute getAttributeFromName(const std::string& name) {
+    if (name.empty()) {
+        throw std::runtime_error("Mesh file has an attribute without a name");
+    }
+    return internAttribute(name);
+}
+
+// Version 1 files, which start with one of the MESH_FILE_IDS
+// packed, with attribute descriptions of varying size and no section offsets
+
+struct HeaderData {
+    char fileID[8];
+    uint8_t attribCount;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+};
+
+struct AttribData {
+    uint8_t componentType;
+    uint8_t numComponents;
+    uint64_t vertexBufferOffset;
+    uint64_t vertexBufferStride;
+};
+
+// the file ID also identifies how the vertex and index buffers are encoded
+enum class MeshFileEncoding {
+    RAW,        // buffers stored as they are in memory
+    COMPRESSED  // each attribute buffer and the index buffer compressed with MeshStreamCodec
+};
+
+// and the width of the stored indices
+struct MeshFileID {
+    char id[9];
+    MeshFileEncoding encoding;
+    MeshIndexType indexType;
+};
+
+inline constexpr MeshFileID MESH_FILE_IDS[] = {
+    {"meshfile", MeshFileEncoding::RAW, MeshIndexType::UINT32},
+    {"meshcomp", MeshFileEncoding::COMPRESSED, MeshIndexType::UINT32},
+    {"meshfi16", MeshFileEncoding::RAW, MeshIndexType::UINT16},
+    {"meshco16", MeshFileEncoding::COMPRESSED, MeshIndexType::UINT16}
+};
+
+inline constexpr size_t HEADER_SIZE = 25;
+inline constexpr size_t ATTRIB_DATA_SIZE = 18;
+
+inline HeaderData unpackFileHeader(const char* buffer) {
+    HeaderData header;
+    memcpy(header.fileID, buffer, sizeof(HeaderData::fileID));
+    size_t offset = sizeof(HeaderData::fileID);
+    memcpy(&header.attribCount, buffer + offset, sizeof(uint8_t));
+    offset += sizeof(uint8_t);
+    memcpy(&header.vertexCount, buffer + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&header.indexCount, buffer + offset, sizeof(uint64_t));
+    return header;
+}
+
+inline const MeshFileID& meshFileID(const HeaderData& header) {
+    for (const auto& fileID : MESH_FILE_IDS) {
+        if (memcmp(header.fileID, fileID.id, sizeof(HeaderData::fileID)) == 0) return fileID;
+    }
+    throw std::runtime_error("File does not have a valid mesh file ID.");
+}
+
+inline AttribData unpackAttribData(const char* buffer) {
+    // the fields are unaligned within the file, so they're copied out rather than read in place
+    AttribData data;
+    memcpy(&data.componentType, buffer, sizeof(uint8_t));
+    size_t offset = sizeof(uint8_t);
+    memcpy(&data.numComponents, buffer + offset, sizeof(uint8_t));
+    offset += sizeof(uint8_t);
+    memcpy(&data.vertexBufferOffset, buffer + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&data.vertexBufferStride, buffer + offset, sizeof(uint64_t));
+    return data;
+}
+
+// Version 2 files
+// a fixed size header and attribute table with naturally aligned fields, giving the location of every data section
+// sections start at multiples of MESH_FILE_ALIGNMENT from the beginning of the file
+
+inline constexpr char MESH_FILE_V2_ID[9] = "meshdata";
+inline constexpr uint32_t MESH_FILE_VERSION = 2;
+
+inline constexpr size_t MESH_FILE_ALIGNMENT = 64;
+inline constexpr size_t HEADER_V2_SIZE = 64;
+inline constexpr size_t HEADER_V2_BOUNDS_SIZE = 128;  // header size of files with room for the mesh bounds and levels of detail
+inline constexpr size_t HEADER_V2_LODS_OFFSET = 112;   // where the level of detail fields start, after the bounds
+inline constexpr size_t ATTRIB_ENTRY_SIZE = 64;
+inline constexpr size_t ATTRIB_NAME_SIZE = 32;
+inline constexpr size_t LOD_ENTRY_SIZE = 32;
+
+inline constexpr uint64_t alignFileOffset(uint64_t offset) {
+    return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+}
+
+// location in bytes of a data section, relative to the beginning of the mesh file
+struct MeshFileSection {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct HeaderDataV2 {
+    uint32_t version;
+    uint32_t headerSize;  // the attribute table starts here, newer versions may add fields
+    MeshFileEncoding encoding;
+    MeshIndexType indexType;
+    uint8_t attribCount;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    MeshFileSection indexSection;
+    std::optional<MeshBounds> bounds;  // only stored if headerSize is at least HEADER_V2_BOUNDS_SIZE
+    uint32_t lodCount;                 // likewise
+    uint64_t lodTableOffset;
+};
+
+// flags of the bounds block
+inline constexpr uint32_t HEADER_FLAG_BOUNDS = 1;
+
+struct AttribEntry {
+    std::string name;
+    uint8_t componentType;
+    uint8_t numComponents;
+    MeshFileSection section;  // raw: first to last element, compressed: the encoded stream
+    uint64_t stride;
+};
+
+// a level of detail, indices over the mesh's vertices
+struct LodEntry {
+    uint64_t indexCount;
+    MeshIndexType indexType;
+    float error;
+    MeshFileSection section;  // raw: the indices, compressed: the encoded stream
+};
+
+template<typename T>
+inline void storeField(char* buffer, size_t offset, const T& value) {
+    memcpy(buffer + offset, &value, sizeof(T));
+}
+
+template<typename T>
+inline T loadField(const char* buffer, size_t offset) {
+    T value;
+    memcpy(&value, buffer + offset, sizeof(T));
+    return value;
+}
+
+inline void storeVec3(char* buffer, size_t offset, const vec3& v) {
+    for (int c = 0; c < 3; ++c) {
+        storeField<float>(buffer, offset + c * sizeof(float), v[c]);
+    }
+}
+
+inline vec3 loadVec3(const char* buffer, size_t offset) {
+    return vec3(loadField<float>(buffer, offset), loadField<float>(buffer, offset + sizeof(float)), loadField<float>(buffer, offset + 2 * sizeof(float)));
+}
+
+// the bounds, bytes HEADER_V2_SIZE to HEADER_V2_LODS_OFFSET of buffer
+inline void packFileBoundsV2(char* buffer, const std::optional<MeshBounds>& bounds) {
+    memset(buffer + HEADER_V2_SIZE, 0, HEADER_V2_LODS_OFFSET - HEADER_V2_SIZE);
+    if (bounds) {
+        storeField<uint32_t>(buffer, 64, HEADER_FLAG_BOUNDS);
+        storeVec3(buffer, 72, bounds->min);
+        storeVec3(buffer, 84, bounds->max);
+        storeVec3(buffer, 96, bounds->center);
+        storeField<float>(buffer, 108, bounds->radius);
+    }
+}
+
+// buffer holds header.headerSize bytes
+inline void packFileHeaderV2(char* buffer, const HeaderDataV2& header) {
+    memset(buffer, 0, header.headerSize);
+    memcpy(buffer, MESH_FILE_V2_ID, 8);
+    storeField<uint32_t>(buffer, 8, header.version);
+    storeField<uint32_t>(buffer, 12, header.headerSize);
+    storeField<uint8_t>(buffer, 16, header.encoding == MeshFileEncoding::COMPRESSED ? 1 : 0);
+    storeField<uint8_t>(buffer, 17, static_cast<uint8_t>(indexSize(header.indexType)));
+    storeField<uint8_t>(buffer, 18, header.attribCount);
+    storeField<uint64_t>(buffer, 24, header.vertexCount);
+    storeField<uint64_t>(buffer, 32, header.indexCount);
+    storeField<uint64_t>(buffer, 40, header.indexSection.offset);
+    storeField<uint64_t>(buffer, 48, header.indexSection.size);
+    if (header.headerSize >= HEADER_V2_BOUNDS_SIZE) {
+        packFileBoundsV2(buffer, header.bounds);
+        storeField<uint32_t>(buffer, 112, header.lodCount);
+        storeField<uint64_t>(buffer, 120, header.lodTableOffset);
+    }
+}
+
+inline HeaderDataV2 unpackFileHeaderV2(const char* buffer) {
+    HeaderDataV2 header;
+    header.version = loadField<uint32_t>(buffer, 8);
+    if (header.version != MESH_FILE_VERSION) {
+        throw std::runtime_error("Unsupported mesh file version: " + std::to_string(header.version));
+    }
+    header.headerSize = loadField<uint32_t>(buffer, 12);
+    if (header.headerSize < HEADER_V2_SIZE) {
+        throw std::runtime_error("Mesh file header is too small.");
+    }
+    uint8_t encoding = loadField<uint8_t>(buffer, 16);
+    if (encoding > 1) {
+        throw std::runtime_error("Mesh file has an unknown encoding.");
+    }
+    header.encoding = encoding == 1 ? MeshFileEncoding::COMPRESSED : MeshFileEncoding::RAW;
+    uint8_t indexBytes = loadField<uint8_t>(buffer, 17);
+    if (indexBytes != 2 && indexBytes != 4) {
+        throw std::runtime_error("Mesh file has an unknown index size.");
+    }
+    header.indexType = static_cast<MeshIndexType>(indexBytes);
+    header.attribCount = loadField<uint8_t>(buffer, 18);
+    header.vertexCount = loadField<uint64_t>(buffer, 24);
+    header.indexCount = loadField<uint64_t>(buffer, 32);
+    header.indexSection.offset = loadField<uint64_t>(buffer, 40);
+    header.indexSection.size = loadField<uint64_t>(buffer, 48);
+    header.lodCount = 0;
+    header.lodTableOffset = 0;
+    return header;
+}
+
+// buffer holds the first HEADER_V2_BOUNDS_SIZE bytes of the file
+inline std::optional<MeshBounds> unpackFileBoundsV2(const char* buffer) {
+    if ((loadField<uint32_t>(buffer, 64) & HEADER_FLAG_BOUNDS) == 0) {
+        return std::nullopt;
+    }
+    return MeshBounds { loadVec3(buffer, 72), loadVec3(buffer, 84), loadVec3(buffer, 96), loadField<float>(buffer, 108) };
+}
+
+inline void packLodEntry(char* buffer, const LodEntry& entry) {
+    memset(buffer, 0, LOD_ENTRY_SIZE);
+    storeField<uint64_t>(buffer, 0, entry.indexCount);
+    storeField<uint64_t>(buffer, 8, entry.section.offset);
+    storeField<uint64_t>(buffer, 16, entry.section.size);
+    storeField<float>(buffer, 24, entry.error);
+    storeField<uint8_t>(buffer, 28, static_cast<uint8_t>(indexSize(entry.indexType)));
+}
+
+inline LodEntry unpackLodEntry(const char* buffer) {
+    LodEntry entry;
+    entry.indexCount = loadField<uint64_t>(buffer, 0);
+    entry.section.offset = loadField<uint64_t>(buffer, 8);
+    entry.section.size = loadField<uint64_t>(buffer, 16);
+    entry.error = loadField<float>(buffer, 24);
+    uint8_t indexBytes = loadField<uint8_t>(buffer, 28);
+    if (indexBytes != 2 && indexBytes != 4) {
+        throw std::runtime_error("Mesh file level of detail has an unknown index size.");
+    }
+    entry.indexType = static_cast<MeshIndexType>(indexBytes);
+    return entry;
+}
+
+inline void packAttribEntry(char* buffer, const AttribEntry& entry) {
+    if (entry.name.length() >= ATTRIB_NAME_SIZE) {
+        throw std::invalid_argument("Attribute name is too long for a mesh file: " + entry.name);
+    }
+    memset(buffer, 0, ATTRIB_ENTRY_SIZE);
+    memcpy(buffer, entry.name.c_str(), entry.name.length());
+    storeField<uint8_t>(buffer, 32, entry.componentType);
+    storeField<uint8_t>(buffer, 33, entry.numComponents);
+    storeField<uint64_t>(buffer, 40, entry.section.offset);
+    storeField<uint64_t>(buffer, 48, entry.section.size);
+    storeField<uint64_t>(buffer, 56, entry.stride);
+}
+
+inline AttribEntry unpackAttribEntry(const char* buffer) {
+    AttribEntry entry;
+    entry.name.assign(buffer, strnlen(buffer, ATTRIB_NAME_SIZE - 1));
+    entry.componentType = loadField<uint8_t>(buffer, 32);
+    entry.numComponents = loadField<uint8_t>(buffer, 33);
+    entry.section.offset = loadField<uint64_t>(buffer, 40);
+    entry.section.size = loadField<uint64_t>(buffer, 48);
+    entry.stride = loadField<uint64_t>(buffer, 56);
+    return entry;
+}
+
+// Header and attribute descriptions of a mesh file of either version, with the location of every section
+
+struct MeshFileLayout {
+    uint32_t version;
+    uint32_t headerSize;  // of version 2 files
+    MeshFileEncoding encoding;
+    MeshIndexType indexType;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    std::optional<MeshBounds> bounds;
+    std::vector<std::string> attribNames;
+    std::vector<AttribData> attribData;             // offsets relative to vertexBufferPosition, of the decoded buffer if compressed
+    std::vector<MeshFileSection> attribSections;    // raw: first to last element, compressed: the encoded stream
+    MeshFileSection indexSection;                   // raw: the index buffer, compressed: the encoded stream
+    std::vector<LodEntry> lods;                     // of version 2 files
+    size_t vertexBufferPosition;  // offset of the first attribute section
+    size_t vertexSize;            // size of one vertex of all attributes
+};
+
+inline void checkFileRange(size_t fileSize, size_t offset, size_t size) {
+    if (offset > fileSize || size > fileSize - offset) {
+        throw std::runtime_error("Mesh file is truncated.");
+    }
+}
+
+inline size_t attribElementSize(const AttribData& data) {
+    return componentSize(static_cast<MeshAttributeComponentType>(data.componentType)) * data.numComponents;
+}
+
+// bytes from the first to the last element of a raw attribute
+inline uint64_t attribSpan(const AttribData& data, uint64_t vertexCount) {
+    return vertexCount > 0 ? (vertexCount - 1) * data.vertexBufferStride + attribElementSize(data) : 0;
+}
+
+template<typename READ_F>
+void readFileLayoutV1(const READ_F& read, MeshFileLayout& layout) {
+    char headerBuffer[HEADER_SIZE];
+    read(0, headerBuffer, HEADER_SIZE);
+    HeaderData header = unpackFileHeader(headerBuffer);
+    const MeshFileID& fileID = meshFileID(header);
+
+    layout.version = 1;
+    layout.encoding = fileID.encoding;
+    layout.indexType = fileID.indexType;
+    layout.vertexCount = header.vertexCount;
+    layout.indexCount = header.indexCount;
+    layout.attribNames.resize(header.attribCount);
+    layout.attribData.resize(header.attribCount);
+    layout.attribSections.resize(header.attribCount);
+
+    uint64_t position = HEADER_SIZE;
+    for (uint8_t i = 0u; i < header.attribCount; ++i) {
+        // names are limited to 31 characters, longer names are cut off
+        std::string name;
+        char c;
+        while (read(position++, &c, 1), c != '\0') {
+            if (name.length() < ATTRIB_NAME_SIZE - 1) name += c;
+        }
+        layout.attribNames[i] = std::move(name);
+
+        char dataBuffer[ATTRIB_DATA_SIZE];
+        read(position, dataBuffer, ATTRIB_DATA_SIZE);
+        layout.attribData[i] = unpackAttribData(dataBuffer);
+        position += ATTRIB_DATA_SIZE;
+
+        layout.vertexSize += attribElementSize(layout.attribData[i]);
+    }
+
+    layout.vertexBufferPosition = position;
+    const uint64_t indexBytes = layout.indexCount * indexSize(layout.indexType);
+
+    if (layout.encoding == MeshFileEncoding::RAW) {
+        const uint64_t vertexBufferSize = layout.vertexSize * layout.vertexCount;
+        for (uint8_t i = 0u; i < header.attribCount; ++i) {
+            const AttribData& data = layout.attribData[i];
+            const uint64_t span = attribSpan(data, layout.vertexCount);
+            if (data.vertexBufferOffset > vertexBufferSize || span > vertexBufferSize - data.vertexBufferOffset) {
+                throw std::runtime_error("Mesh file has attribute data outside of its vertex buffer.");
+            }
+            layout.attribSections[i] = MeshFileSection { position + data.vertexBufferOffset, span };
+        }
+        layout.indexSection = MeshFileSection { position + vertexBufferSize, indexBytes };
+        return;
+    }
+
+    // compressed streams follow each other, each preceded by its encoded size
+    auto nextStream = [&] () {
+        uint64_t encodedSize;
+        read(position, &encodedSize, sizeof(uint64_t));
+        MeshFileSection section { position + sizeof(uint64_t), encodedSize };
+        position = section.offset + encodedSize;
+        return section;
+    };
+    for (auto& section : layout.attribSections) {
+        section = nextStream();
+    }
+    layout.indexSection = layout.indexCount > 0 ? nextStream() : MeshFileSection { position, 0 };
+}
+
+template<typename READ_F>
+void readFileLayoutV2(const READ_F& read, MeshFileLayout& layout) {
+    char headerBuffer[HEADER_V2_BOUNDS_SIZE];
+    read(0, headerBuffer, HEADER_V2_SIZE);
+    HeaderDataV2 header = unpackFileHeaderV2(headerBuffer);
+    if (header.headerSize >= HEADER_V2_BOUNDS_SIZE) {
+        read(HEADER_V2_SIZE, headerBuffer + HEADER_V2_SIZE, HEADER_V2_BOUNDS_SIZE - HEADER_V2_SIZE);
+        header.bounds = unpackFileBoundsV2(headerBuffer);
+        header.lodCount = loadField<uint32_t>(headerBuffer, 112);
+        header.lodTableOffset = loadField<uint64_t>(headerBuffer, 120);
+    }
+
+    layout.version = header.version;
+    layout.headerSize = header.headerSize;
+    layout.bounds = header.bounds;
+    layout.encoding = header.encoding;
+    layout.indexType = header.indexType;
+    layout.vertexCount = header.vertexCount;
+    layout.indexCount = header.indexCount;
+    layout.indexSection = header.indexSection;
+    layout.attribNames.resize(header.attribCount);
+    layout.attribData.resize(header.attribCount);
+    layout.attribSections.resize(header.attribCount);
+
+    // the whole table is read at once
+    std::vector<char> table(header.attribCount * ATTRIB_ENTRY_SIZE);
+    read(header.headerSize, table.data(), table.size());
+
+    layout.vertexBufferPosition = alignFileOffset(header.headerSize + table.size());
+    for (uint8_t i = 0u; i < header.attribCount; ++i) {
+        AttribEntry entry = unpackAttribEntry(table.data() + i * ATTRIB_ENTRY_SIZE);
+        layout.attribNames[i] = std::move(entry.name);
+        layout.attribData[i] = AttribData { entry.componentType, entry.numComponents, 0, entry.stride };
+        layout.attribSections[i] = entry.section;
+        layout.vertexBufferPosition = std::min<uint64_t>(layout.vertexBufferPosition, entry.section.offset);
+    }
+
+    for (uint8_t i = 0u; i < header.attribCount; ++i) {
+        AttribData& data = layout.attribData[i];
+        const size_t elementSize = attribElementSize(data);
+        if (layout.encoding == MeshFileEncoding::COMPRESSED) {
+            // compressed attributes always decode to non-interleaved buffers
+            data.vertexBufferOffset = layout.vertexSize * layout.vertexCount;
+            data.vertexBufferStride = elementSize;
+        } else {
+            data.vertexBufferOffset = layout.attribSections[i].offset - layout.vertexBufferPosition;
+            if (data.vertexBufferStride < elementSize || layout.attribSections[i].size < attribSpan(data, layout.vertexCount)) {
+                throw std::runtime_error("Mesh file has attribute data outside of its section.");
+            }
+        }
+        layout.vertexSize += elementSize;
+    }
+
+    if (layout.encoding == MeshFileEncoding::RAW && layout.indexSection.size != layout.indexCount * indexSize(layout.indexType)) {
+        throw std::runtime_error("Mesh file index section does not match its index count.");
+    }
+
+    // entries are read one at a time, so a corrupt count runs into the end of the file rather than allocating it all
+    for (uint32_t i = 0; i < header.lodCount; ++i) {
+        char entryBuffer[LOD_ENTRY_SIZE];
+        read(header.lodTableOffset + i * LOD_ENTRY_SIZE, entryBuffer, LOD_ENTRY_SIZE);
+        LodEntry entry = unpackLodEntry(entryBuffer);
+        if (layout.encoding == MeshFileEncoding::RAW && entry.section.size != entry.indexCount * indexSize(entry.indexType)) {
+            throw std::runtime_error("Mesh file level of detail section does not match its index count.");
+        }
+        layout.lods.push_back(entry);
+    }
+}
+
+// read the header and attribute descriptions of a mesh file of either version
+// read(position, dst, size) reads size bytes at position relative to the beginning of the mesh file,
+// and throws if they're past its end
+template<typename READ_F>
+MeshFileLayout readFileLayout(const READ_F& read) {
+    MeshFileLayout layout {};
+
+    char fileID[8];
+    read(0, fileID, sizeof(fileID));
+    if (memcmp(fileID, MESH_FILE_V2_ID, sizeof(fileID)) == 0) {
+        readFileLayoutV2(read, layout);
+    } else {
+        readFileLayoutV1(read, layout);
+    }
+
+    return layout;
+}
+
+// layout of a mesh file held in memory, e.g. through a mapping, with every section checked to be inside of it
+inline MeshFileLayout parseFileLayout(const char* fileData, size_t fileSize) {
+    MeshFileLayout layout = readFileLayout([&] (uint64_t position, void* dst, size_t size) {
+        checkFileRange(fileSize, position, size);
+        memcpy(dst, fileData + position, size);
+    });
+
+    for (const auto& section : layout.attribSections) {
+        checkFileRange(fileSize, section.offset, section.size);
+    }
+    checkFileRange(fileSize, layout.indexSection.offset, layout.indexSection.size);
+    for (const auto& lod : layout.lods) {
+        checkFileRange(fileSize, lod.section.offset, lod.section.size);
+    }
+
+    return layout;
+}
+
+// layout of a mesh file starting at the current position of a seekable stream
+// sections are relative to that position, the stream is left somewhere past the attribute descriptions
+inline MeshFileLayout readStreamLayout(std::istream& fs) {
+    const std::streamoff start = fs.tellg();
+    uint64_t current = 0;
+    return readFileLayout([&] (uint64_t position, void* dst, size_t size) {
+        if (position != current) {
+            fs.seekg(start + static_cast<std::streamoff>(position));
+        }
+        if (!fs.read(static_cast<char*>(dst), size)) {
+            throw std::runtime_error("Mesh file is truncated.");
+        }
+        current = position + size;
+    });
+}
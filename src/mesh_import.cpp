@@ -0,0 +1,959 @@
+#include <mesh_import.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <mapped_file.hpp>
+#include <parallel_for.hpp>
+
+
+// bytes of text each parse task takes, large enough that the per-task setup is negligible
+static constexpr size_t PARSE_CHUNK_SIZE = 4 << 20;
+
+// binary PLY faces each parse task takes
+static constexpr size_t PLY_FACE_CHUNK = 1 << 18;
+
+// corners each welding task takes
+static constexpr size_t WELD_BLOCK_SIZE = 1 << 20;
+
+// the welding hash table is split into 2^WELD_SHARD_BITS shards, each filled by one task
+static constexpr unsigned WELD_SHARD_BITS = 6;
+
+static constexpr uint32_t NO_CORNER = std::numeric_limits<uint32_t>::max();
+
+
+// Vertex welding
+//
+// Every triangle corner refers to source values through up to three indices, for OBJ's separate
+// position, texture coordinate and normal lists. Each imported attribute reads its values through one of them.
+// Corners are hashed by value and split into shards by the top bits of their hash,
+// so every shard can be deduplicated on its own thread with a private open addressing table.
+
+using Corner = std::array<uint32_t, 3>;
+
+struct WeldAttribute {
+    MeshAttribute attribute;
+    int numComponents;
+    const float* values;
+    unsigned slot;
+};
+
+static inline uint64_t mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// values are hashed and compared bitwise, so 0.0 and -0.0 stay apart, but NaNs still weld
+static uint64_t hashCorner(const std::vector<WeldAttribute>& attributes, const Corner& corner) {
+    uint64_t h = 0;
+    for (const auto& attribute : attributes) {
+        const float* values = attribute.values + size_t(corner[attribute.slot]) * attribute.numComponents;
+        for (int i = 0; i < attribute.numComponents; ++i) {
+            uint32_t bits;
+            memcpy(&bits, &values[i], sizeof(bits));
+            h = mix64(h ^ bits) + 0x9e3779b97f4a7c15ull;
+        }
+    }
+    return mix64(h);
+}
+
+static bool cornersEqual(const std::vector<WeldAttribute>& attributes, const Corner& a, const Corner& b) {
+    for (const auto& attribute : attributes) {
+        const uint32_t ia = a[attribute.slot], ib = b[attribute.slot];
+        if (ia != ib && memcmp(attribute.values + size_t(ia) * attribute.numComponents,
+                attribute.values + size_t(ib) * attribute.numComponents, attribute.numComponents * sizeof(float)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// files without faces, e.g. point cloud scans, keep every vertex as it is, without indices
+static Mesh importPoints(const std::vector<WeldAttribute>& attributes, size_t numVertices) {
+    Mesh mesh(numVertices);
+    for (const auto& attribute : attributes) {
+        auto& buffer = mesh.createAttributeBuffer(attribute.attribute, MeshAttributeComponentType::FLOAT, attribute.numComponents);
+        memcpy(buffer.data(), attribute.values, numVertices * attribute.numComponents * sizeof(float));
+    }
+    return mesh;
+}
+
+static Mesh weldCorners(const std::vector<WeldAttribute>& attributes, const std::vector<Corner>& corners, unsigned numThreads) {
+    const size_t numCorners = corners.size();
+    if (numCorners >= NO_CORNER) {
+        throw std::runtime_error("Mesh has too many triangles to import.");
+    }
+    const size_t numBlocks = (numCorners + WELD_BLOCK_SIZE - 1) / WELD_BLOCK_SIZE;
+    const size_t numShards = size_t(1) << WELD_SHARD_BITS;
+
+    std::vector<uint64_t> hashes(numCorners);
+    std::vector<size_t> shardOffsets(numBlocks * numShards, 0);
+    parallelFor(numBlocks, 1, [&] (size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            size_t* counts = &shardOffsets[b * numShards];
+            for (size_t c = b * WELD_BLOCK_SIZE; c < std::min(numCorners, (b + 1) * WELD_BLOCK_SIZE); ++c) {
+                hashes[c] = hashCorner(attributes, corners[c]);
+                ++counts[hashes[c] >> (64 - WELD_SHARD_BITS)];
+            }
+        }
+    }, numThreads);
+
+    // stable scatter of the corners into shards, so each shard lists its corners in file order
+    std::vector<size_t> shardBegin(numShards + 1, 0);
+    size_t offset = 0;
+    for (size_t s = 0; s < numShards; ++s) {
+        shardBegin[s] = offset;
+        for (size_t b = 0; b < numBlocks; ++b) {
+            const size_t count = shardOffsets[b * numShards + s];
+            shardOffsets[b * numShards + s] = offset;
+            offset += count;
+        }
+    }
+    shardBegin[numShards] = offset;
+
+    std::vector<uint32_t> order(numCorners);
+    parallelFor(numBlocks, 1, [&] (size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            size_t* offsets = &shardOffsets[b * numShards];
+            for (size_t c = b * WELD_BLOCK_SIZE; c < std::min(numCorners, (b + 1) * WELD_BLOCK_SIZE); ++c) {
+                order[offsets[hashes[c] >> (64 - WELD_SHARD_BITS)]++] = static_cast<uint32_t>(c);
+            }
+        }
+    }, numThreads);
+
+    // the first corner with each value represents every later corner with the same value
+    std::vector<uint32_t> representative(numCorners);
+    parallelFor(numShards, 1, [&] (size_t begin, size_t end) {
+        std::vector<uint32_t> table;
+        for (size_t s = begin; s < end; ++s) {
+            const size_t count = shardBegin[s + 1] - shardBegin[s];
+            size_t tableSize = 16;
+            while (tableSize < 2 * count) tableSize <<= 1;
+            table.assign(tableSize, NO_CORNER);
+            const size_t mask = tableSize - 1;
+
+            for (size_t i = shardBegin[s]; i < shardBegin[s + 1]; ++i) {
+                const uint32_t c = order[i];
+                size_t slot = hashes[c] & mask;
+                while (table[slot] != NO_CORNER &&
+                        (hashes[table[slot]] != hashes[c] || !cornersEqual(attributes, corners[table[slot]], corners[c]))) {
+                    slot = (slot + 1) & mask;
+                }
+                if (table[slot] == NO_CORNER) {
+                    table[slot] = c;
+                }
+                representative[c] = table[slot];
+            }
+        }
+    }, numThreads);
+    hashes = std::vector<uint64_t>();
+
+    // number the vertices in the order their representatives appear
+    std::vector<size_t> blockVertices(numBlocks + 1, 0);
+    parallelFor(numBlocks, 1, [&] (size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            for (size_t c = b * WELD_BLOCK_SIZE; c < std::min(numCorners, (b + 1) * WELD_BLOCK_SIZE); ++c) {
+                blockVertices[b + 1] += representative[c] == c;
+            }
+        }
+    }, numThreads);
+    for (size_t b = 0; b < numBlocks; ++b) {
+        blockVertices[b + 1] += blockVertices[b];
+    }
+
+    Mesh mesh(blockVertices[numBlocks]);
+    std::vector<float*> dst;
+    for (const auto& attribute : attributes) {
+        auto& buffer = mesh.createAttributeBuffer(attribute.attribute, MeshAttributeComponentType::FLOAT, attribute.numComponents);
+        dst.push_back(static_cast<float*>(buffer.data()));
+    }
+
+    // order is no longer needed, reuse it for the vertex of each representative corner
+    std::vector<uint32_t>& vertexOf = order;
+    parallelFor(numBlocks, 1, [&] (size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            uint32_t vertex = static_cast<uint32_t>(blockVertices[b]);
+            for (size_t c = b * WELD_BLOCK_SIZE; c < std::min(numCorners, (b + 1) * WELD_BLOCK_SIZE); ++c) {
+                if (representative[c] != c) continue;
+                for (size_t a = 0; a < attributes.size(); ++a) {
+                    const int n = attributes[a].numComponents;
+                    memcpy(dst[a] + size_t(vertex) * n, attributes[a].values + size_t(corners[c][attributes[a].slot]) * n, n * sizeof(float));
+                }
+                vertexOf[c] = vertex++;
+            }
+        }
+    }, numThreads);
+
+    mesh.indices().resize(numCorners);
+    mesh.indices().visit([&] (auto* indices) {
+        using INDEX_T = std::remove_pointer_t<decltype(indices)>;
+        parallelFor(numCorners, WELD_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                indices[c] = static_cast<INDEX_T>(vertexOf[representative[c]]);
+            }
+        }, numThreads);
+    });
+
+    return mesh;
+}
+
+
+// Text parsing helpers
+
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline const char* skipSpace(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+static inline const char* lineEnd(const char* p, const char* end) {
+    const char* n = static_cast<const char*>(memchr(p, '\n', end - p));
+    return n ? n : end;
+}
+
+// start of the first line beginning at or after offset
+static size_t alignToLine(const char* data, size_t size, size_t offset) {
+    if (offset == 0 || offset >= size) return std::min(offset, size);
+    const char* n = static_cast<const char*>(memchr(data + offset - 1, '\n', size - offset + 1));
+    return n ? n - data + 1 : size;
+}
+
+template<typename T>
+static inline bool parseNumber(const char*& p, const char* end, T& value) {
+    p = skipSpace(p, end);
+    if (p < end && *p == '+') ++p;
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+}
+
+static std::runtime_error parseError(const std::string& fileName, const std::string& what) {
+    return std::runtime_error("Cannot import " + fileName + ": " + what);
+}
+
+static bool hasExtension(const std::string& fileName, const char* extension) {
+    const size_t n = strlen(extension);
+    if (fileName.size() < n) return false;
+    return std::equal(fileName.end() - n, fileName.end(), extension, [] (char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == b;
+    });
+}
+
+
+// OBJ
+
+// a corner index as it appears in an OBJ chunk, before the positions of earlier chunks are known
+// 0: no index, > 0: 1-based index into the whole file, < 0: relative index resolved against the chunk, plus OBJ_LOCAL_BIAS
+static constexpr int64_t OBJ_LOCAL_BIAS = -(int64_t(1) << 62);
+
+struct ObjChunk {
+    std::vector<float> positions, colors, normals, texCoords;
+    std::vector<std::array<int64_t, 3>> corners;
+    size_t numColored = 0;
+    size_t numTexCoordCorners = 0, numNormalCorners = 0;
+};
+
+// slots of OBJ corner indices
+enum : unsigned { OBJ_POSITION = 0, OBJ_TEXCOORD = 1, OBJ_NORMAL = 2 };
+
+static bool parseObjCorner(const char*& p, const char* end, const ObjChunk& chunk, std::array<int64_t, 3>& corner) {
+    const size_t localCounts[3] = { chunk.positions.size() / 3, chunk.texCoords.size() / 2, chunk.normals.size() / 3 };
+    corner = { 0, 0, 0 };
+    for (unsigned slot = 0; slot < 3; ++slot) {
+        if (slot > 0) {
+            if (p >= end || *p != '/') break;
+            ++p;
+            // v//vn leaves out the texture coordinate
+            if (p < end && *p == '/') continue;
+        }
+        int64_t index;
+        if (!parseNumber(p, end, index) || index == 0 || index >= -OBJ_LOCAL_BIAS || index <= OBJ_LOCAL_BIAS) return false;
+        corner[slot] = index > 0 ? index : int64_t(localCounts[slot]) + index + OBJ_LOCAL_BIAS;
+    }
+    return p >= end || isSpace(*p);
+}
+
+static void parseObjLine(const char* p, const char* end, ObjChunk& chunk, const std::string& fileName) {
+    p = skipSpace(p, end);
+    if (p + 1 >= end) return;
+
+    float values[7];
+    if (p[0] == 'v' && isSpace(p[1])) {
+        p += 2;
+        int n = 0;
+        while (n < 7 && parseNumber(p, end, values[n])) ++n;
+        if (n < 3) throw parseError(fileName, "malformed vertex position.");
+        chunk.positions.insert(chunk.positions.end(), values, values + 3);
+        if (n >= 6) {
+            chunk.colors.insert(chunk.colors.end(), values + 3, values + 6);
+            ++chunk.numColored;
+        }
+    } else if (p[0] == 'v' && p[1] == 't' && p + 2 < end && isSpace(p[2])) {
+        p += 3;
+        int n = 0;
+        while (n < 3 && parseNumber(p, end, values[n])) ++n;
+        if (n < 1) throw parseError(fileName, "malformed texture coordinate.");
+        chunk.texCoords.push_back(values[0]);
+        chunk.texCoords.push_back(n > 1 ? values[1] : 0.0f);
+    } else if (p[0] == 'v' && p[1] == 'n' && p + 2 < end && isSpace(p[2])) {
+        p += 3;
+        int n = 0;
+        while (n < 3 && parseNumber(p, end, values[n])) ++n;
+        if (n < 3) throw parseError(fileName, "malformed vertex normal.");
+        chunk.normals.insert(chunk.normals.end(), values, values + 3);
+    } else if (p[0] == 'f' && isSpace(p[1])) {
+        p += 2;
+        std::array<int64_t, 3> first, previous, corner;
+        size_t n = 0;
+        for (p = skipSpace(p, end); p < end; p = skipSpace(p, end)) {
+            if (!parseObjCorner(p, end, chunk, corner)) throw parseError(fileName, "malformed face.");
+            if (n >= 2) {
+                chunk.corners.push_back(first);
+                chunk.corners.push_back(previous);
+                chunk.corners.push_back(corner);
+                chunk.numTexCoordCorners += (first[OBJ_TEXCOORD] != 0) + (previous[OBJ_TEXCOORD] != 0) + (corner[OBJ_TEXCOORD] != 0);
+                chunk.numNormalCorners += (first[OBJ_NORMAL] != 0) + (previous[OBJ_NORMAL] != 0) + (corner[OBJ_NORMAL] != 0);
+            } else if (n == 0) {
+                first = corner;
+            }
+            previous = corner;
+            ++n;
+        }
+        if (n < 3) throw parseError(fileName, "face with fewer than three vertices.");
+    }
+}
+
+Mesh importObjMesh(const std::string& fileName, unsigned numThreads) {
+    MappedFile file(fileName);
+    const char* data = file.data();
+    const size_t size = file.size();
+
+    // each chunk parses the lines that begin inside its byte range
+    const size_t numChunks = std::max<size_t>(1, (size + PARSE_CHUNK_SIZE - 1) / PARSE_CHUNK_SIZE);
+    std::vector<ObjChunk> chunks(numChunks);
+    parallelFor(numChunks, 1, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const char* p = data + alignToLine(data, size, i * PARSE_CHUNK_SIZE);
+            const char* chunkEnd = data + alignToLine(data, size, std::min(size, (i + 1) * PARSE_CHUNK_SIZE));
+            while (p < chunkEnd) {
+                const char* e = lineEnd(p, chunkEnd);
+                parseObjLine(p, e, chunks[i], fileName);
+                p = e + 1;
+            }
+        }
+    }, numThreads);
+
+    // offsets of each chunk's values and corners in the whole file
+    struct ChunkOffsets { size_t positions, colors, normals, texCoords, corners; };
+    std::vector<ChunkOffsets> offsets(numChunks + 1, ChunkOffsets {});
+    size_t numColored = 0, numTexCoordCorners = 0, numNormalCorners = 0;
+    for (size_t i = 0; i < numChunks; ++i) {
+        const ObjChunk& chunk = chunks[i];
+        offsets[i + 1] = ChunkOffsets {
+            offsets[i].positions + chunk.positions.size(),
+            offsets[i].colors + chunk.colors.size(),
+            offsets[i].normals + chunk.normals.size(),
+            offsets[i].texCoords + chunk.texCoords.size(),
+            offsets[i].corners + chunk.corners.size() };
+        numColored += chunk.numColored;
+        numTexCoordCorners += chunk.numTexCoordCorners;
+        numNormalCorners += chunk.numNormalCorners;
+    }
+    const ChunkOffsets& totals = offsets[numChunks];
+    const size_t counts[3] = { totals.positions / 3, totals.texCoords / 2, totals.normals / 3 };
+    if (counts[OBJ_POSITION] > NO_CORNER) {
+        throw parseError(fileName, "too many vertices.");
+    }
+
+    // an attribute is only imported if every corner has it
+    const bool hasColors = numColored > 0 && numColored == counts[OBJ_POSITION];
+    const bool hasTexCoords = totals.corners > 0 && numTexCoordCorners == totals.corners;
+    const bool hasNormals = totals.corners > 0 && numNormalCorners == totals.corners;
+
+    std::vector<float> positions(totals.positions), colors(hasColors ? totals.colors : 0),
+        normals(hasNormals ? totals.normals : 0), texCoords(hasTexCoords ? totals.texCoords : 0);
+    std::vector<Corner> corners(totals.corners);
+    parallelFor(numChunks, 1, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            ObjChunk& chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + offsets[i].positions);
+            if (hasColors) std::copy(chunk.colors.begin(), chunk.colors.end(), colors.begin() + offsets[i].colors);
+            if (hasNormals) std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + offsets[i].normals);
+            if (hasTexCoords) std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + offsets[i].texCoords);
+
+            const size_t chunkStarts[3] = { offsets[i].positions / 3, offsets[i].texCoords / 2, offsets[i].normals / 3 };
+            for (size_t c = 0; c < chunk.corners.size(); ++c) {
+                Corner& corner = corners[offsets[i].corners + c];
+                for (unsigned slot = 0; slot < 3; ++slot) {
+                    const int64_t raw = chunk.corners[c][slot];
+                    if (raw == 0) {
+                        corner[slot] = 0;
+                        continue;
+                    }
+                    const int64_t index = raw > 0 ? raw - 1 : int64_t(chunkStarts[slot]) + (raw - OBJ_LOCAL_BIAS);
+                    if (index < 0 || uint64_t(index) >= counts[slot]) {
+                        throw parseError(fileName, "face index out of range.");
+                    }
+                    corner[slot] = static_cast<uint32_t>(index);
+                }
+            }
+            chunk = ObjChunk();
+        }
+    }, numThreads);
+    chunks.clear();
+
+    std::vector<WeldAttribute> attributes { { MeshAttribute::POSITION, 3, positions.data(), OBJ_POSITION } };
+    if (hasNormals) attributes.push_back({ MeshAttribute::NORMAL, 3, normals.data(), OBJ_NORMAL });
+    if (hasTexCoords) attributes.push_back({ MeshAttribute::TEXCOORD, 2, texCoords.data(), OBJ_TEXCOORD });
+    if (hasColors) attributes.push_back({ MeshAttribute::COLOR, 3, colors.data(), OBJ_POSITION });
+
+    if (corners.empty()) {
+        return importPoints(attributes, counts[OBJ_POSITION]);
+    }
+    return weldCorners(attributes, corners, numThreads);
+}
+
+
+// PLY
+
+enum class PlyType { INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64 };
+
+enum class PlyFormat { ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN };
+
+struct PlyProperty {
+    std::string name;
+    PlyType type;
+    bool isList;
+    PlyType countType;
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count;
+    std::vector<PlyProperty> properties;
+};
+
+static bool parsePlyType(const std::string& name, PlyType& type) {
+    static const std::pair<const char*, PlyType> names[] = {
+        { "char", PlyType::INT8 }, { "int8", PlyType::INT8 },
+        { "uchar", PlyType::UINT8 }, { "uint8", PlyType::UINT8 },
+        { "short", PlyType::INT16 }, { "int16", PlyType::INT16 },
+        { "ushort", PlyType::UINT16 }, { "uint16", PlyType::UINT16 },
+        { "int", PlyType::INT32 }, { "int32", PlyType::INT32 },
+        { "uint", PlyType::UINT32 }, { "uint32", PlyType::UINT32 },
+        { "float", PlyType::FLOAT32 }, { "float32", PlyType::FLOAT32 },
+        { "double", PlyType::FLOAT64 }, { "float64", PlyType::FLOAT64 }
+    };
+    for (const auto& [n, t] : names) {
+        if (name == n) {
+            type = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+static constexpr size_t plyTypeSize(PlyType type) {
+    switch (type) {
+    case PlyType::INT8:
+    case PlyType::UINT8:
+        return 1;
+    case PlyType::INT16:
+    case PlyType::UINT16:
+        return 2;
+    case PlyType::INT32:
+    case PlyType::UINT32:
+    case PlyType::FLOAT32:
+        return 4;
+    case PlyType::FLOAT64:
+        return 8;
+    }
+    return 0;
+}
+
+// integer colors are scaled by the largest value of their type
+static constexpr double plyColorScale(PlyType type) {
+    switch (type) {
+    case PlyType::INT8:
+        return 1.0 / 127.0;
+    case PlyType::UINT8:
+        return 1.0 / 255.0;
+    case PlyType::INT16:
+        return 1.0 / 32767.0;
+    case PlyType::UINT16:
+        return 1.0 / 65535.0;
+    case PlyType::INT32:
+        return 1.0 / 2147483647.0;
+    case PlyType::UINT32:
+        return 1.0 / 4294967295.0;
+    default:
+        return 1.0;
+    }
+}
+
+template<typename T>
+static inline T loadPly(const char* p, bool swapBytes) {
+    char bytes[sizeof(T)];
+    memcpy(bytes, p, sizeof(T));
+    if (swapBytes) std::reverse(bytes, bytes + sizeof(T));
+    T value;
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+static inline double readPlyValue(const char* p, PlyType type, bool swapBytes) {
+    switch (type) {
+    case PlyType::INT8: return loadPly<int8_t>(p, swapBytes);
+    case PlyType::UINT8: return loadPly<uint8_t>(p, swapBytes);
+    case PlyType::INT16: return loadPly<int16_t>(p, swapBytes);
+    case PlyType::UINT16: return loadPly<uint16_t>(p, swapBytes);
+    case PlyType::INT32: return loadPly<int32_t>(p, swapBytes);
+    case PlyType::UINT32: return loadPly<uint32_t>(p, swapBytes);
+    case PlyType::FLOAT32: return loadPly<float>(p, swapBytes);
+    case PlyType::FLOAT64: return loadPly<double>(p, swapBytes);
+    }
+    return 0.0;
+}
+
+static inline int64_t readPlyInt(const char* p, PlyType type, bool swapBytes) {
+    switch (type) {
+    case PlyType::INT8: return loadPly<int8_t>(p, swapBytes);
+    case PlyType::UINT8: return loadPly<uint8_t>(p, swapBytes);
+    case PlyType::INT16: return loadPly<int16_t>(p, swapBytes);
+    case PlyType::UINT16: return loadPly<uint16_t>(p, swapBytes);
+    case PlyType::INT32: return loadPly<int32_t>(p, swapBytes);
+    case PlyType::UINT32: return loadPly<uint32_t>(p, swapBytes);
+    case PlyType::FLOAT32: return static_cast<int64_t>(loadPly<float>(p, swapBytes));
+    case PlyType::FLOAT64: return static_cast<int64_t>(loadPly<double>(p, swapBytes));
+    }
+    return 0;
+}
+
+// where each vertex property goes: an attribute array and component, with the scale applied to the value
+struct PlyVertexTarget {
+    int attribute = -1;
+    int component = 0;
+    double scale = 1.0;
+};
+
+enum : int { PLY_POSITION, PLY_NORMAL, PLY_TEXCOORD, PLY_COLOR, PLY_NUM_ATTRIBUTES };
+
+// the vertex attributes of a PLY file, and how to fill them from the vertex properties
+struct PlyVertexLayout {
+    std::vector<PlyVertexTarget> targets;
+    int numComponents[PLY_NUM_ATTRIBUTES] = {};
+};
+
+static PlyVertexLayout getPlyVertexLayout(const PlyElement& vertex, const std::string& fileName) {
+    static const std::tuple<const char*, int, int> names[] = {
+        { "x", PLY_POSITION, 0 }, { "y", PLY_POSITION, 1 }, { "z", PLY_POSITION, 2 },
+        { "nx", PLY_NORMAL, 0 }, { "ny", PLY_NORMAL, 1 }, { "nz", PLY_NORMAL, 2 },
+        { "u", PLY_TEXCOORD, 0 }, { "v", PLY_TEXCOORD, 1 },
+        { "s", PLY_TEXCOORD, 0 }, { "t", PLY_TEXCOORD, 1 },
+        { "texture_u", PLY_TEXCOORD, 0 }, { "texture_v", PLY_TEXCOORD, 1 },
+        { "red", PLY_COLOR, 0 }, { "green", PLY_COLOR, 1 }, { "blue", PLY_COLOR, 2 }, { "alpha", PLY_COLOR, 3 }
+    };
+    static const int required[PLY_NUM_ATTRIBUTES] = { 0b111, 0b111, 0b11, 0b111 };
+
+    PlyVertexLayout layout;
+    layout.targets.resize(vertex.properties.size());
+    int found[PLY_NUM_ATTRIBUTES] = {};
+    for (size_t i = 0; i < vertex.properties.size(); ++i) {
+        const PlyProperty& property = vertex.properties[i];
+        for (const auto& [name, attribute, component] : names) {
+            if (property.name == name && !property.isList) {
+                layout.targets[i] = PlyVertexTarget { attribute, component, attribute == PLY_COLOR ? plyColorScale(property.type) : 1.0 };
+                found[attribute] |= 1 << component;
+            }
+        }
+    }
+
+    // attributes missing a component are left out, only the position is required
+    if ((found[PLY_POSITION] & required[PLY_POSITION]) != required[PLY_POSITION]) {
+        throw parseError(fileName, "vertices have no x, y and z properties.");
+    }
+    for (int a = 0; a < PLY_NUM_ATTRIBUTES; ++a) {
+        if ((found[a] & required[a]) == required[a]) {
+            layout.numComponents[a] = (found[a] & 0b1000) ? 4 : (a == PLY_TEXCOORD ? 2 : 3);
+        }
+    }
+    for (auto& target : layout.targets) {
+        if (target.attribute >= 0 && layout.numComponents[target.attribute] == 0) {
+            target.attribute = -1;
+        }
+    }
+    return layout;
+}
+
+static size_t findFaceIndexProperty(const PlyElement& face, const std::string& fileName) {
+    for (size_t i = 0; i < face.properties.size(); ++i) {
+        const PlyProperty& property = face.properties[i];
+        if (property.isList && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+            return i;
+        }
+    }
+    throw parseError(fileName, "faces have no vertex_indices property.");
+}
+
+// fan triangulate one face into corners, checking its indices
+template<typename GetIndex>
+static void addPlyFace(Corner* corners, size_t count, GetIndex&& getIndex, size_t numVertices, const std::string& fileName) {
+    uint32_t first = 0, previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const int64_t index = getIndex(i);
+        if (index < 0 || uint64_t(index) >= numVertices) {
+            throw parseError(fileName, "face index out of range.");
+        }
+        const uint32_t vertex = static_cast<uint32_t>(index);
+        if (i >= 2) {
+            *corners++ = Corner { first, first, first };
+            *corners++ = Corner { previous, previous, previous };
+            *corners++ = Corner { vertex, vertex, vertex };
+        } else if (i == 0) {
+            first = vertex;
+        }
+        previous = vertex;
+    }
+}
+
+static inline size_t numFaceCorners(int64_t count) {
+    return count >= 3 ? 3 * size_t(count - 2) : 0;
+}
+
+// size of one binary element record without lists
+static size_t plyRecordSize(const PlyElement& element) {
+    size_t size = 0;
+    for (const auto& property : element.properties) {
+        if (property.isList) return 0;
+        size += plyTypeSize(property.type);
+    }
+    return size;
+}
+
+// size of one binary property value or list at p, stops at end
+static size_t plyPropertySize(const PlyProperty& property, const char* p, const char* end, bool swapBytes, const std::string& fileName) {
+    if (!property.isList) {
+        return plyTypeSize(property.type);
+    }
+    if (size_t(end - p) < plyTypeSize(property.countType)) throw parseError(fileName, "file is truncated.");
+    const int64_t count = readPlyInt(p, property.countType, swapBytes);
+    if (count < 0) throw parseError(fileName, "negative list length.");
+    return plyTypeSize(property.countType) + size_t(count) * plyTypeSize(property.type);
+}
+
+// size of the binary element record at p, stops at end
+static size_t plyRecordSize(const PlyElement& element, const char* p, const char* end, bool swapBytes, const std::string& fileName) {
+    size_t size = 0;
+    for (const auto& property : element.properties) {
+        size += plyPropertySize(property, p + size, end, swapBytes, fileName);
+        if (size_t(end - p) < size) throw parseError(fileName, "file is truncated.");
+    }
+    return size;
+}
+
+// the index list of the binary face record at p
+static const char* plyFaceIndices(const PlyElement& face, size_t indexProperty, const char* p, const char* end, bool swapBytes, const std::string& fileName) {
+    for (size_t i = 0; i < indexProperty; ++i) {
+        p += plyPropertySize(face.properties[i], p, end, swapBytes, fileName);
+    }
+    return p;
+}
+
+// parsed vertex attributes and face corners of a PLY file
+struct PlyData {
+    std::vector<float> attributes[PLY_NUM_ATTRIBUTES];
+    std::vector<Corner> corners;
+};
+
+static void readPlyBinary(const char* p, const char* dataEnd, const std::vector<PlyElement>& elements, bool swapBytes,
+        const PlyVertexLayout& layout, PlyData& ply, const std::string& fileName, unsigned numThreads) {
+
+    for (const PlyElement& element : elements) {
+        if (element.name == "vertex") {
+            const size_t recordSize = plyRecordSize(element);
+            if (recordSize == 0) throw parseError(fileName, "vertices with list properties are not supported.");
+            if (size_t(dataEnd - p) / recordSize < element.count) throw parseError(fileName, "file is truncated.");
+
+            std::vector<size_t> propertyOffsets;
+            size_t offset = 0;
+            for (const auto& property : element.properties) {
+                propertyOffsets.push_back(offset);
+                offset += plyTypeSize(property.type);
+            }
+
+            const char* vertices = p;
+            parallelFor(element.count, PLY_FACE_CHUNK, [&] (size_t begin, size_t end) {
+                for (size_t v = begin; v < end; ++v) {
+                    const char* record = vertices + v * recordSize;
+                    for (size_t i = 0; i < element.properties.size(); ++i) {
+                        const PlyVertexTarget& target = layout.targets[i];
+                        if (target.attribute < 0) continue;
+                        const double value = readPlyValue(record + propertyOffsets[i], element.properties[i].type, swapBytes);
+                        ply.attributes[target.attribute][v * layout.numComponents[target.attribute] + target.component] =
+                            static_cast<float>(value * target.scale);
+                    }
+                }
+            }, numThreads);
+            p += element.count * recordSize;
+        } else if (element.name == "face") {
+            const size_t indexProperty = findFaceIndexProperty(element, fileName);
+            const PlyProperty& indices = element.properties[indexProperty];
+
+            // faces vary in length, so a light sequential pass over the list lengths finds where each chunk starts
+            struct FaceChunk { const char* data; size_t corners; };
+            std::vector<FaceChunk> faceChunks;
+            size_t numCorners = 0;
+            for (size_t f = 0; f < element.count; ++f) {
+                if (f % PLY_FACE_CHUNK == 0) faceChunks.push_back(FaceChunk { p, numCorners });
+                const size_t recordSize = plyRecordSize(element, p, dataEnd, swapBytes, fileName);
+                const char* list = plyFaceIndices(element, indexProperty, p, dataEnd, swapBytes, fileName);
+                numCorners += numFaceCorners(readPlyInt(list, indices.countType, swapBytes));
+                p += recordSize;
+            }
+            faceChunks.push_back(FaceChunk { p, numCorners });
+
+            ply.corners.resize(numCorners);
+            const size_t numVertices = ply.attributes[PLY_POSITION].size() / 3;
+            parallelFor(faceChunks.size() - 1, 1, [&] (size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const char* record = faceChunks[i].data;
+                    Corner* corners = ply.corners.data() + faceChunks[i].corners;
+                    for (size_t f = i * PLY_FACE_CHUNK; f < std::min(element.count, (i + 1) * PLY_FACE_CHUNK); ++f) {
+                        const char* list = plyFaceIndices(element, indexProperty, record, dataEnd, swapBytes, fileName);
+                        const int64_t count = readPlyInt(list, indices.countType, swapBytes);
+                        const char* items = list + plyTypeSize(indices.countType);
+                        addPlyFace(corners, size_t(count), [&] (size_t k) {
+                            return readPlyInt(items + k * plyTypeSize(indices.type), indices.type, swapBytes);
+                        }, numVertices, fileName);
+                        corners += numFaceCorners(count);
+                        record += plyRecordSize(element, record, dataEnd, swapBytes, fileName);
+                    }
+                }
+            }, numThreads);
+        } else {
+            const size_t recordSize = plyRecordSize(element);
+            if (recordSize > 0) {
+                if (size_t(dataEnd - p) / recordSize < element.count) throw parseError(fileName, "file is truncated.");
+                p += element.count * recordSize;
+            } else {
+                for (size_t i = 0; i < element.count; ++i) {
+                    p += plyRecordSize(element, p, dataEnd, swapBytes, fileName);
+                }
+            }
+        }
+    }
+}
+
+static void readPlyAscii(const char* body, size_t size, const std::vector<PlyElement>& elements,
+        const PlyVertexLayout& layout, PlyData& ply, const std::string& fileName, unsigned numThreads) {
+
+    // each element is one line, so counting the lines of every chunk tells which element each of its lines holds
+    const size_t numChunks = std::max<size_t>(1, (size + PARSE_CHUNK_SIZE - 1) / PARSE_CHUNK_SIZE);
+    std::vector<size_t> chunkLines(numChunks + 1, 0);
+    parallelFor(numChunks, 1, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const char* p = body + alignToLine(body, size, i * PARSE_CHUNK_SIZE);
+            const char* chunkEnd = body + alignToLine(body, size, std::min(size, (i + 1) * PARSE_CHUNK_SIZE));
+            for (; p < chunkEnd; p = lineEnd(p, chunkEnd) + 1) {
+                ++chunkLines[i + 1];
+            }
+        }
+    }, numThreads);
+    for (size_t i = 0; i < numChunks; ++i) {
+        chunkLines[i + 1] += chunkLines[i];
+    }
+
+    // first line of each element, and of the element after the last
+    std::vector<size_t> elementLines(elements.size() + 1, 0);
+    for (size_t e = 0; e < elements.size(); ++e) {
+        elementLines[e + 1] = elementLines[e] + elements[e].count;
+    }
+    if (chunkLines[numChunks] < elementLines.back()) {
+        throw parseError(fileName, "file is truncated.");
+    }
+
+    const size_t numVertices = ply.attributes[PLY_POSITION].size() / 3;
+    std::vector<std::vector<Corner>> chunkCorners(numChunks);
+    parallelFor(numChunks, 1, [&] (size_t begin, size_t end) {
+        std::vector<double> values;
+        std::vector<int64_t> indices;
+        for (size_t i = begin; i < end; ++i) {
+            const char* p = body + alignToLine(body, size, i * PARSE_CHUNK_SIZE);
+            const char* chunkEnd = body + alignToLine(body, size, std::min(size, (i + 1) * PARSE_CHUNK_SIZE));
+            size_t line = chunkLines[i];
+            size_t e = std::upper_bound(elementLines.begin(), elementLines.end(), line) - elementLines.begin() - 1;
+            for (; p < chunkEnd && line < elementLines.back(); p = lineEnd(p, chunkEnd) + 1, ++line) {
+                while (line >= elementLines[e + 1]) ++e;
+                const PlyElement& element = elements[e];
+                if (element.name != "vertex" && element.name != "face") continue;
+
+                const char* lineEndPtr = lineEnd(p, chunkEnd);
+                const char* q = p;
+                const size_t index = line - elementLines[e];
+                for (size_t j = 0; j < element.properties.size(); ++j) {
+                    const PlyProperty& property = element.properties[j];
+                    if (property.isList) {
+                        int64_t count;
+                        if (!parseNumber(q, lineEndPtr, count) || count < 0) throw parseError(fileName, "malformed list.");
+                        indices.resize(size_t(count));
+                        for (auto& item : indices) {
+                            if (!parseNumber(q, lineEndPtr, item)) throw parseError(fileName, "malformed list.");
+                        }
+                        if (element.name == "face" && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                            std::vector<Corner>& corners = chunkCorners[i];
+                            const size_t first = corners.size();
+                            corners.resize(first + numFaceCorners(count));
+                            addPlyFace(corners.data() + first, indices.size(), [&] (size_t k) { return indices[k]; }, numVertices, fileName);
+                        }
+                    } else {
+                        double value;
+                        if (!parseNumber(q, lineEndPtr, value)) throw parseError(fileName, "malformed property value.");
+                        if (element.name == "vertex" && layout.targets[j].attribute >= 0) {
+                            const PlyVertexTarget& target = layout.targets[j];
+                            ply.attributes[target.attribute][index * layout.numComponents[target.attribute] + target.component] =
+                                static_cast<float>(value * target.scale);
+                        }
+                    }
+                }
+            }
+        }
+    }, numThreads);
+
+    std::vector<size_t> cornerOffsets(numChunks + 1, 0);
+    for (size_t i = 0; i < numChunks; ++i) {
+        cornerOffsets[i + 1] = cornerOffsets[i] + chunkCorners[i].size();
+    }
+    ply.corners.resize(cornerOffsets[numChunks]);
+    parallelFor(numChunks, 1, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            std::copy(chunkCorners[i].begin(), chunkCorners[i].end(), ply.corners.begin() + cornerOffsets[i]);
+            chunkCorners[i] = std::vector<Corner>();
+        }
+    }, numThreads);
+}
+
+Mesh importPlyMesh(const std::string& fileName, unsigned numThreads) {
+    MappedFile file(fileName);
+    const char* data = file.data();
+    const char* end = data + file.size();
+
+    // the header is short, parse it as whitespace separated words line by line
+    auto readLine = [&] (const char*& p, std::vector<std::string>& words) {
+        if (p >= end) throw parseError(fileName, "header has no end_header line.");
+        const char* e = lineEnd(p, end);
+        words.clear();
+        for (const char* q = skipSpace(p, e); q < e; q = skipSpace(q, e)) {
+            const char* w = q;
+            while (q < e && !isSpace(*q)) ++q;
+            words.emplace_back(w, q);
+        }
+        p = e < end ? e + 1 : e;
+    };
+
+    const char* p = data;
+    std::vector<std::string> words;
+    readLine(p, words);
+    if (words.size() != 1 || words[0] != "ply") {
+        throw parseError(fileName, "not a PLY file.");
+    }
+
+    PlyFormat format = PlyFormat::ASCII;
+    bool hasFormat = false;
+    std::vector<PlyElement> elements;
+    for (;;) {
+        readLine(p, words);
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info") {
+            continue;
+        } else if (words[0] == "end_header") {
+            break;
+        } else if (words[0] == "format" && words.size() == 3) {
+            if (words[1] == "ascii") format = PlyFormat::ASCII;
+            else if (words[1] == "binary_little_endian") format = PlyFormat::BINARY_LITTLE_ENDIAN;
+            else if (words[1] == "binary_big_endian") format = PlyFormat::BINARY_BIG_ENDIAN;
+            else throw parseError(fileName, "unknown format " + words[1] + ".");
+            hasFormat = true;
+        } else if (words[0] == "element" && words.size() == 3) {
+            size_t count;
+            const char* w = words[2].c_str();
+            if (!parseNumber(w, w + words[2].size(), count)) throw parseError(fileName, "malformed element count.");
+            elements.push_back(PlyElement { words[1], count, {} });
+        } else if (words[0] == "property" && !elements.empty()) {
+            PlyProperty property { words.back(), PlyType::UINT8, false, PlyType::UINT8 };
+            if (words.size() == 5 && words[1] == "list") {
+                property.isList = true;
+                if (!parsePlyType(words[2], property.countType) || !parsePlyType(words[3], property.type)) {
+                    throw parseError(fileName, "unknown property type.");
+                }
+            } else if (words.size() != 3 || !parsePlyType(words[1], property.type)) {
+                throw parseError(fileName, "malformed property.");
+            }
+            elements.back().properties.push_back(property);
+        } else {
+            throw parseError(fileName, "malformed header line " + words[0] + ".");
+        }
+    }
+    if (!hasFormat) {
+        throw parseError(fileName, "header has no format line.");
+    }
+
+    auto vertexElement = std::find_if(elements.begin(), elements.end(), [] (const PlyElement& e) { return e.name == "vertex"; });
+    if (vertexElement == elements.end()) {
+        throw parseError(fileName, "file has no vertex element.");
+    }
+    if (vertexElement->count > NO_CORNER) {
+        throw parseError(fileName, "too many vertices.");
+    }
+    const PlyVertexLayout layout = getPlyVertexLayout(*vertexElement, fileName);
+
+    PlyData ply;
+    for (int a = 0; a < PLY_NUM_ATTRIBUTES; ++a) {
+        ply.attributes[a].resize(vertexElement->count * layout.numComponents[a]);
+    }
+
+    if (format == PlyFormat::ASCII) {
+        readPlyAscii(p, end - p, elements, layout, ply, fileName, numThreads);
+    } else {
+        uint16_t one = 1;
+        const bool littleEndianHost = *reinterpret_cast<const uint8_t*>(&one) == 1;
+        const bool swapBytes = littleEndianHost != (format == PlyFormat::BINARY_LITTLE_ENDIAN);
+        readPlyBinary(p, end, elements, swapBytes, layout, ply, fileName, numThreads);
+    }
+
+    // every PLY attribute is read through the vertex index, in slot 0
+    static const MeshAttribute meshAttributes[PLY_NUM_ATTRIBUTES] = {
+        MeshAttribute::POSITION, MeshAttribute::NORMAL, MeshAttribute::TEXCOORD, MeshAttribute::COLOR
+    };
+    std::vector<WeldAttribute> attributes;
+    for (int a = 0; a < PLY_NUM_ATTRIBUTES; ++a) {
+        if (layout.numComponents[a] > 0) {
+            attributes.push_back({ meshAttributes[a], layout.numComponents[a], ply.attributes[a].data(), 0 });
+        }
+    }
+    if (ply.corners.empty()) {
+        return importPoints(attributes, vertexElement->count);
+    }
+    return weldCorners(attributes, ply.corners, numThreads);
+}
+
+Mesh importMesh(const std::string& fileName, unsigned numThreads) {
+    if (hasExtension(fileName, ".obj")) {
+        return importObjMesh(fileName, numThreads);
+    }
+    if (hasExtension(fileName, ".ply")) {
+        return importPlyMesh(fileName, numThreads);
+    }
+    throw std::invalid_argument("Unknown mesh file extension: " + fileName);
+}
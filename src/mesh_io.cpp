@@ -1,462 +1,1266 @@
-#include <mesh_io.hpp>
-
-#include <cstring>
-#include <iostream>
-#include <stdexcept>
-
-
-MeshWriter::MeshWriter(const std::string& fileName) :
-        _fs(fileName, std::ios::out | std::ios::binary) {
-    if (!_fs) {
-        throw std::runtime_error("Cannot write file: " + fileName);
-    }
-}
-
-MeshReader::MeshReader(const std::string& fileName) :
-        _fs(fileName, std::ios::in | std::ios::binary) {
-    if (!_fs) {
-        throw std::runtime_error("Cannot read file: " + fileName);
-    }
-}
-
-// methods for translating mesh attribute enums and strings
-// these are temporary since I think the mesh system will switch to just using attribute string
-// internally, for greater flexiblity in allowing the user to define new attributes
-
-static std::string getAttributeName(MeshAttribute attrib) {
-    switch (attrib) {
-    case MeshAttribute::POSITION:
-        return "position";
-    case MeshAttribute::NORMAL:
-        return "normal";
-    case MeshAttribute::TEXCOORD:
-        return "texCoord";
-    case MeshAttribute::COLOR:
-        return "color";
-    case MeshAttribute::BONE_INDS:
-        return "boneInds";
-    case MeshAttribute::BONE_WEIGHTS:
-        return "boneWeights";
-    default:
-        return "unknown";
-    }
-}
-
-static MeshAttribute getAttributeFromName(const std::string& name) {
-    // string comparison ordering of accepted tokens:
-    // "boneInds"
-    // "boneWeights"
-    // "color"
-    // "normal"
-    // "position"
-    // "texCoord"
-    // do a sort of binary search for these strings
-    int cmp = name.compare("normal");
-    if (cmp == 0) return MeshAttribute::NORMAL;
-    if (cmp < 0) {
-        cmp = name.compare("boneWeights");
-        if (cmp == 0) return MeshAttribute::BONE_WEIGHTS;
-        if (cmp < 0) {
-            cmp = name.compare("boneInds");
-            if (cmp == 0) return MeshAttribute::BONE_INDS;
-        } else {
-            cmp = name.compare("color");
-            if (cmp == 0) return MeshAttribute::COLOR;
-        }
-    } else {
-        cmp = name.compare("texCoord");
-        if (cmp == 0) return MeshAttribute::TEXCOORD;
-        if (cmp < 0) {
-            cmp = name.compare("position");
-            if (cmp == 0) return MeshAttribute::POSITION;
-        } else {
-
-        }
-    }
-    throw std::runtime_error("No conversion defined for attribute name: " + name);
-}
-
-struct HeaderData {
-    char fileID[8];
-    uint8_t attribCount;
-    uint64_t vertexCount;
-    uint64_t indexCount;
-};
-
-struct AttribData {
-    uint8_t componentType;
-    uint8_t numComponents;
-    uint64_t vertexBufferOffset;
-    uint64_t vertexBufferStride;
-};
-
-static constexpr size_t HEADER_SIZE = 25;
-static constexpr size_t ATTRIB_DATA_SIZE = 18;
-
-static void packFileHeader(char* buffer, const HeaderData& header) {
-    memcpy(buffer, header.fileID, sizeof(HeaderData::fileID));
-    size_t offset = sizeof(HeaderData::fileID);
-    memcpy(buffer + offset, &header.attribCount, sizeof(uint8_t));
-    offset += sizeof(uint8_t);
-    memcpy(buffer + offset, &header.vertexCount, sizeof(uint64_t));
-    offset += sizeof(uint64_t);
-    memcpy(buffer + offset, &header.indexCount, sizeof(uint64_t));
-}
-
-static HeaderData unpackFileHeader(const char* buffer) {
-    HeaderData header;
-    memcpy(header.fileID, buffer, sizeof(HeaderData::fileID));
-    size_t offset = sizeof(HeaderData::fileID);
-    memcpy(&header.attribCount, buffer + offset, sizeof(uint8_t));
-    offset += sizeof(uint8_t);
-    memcpy(&header.vertexCount, buffer + offset, sizeof(uint64_t));
-    offset += sizeof(uint64_t);
-    memcpy(&header.indexCount, buffer + offset, sizeof(uint64_t));
-    return header;
-}
-
-static void packAttribData(char* buffer, const AttribData& data) {
-    memcpy(buffer, &data.componentType, sizeof(uint8_t));
-    size_t offset = sizeof(uint8_t);
-    memcpy(buffer + offset, &data.numComponents, sizeof(uint8_t));
-    offset += sizeof(uint8_t);
-    memcpy(buffer + offset, &data.vertexBufferOffset, sizeof(uint64_t));
-    offset += sizeof(uint64_t);
-    memcpy(buffer + offset, &data.vertexBufferStride, sizeof(uint64_t));
-}
-
-static AttribData unpackAttribData(const char* buffer) {
-    AttribData data;
-    data.componentType = *(reinterpret_cast<const uint8_t*>(buffer));
-    size_t offset = sizeof(uint8_t);
-    data.numComponents = *(reinterpret_cast<const uint8_t*>(buffer + offset));
-    offset += sizeof(uint8_t);
-    data.vertexBufferOffset = *(reinterpret_cast<const uint64_t*>(buffer + offset));
-    offset += sizeof(uint64_t);
-    data.vertexBufferStride = *(reinterpret_cast<const uint64_t*>(buffer + offset));
-    return data;
-}
-
-static void writeMeshAttributesInterleaved(std::ofstream& fs, const Mesh& mesh, const std::vector<std::string>& attribNames) {
-    
-    std::cout << "Writing attribute descriptions" << std::endl;
-
-    // compute vertex size
-    uint64_t vertexSize = 0;
-    for (auto i = 0u; i < mesh.numAttributes(); ++i) {
-        vertexSize += mesh.getAttributeBuffer(i).elementSize();
-    }
-    
-    // write attrib descriptions
-    uint64_t offset = 0;
-    for (auto i = 0u; i < mesh.numAttributes(); ++i) {
-        fs.write(attribNames[i].c_str(), attribNames[i].length() + 1);
-        
-        const auto& attribBuffer = mesh.getAttributeBuffer(i);
-
-        char dataBuffer[ATTRIB_DATA_SIZE];
-        AttribData data;
-        data.componentType = static_cast<uint8_t>(attribBuffer.componentType());
-        data.numComponents = attribBuffer.numComponents();
-        data.vertexBufferOffset = offset;
-        data.vertexBufferStride = vertexSize;
-        packAttribData(dataBuffer, data);
-
-        fs.write(dataBuffer, ATTRIB_DATA_SIZE);
-
-        offset += attribBuffer.elementSize();
-    }
-
-    std::cout << "Writing vertex buffer" << std::endl;
-
-    for (size_t i = 0u; i < mesh.numVertices(); ++i) {
-        int progress = 100 * (float (i) / (float) mesh.numVertices());
-        std::cout << "\rWriting vertex " << (i+1) << " / " << mesh.numVertices() << " [" << progress << "%]           " << std::flush;
-        
-        std::vector<char> vdata(vertexSize);
-
-        offset = 0;
-        for (auto j = 0u; j < mesh.numAttributes(); ++j) {
-            const auto& attribBuffer = mesh.getAttributeBuffer(j);
-
-            memcpy(&vdata[offset], attribBuffer.elementPtr(i), attribBuffer.elementSize());
-            
-            offset += attribBuffer.elementSize();
-        }
-
-        fs.write(vdata.data(), vertexSize);
-    }
-
-    std::cout << std::endl;
-    std::cout << "Finished writing vertex buffer" << std::endl;
-}
-
-static void writeMeshAttributesNonInterleaved(std::ofstream& fs, const Mesh& mesh, const std::vector<std::string>& attribNames) {
-    
-    std::cout << "Writing attribute descriptions" << std::endl;
-    
-    uint64_t offset = 0;
-    for (auto i = 0u; i < mesh.numAttributes(); ++i) {
-        fs.write(attribNames[i].c_str(), attribNames[i].length() + 1);
-        
-        const auto& attribBuffer = mesh.getAttributeBuffer(i);
-
-        char dataBuffer[ATTRIB_DATA_SIZE];
-        AttribData data;
-        data.componentType = static_cast<uint8_t>(attribBuffer.componentType());
-        data.numComponents = attribBuffer.numComponents();
-        data.vertexBufferOffset = offset;
-        data.vertexBufferStride = attribBuffer.elementSize();
-
-        fs.write(dataBuffer, ATTRIB_DATA_SIZE);
-
-        offset += mesh.numVertices() * attribBuffer.elementSize();
-    }
-
-    std::cout << "Writing vertex buffer" << std::endl;
-
-    for (auto i = 0u; i < mesh.numAttributes(); ++i) {
-        int progress = 100 * ((float) i / (float) mesh.numAttributes());
-        std::cout << "\rWriting attribute buffer " << (i+1) << " / " << mesh.numAttributes() << " [" << progress << "%]              " << std::flush;
-        
-        const auto& attribBuffer = mesh.getAttributeBuffer(i);
-        
-        fs.write(static_cast<const char*>(attribBuffer.data()), attribBuffer.elementSize() * mesh.numVertices());
-    }
-
-    std::cout << "Finished writing vertex buffer" << std::endl;
-}
-
-
-
-void MeshWriter::writeMesh(const Mesh& mesh, MeshWriter::AttributeWriteScheme scheme) {
-    if (!_fs) {
-        throw std::runtime_error("Write error.");
-    }
-
-    std::cout << "Writing mesh file..." << std::endl;
-
-    std::cout << "Writing header" << std::endl;
-
-    HeaderData header;
-    strncpy(header.fileID, "meshfile", 8);
-    header.attribCount = mesh.numAttributes();
-    header.vertexCount = mesh.numVertices();
-    header.indexCount = mesh.indices().size();
-
-    // write header
-    char headerBuffer[HEADER_SIZE];
-    packFileHeader(headerBuffer, header);
-    _fs.write(headerBuffer, HEADER_SIZE);
-
-    // get name of all attributes in mesh
-    std::vector<std::string> attribNames(mesh.numAttributes());
-    
-    size_t combinedNameLength = 0;
-    for (auto i = 0u; i < mesh.numAttributes(); ++i) {
-        attribNames[i] = getAttributeName(mesh.getAttributeBuffer(i).getAttribute());
-    }
-    
-
-    std::cout << "Writing vertex attributes" << std::endl;
-
-    // write attribute descriptions and vertex buffer based on scheme
-    switch (scheme) {
-    case AttributeWriteScheme::INTERLEAVED:
-        writeMeshAttributesInterleaved(_fs, mesh, attribNames);
-        break;
-    case AttributeWriteScheme::NON_INTERLEAVED:
-        writeMeshAttributesNonInterleaved(_fs, mesh, attribNames);
-        break;
-    default:
-        throw std::runtime_error("Unimplemented attribute write scheme.");
-    }
-
-    std::cout << "Writing index buffer" << std::endl;
-
-    // write index buffer
-    if (mesh.hasIndices()) {
-        _fs.write(reinterpret_cast<const char*>(mesh.indices().data()), mesh.indices().size() * sizeof(Mesh::index_t));
-    }
-
-    std::cout << "Finished writing mesh." << std::endl;
-}
-
-void createMeshAttributeBuffer(Mesh& mesh, MeshAttribute attribute, MeshAttributeComponentType componentType, uint8_t numComponents) {
-    switch (numComponents) {
-    case 1: {
-        switch (componentType) {
-        case MeshAttributeComponentType::FLOAT:
-            mesh.createAttributeBuffer<float>(attribute);
-            break;
-        case MeshAttributeComponentType::INT:
-            mesh.createAttributeBuffer<int>(attribute);
-            break;
-        case MeshAttributeComponentType::UINT:
-            mesh.createAttributeBuffer<unsigned int>(attribute);
-            break;
-        default:
-            throw std::runtime_error("Unknown attribute component type");
-        }
-        break;
-    }
-    case 2: {
-        switch (componentType) {
-        case MeshAttributeComponentType::FLOAT:
-            mesh.createAttributeBuffer<vecmath::vector<float, 2>>(attribute);
-            break;
-        case MeshAttributeComponentType::INT:
-            mesh.createAttributeBuffer<vecmath::vector<int, 2>>(attribute);
-            break;
-        case MeshAttributeComponentType::UINT:
-            mesh.createAttributeBuffer<vecmath::vector<unsigned int, 2>>(attribute);
-            break;
-        default:
-            throw std::runtime_error("Unknown attribute component type");
-        }
-        break;
-    }
-    case 3: {
-        switch (componentType) {
-        case MeshAttributeComponentType::FLOAT:
-            mesh.createAttributeBuffer<vecmath::vector<float, 3>>(attribute);
-            break;
-        case MeshAttributeComponentType::INT:
-            mesh.createAttributeBuffer<vecmath::vector<int, 3>>(attribute);
-            break;
-        case MeshAttributeComponentType::UINT:
-            mesh.createAttributeBuffer<vecmath::vector<unsigned int, 3>>(attribute);
-            break;
-        default:
-            throw std::runtime_error("Unknown attribute component type");
-        }
-        break;
-    }
-    case 4: {
-        switch (componentType) {
-        case MeshAttributeComponentType::FLOAT:
-            mesh.createAttributeBuffer<vecmath::vector<float, 4>>(attribute);
-            break;
-        case MeshAttributeComponentType::INT:
-            mesh.createAttributeBuffer<vecmath::vector<int, 4>>(attribute);
-            break;
-        case MeshAttributeComponentType::UINT:
-            mesh.createAttributeBuffer<vecmath::vector<unsigned int, 4>>(attribute);
-            break;
-        default:
-            throw std::runtime_error("Unknown attribute component type");
-        }
-        break;
-    }
-    default:
-        throw std::runtime_error("Mesh attribute component count must be 1-4, given: " + std::to_string(numComponents));
-    }
-}
-
-Mesh MeshReader::readMesh() {
-    if (!_fs) {
-        throw std::runtime_error("Read error.");
-    }
-
-    std::cout << "Reading mesh file..." << std::endl;
-
-    std::cout << "Reading header" << std::endl;
-
-    char headerBuffer[HEADER_SIZE];
-    _fs.read(headerBuffer, HEADER_SIZE);
-    HeaderData header = unpackFileHeader(headerBuffer);
-
-    std::cout << "Header data:" << std::endl;
-
-    std::cout << "\tFile ID: " << std::string(header.fileID, 8) << std::endl;
-    std::cout << "\tAttribute count: " << (int) header.attribCount << std::endl;
-    std::cout << "\tVertex count: " << header.vertexCount << std::endl;
-    std::cout << "\tIndex count: " << header.indexCount << std::endl;
-
-    if (std::string("meshfile").compare(std::string(header.fileID, 8)) != 0) {
-        throw std::runtime_error("File does not have a valid mesh file ID.");
-    }
-
-    std::cout << "Initializing mesh" << std::endl;
-
-    Mesh mesh;
-    mesh.setNumVertices(header.vertexCount);
-    if (header.indexCount > 0) {
-        mesh.indices().resize(header.indexCount);
-    }
-
-    std::cout << "Reading vertex attribute descriptions" << std::endl;
-
-    std::vector<uint64_t> attribVertexBufferOffsets(header.attribCount);
-    std::vector<uint64_t> attribVertexBufferStrides(header.attribCount);
-    
-    size_t vertexSize = 0;
-    for (uint8_t i = 0u; i < header.attribCount; ++i) {
-        std::cout << "Reading attribute " << (i+1) << " / " << (int) header.attribCount << std::endl;
-        
-        char attribNameChars[32];
-        for (auto j = 0u; j < 31; ++j) {
-            attribNameChars[j] = _fs.get();
-            if (attribNameChars[j] == '\0') break;
-        }
-        attribNameChars[31] = '\0';
-
-        char dataBuffer[ATTRIB_DATA_SIZE];
-        _fs.read(dataBuffer, ATTRIB_DATA_SIZE);
-        AttribData data = unpackAttribData(dataBuffer);
-
-        std::cout << "Attribute " << (i+1) << ":" << std::endl;
-        std::cout << "\tName: " << attribNameChars << std::endl;
-        std::cout << "\tComponent type: " << (int) data.componentType << std::endl;
-        std::cout << "\tComponent count: " << (int) data.numComponents << std::endl;
-        std::cout << "\tVertex data offset: " << data.vertexBufferOffset << std::endl;
-        std::cout << "\tVertex data stride: " << data.vertexBufferStride << std::endl;
-
-        attribVertexBufferOffsets[i] = data.vertexBufferOffset;
-        attribVertexBufferStrides[i] = data.vertexBufferStride;
-
-        MeshAttribute attribute = getAttributeFromName(attribNameChars);
-        MeshAttributeComponentType componentType = static_cast<MeshAttributeComponentType>(data.componentType);
-
-        createMeshAttributeBuffer(mesh, attribute, componentType, data.numComponents);
-        
-        vertexSize += componentSize(componentType) * data.numComponents;
-    }
-
-    std::cout << "Reading vertex buffer" << std::endl;
-
-    std::vector<char> vertexBufferBytes(vertexSize * header.vertexCount);
-    _fs.read(vertexBufferBytes.data(), vertexBufferBytes.size());
-
-    for (uint8_t i = 0u; i < header.attribCount; ++i) {
-        int progress = 100 * ((float) i / (float) header.attribCount);
-        std::cout << "\rFilling attribute buffer " << (i+1) << " / " << (int) header.attribCount << " [" << progress << "%]      " << std::flush;
-        
-        auto& attribBuffer = mesh.getAttributeBuffer(i);
-
-        auto offset = attribVertexBufferOffsets[i];
-        auto stride = attribVertexBufferStrides[i];
-        auto elementSize = attribBuffer.elementSize();
-        
-        if (stride == elementSize) {
-            memcpy(attribBuffer.data(), &vertexBufferBytes[offset], header.vertexCount * stride);
-        } else {
-            for (size_t j = 0; j < header.vertexCount; ++j) {
-                memcpy(attribBuffer.elementPtr(j), &vertexBufferBytes[offset + j * stride], elementSize);
-            }
-        }
-    }
-
-    std::cout << std::endl;
-    std::cout << "Finished filling attribute buffers" << std::endl;
-
-    vertexBufferBytes.clear();
-
-    std::cout << "Reading index buffer" << std::endl;
-
-    _fs.read(reinterpret_cast<char*>(mesh.indices().data()), header.indexCount * sizeof(Mesh::index_t));
-
-    std::cout << "Finished reading mesh." << std::endl;
-
-    return mesh;
-}
\ No newline at end of file
+#include <mesh_io.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+#include <mapped_file.hpp>
+#include <mesh_codec.hpp>
+#include <parallel_for.hpp>
+#include <strided_copy.hpp>
+
+#include "mesh_file_format.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MeshWriter::MeshWriter(const std::string& fileName) :
+        _fs(fileName, std::ios::out | std::ios::binary),
+        _encoding(Encoding::RAW),
+        _progressInterval(250) {
+    if (!_fs) {
+        throw std::runtime_error("Cannot write file: " + fileName);
+    }
+}
+
+// finish or discard an interrupted patch of fileName before reading it
+static const std::string& recoveredFileName(const std::string& fileName) {
+    recoverMeshFile(fileName);
+    return fileName;
+}
+
+MeshReader::MeshReader(const std::string& fileName) :
+        _fileName(recoveredFileName(fileName)),
+        _file(_fileName, std::ios::in | std::ios::binary),
+        _fs(_file),
+        _progressInterval(250),
+        _memoryResource(std::pmr::get_default_resource()) {
+    if (!_fs) {
+        throw std::runtime_error("Cannot read file: " + fileName);
+    }
+}
+
+MeshReader::MeshReader(std::istream& stream) :
+        _fs(stream),
+        _progressInterval(250),
+        _memoryResource(std::pmr::get_default_resource()) {
+}
+
+MappedMeshReader::MappedMeshReader(const std::string& fileName) :
+        _fileName(recoveredFileName(fileName)),
+        _file(std::make_shared<MappedFile>(_fileName)),
+        _memoryResource(std::pmr::get_default_resource()) {
+}
+
+// size of the staging block used to batch reads and writes
+// large enough to amortize the cost of each read/write call over many vertices
+static constexpr size_t IO_BLOCK_SIZE = 4 << 20;
+
+// decoded bytes below which the sections of a mapped compressed file are not worth decoding in parallel
+static constexpr size_t MIN_PARALLEL_DECODE_SIZE = 4 << 20;
+
+// forwards read/write progress to the user callback, at most once per interval
+// the final update is always reported
+class ProgressReporter {
+
+public:
+
+    ProgressReporter(const MeshIOProgressCallback& callback, std::chrono::milliseconds interval, size_t totalBytes) :
+            _callback(callback),
+            _interval(interval),
+            _totalBytes(totalBytes),
+            _bytesWritten(0),
+            _lastReport(std::chrono::steady_clock::now()) {
+    }
+
+    void advance(size_t numBytes) {
+        _bytesWritten += numBytes;
+        if (!_callback) return;
+        auto now = std::chrono::steady_clock::now();
+        if (_bytesWritten == _totalBytes || now - _lastReport >= _interval) {
+            _lastReport = now;
+            _callback(_bytesWritten, _totalBytes);
+        }
+    }
+
+private:
+
+    const MeshIOProgressCallback& _callback;
+
+    std::chrono::milliseconds _interval;
+
+    size_t _totalBytes, _bytesWritten;
+
+    std::chrono::steady_clock::time_point _lastReport;
+
+};
+
+static void writeBytes(std::ofstream& fs, const char* data, size_t size, ProgressReporter& progress) {
+    // slice large writes so progress can be reported during them
+    while (size > 0) {
+        size_t n = std::min(size, IO_BLOCK_SIZE);
+        fs.write(data, n);
+        progress.advance(n);
+        data += n;
+        size -= n;
+    }
+}
+
+static void readBytes(std::istream& fs, char* data, size_t size, ProgressReporter& progress) {
+    while (size > 0) {
+        size_t n = std::min(size, IO_BLOCK_SIZE);
+        if (!fs.read(data, n)) {
+            throw std::runtime_error("Mesh file is truncated.");
+        }
+        progress.advance(n);
+        data += n;
+        size -= n;
+    }
+}
+
+// pad the file to the next section boundary and return where the section starts
+static uint64_t beginSection(std::ofstream& fs) {
+    static const char padding[MESH_FILE_ALIGNMENT] = {};
+    const uint64_t position = fs.tellp();
+    const uint64_t sectionOffset = alignFileOffset(position);
+    fs.write(padding, sectionOffset - position);
+    return sectionOffset;
+}
+
+// one section holding every attribute, interleaved
+static void writeMeshAttributesInterleaved(std::ofstream& fs, const Mesh& mesh, std::vector<AttribEntry>& entries,
+        std::vector<char>& block, ProgressReporter& progress) {
+
+    const size_t vertexSize = mesh.vertexSize();
+    const uint64_t sectionOffset = beginSection(fs);
+
+    uint64_t offset = 0;
+    for (auto i = 0u; i < mesh.numAttributes(); ++i) {
+        const size_t elementSize = mesh.getAttributeBuffer(i).elementSize();
+        const uint64_t span = mesh.numVertices() > 0 ? (mesh.numVertices() - 1) * vertexSize + elementSize : 0;
+        entries[i].section = MeshFileSection { sectionOffset + offset, span };
+        entries[i].stride = vertexSize;
+        offset += elementSize;
+    }
+
+    std::cout << "Writing vertex buffer" << std::endl;
+
+    if (vertexSize == 0) return;
+
+    // interleave as many vertices as fit into the staging block, then write them all at once
+    const size_t blockVertices = std::max<size_t>(1, IO_BLOCK_SIZE / vertexSize);
+    block.resize(blockVertices * vertexSize);
+
+    for (size_t first = 0u; first < mesh.numVertices(); first += blockVertices) {
+        const size_t count = std::min(blockVertices, mesh.numVertices() - first);
+
+        // fill one attribute at a time so each source buffer is read sequentially
+        offset = 0;
+        for (auto j = 0u; j < mesh.numAttributes(); ++j) {
+            const auto& attribBuffer = mesh.getAttributeBuffer(j);
+            const size_t elementSize = attribBuffer.elementSize();
+            const char* src = static_cast<const char*>(attribBuffer.elementPtr(first));
+            char* dst = block.data() + offset;
+            for (size_t i = 0u; i < count; ++i) {
+                memcpy(dst, src, elementSize);
+                src += elementSize;
+                dst += vertexSize;
+            }
+            offset += elementSize;
+        }
+
+        fs.write(block.data(), count * vertexSize);
+        progress.advance(count * vertexSize);
+    }
+
+    std::cout << "Finished writing vertex buffer" << std::endl;
+}
+
+// one section per attribute
+static void writeMeshAttributesNonInterleaved(std::ofstream& fs, const Mesh& mesh, std::vector<AttribEntry>& entries,
+        ProgressReporter& progress) {
+
+    std::cout << "Writing vertex buffer" << std::endl;
+
+    // buffers are already contiguous, write them straight from their storage
+    for (auto i = 0u; i < mesh.numAttributes(); ++i) {
+        const auto& attribBuffer = mesh.getAttributeBuffer(i);
+        const size_t numBytes = attribBuffer.elementSize() * mesh.numVertices();
+        entries[i].section = MeshFileSection { beginSection(fs), numBytes };
+        entries[i].stride = attribBuffer.elementSize();
+        writeBytes(fs, static_cast<const char*>(attribBuffer.data()), numBytes, progress);
+    }
+
+    std::cout << "Finished writing vertex buffer" << std::endl;
+}
+
+void MeshWriter::setProgressCallback(ProgressCallback callback, std::chrono::milliseconds interval) {
+    _progressCallback = std::move(callback);
+    _progressInterval = interval;
+}
+
+// each attribute buffer and the index buffer compressed into a section of its own
+// so they can be decoded straight into mesh storage
+static void writeMeshCompressed(std::ofstream& fs, const Mesh& mesh, std::vector<AttribEntry>& entries, MeshFileSection& indexSection,
+        std::vector<char>& block, ProgressReporter& progress) {
+
+    std::cout << "Writing compressed vertex buffer" << std::endl;
+
+    MeshStreamCodec codec;
+
+    auto writeStream = [&] (size_t decodedSize) {
+        MeshFileSection section { beginSection(fs), block.size() };
+        fs.write(block.data(), block.size());
+        progress.advance(decodedSize);
+        return section;
+    };
+
+    size_t encodedTotal = 0;
+    for (auto i = 0u; i < mesh.numAttributes(); ++i) {
+        const auto& attribBuffer = mesh.getAttributeBuffer(i);
+        const size_t numBytes = attribBuffer.elementSize() * mesh.numVertices();
+        block.clear();
+        codec.encodeAttributeStream(attribBuffer.data(), numBytes, componentSize(attribBuffer.componentType()), block);
+        encodedTotal += block.size();
+        entries[i].section = writeStream(numBytes);
+        entries[i].stride = attribBuffer.elementSize();
+    }
+
+    if (mesh.hasIndices()) {
+        std::cout << "Writing compressed index buffer" << std::endl;
+
+        block.clear();
+        mesh.indices().visit([&] (const auto* indices) {
+            codec.encodeIndexStream(indices, mesh.indices().size(), block);
+        });
+        encodedTotal += block.size();
+        indexSection = writeStream(mesh.indices().sizeBytes());
+    }
+
+    size_t rawTotal = mesh.vertexSize() * mesh.numVertices() + mesh.indices().sizeBytes();
+    std::cout << "Compressed " << rawTotal << " bytes to " << encodedTotal << " bytes" << std::endl;
+}
+
+// one section per level of detail, raw or compressed like the index buffer, then the table describing them
+static void writeMeshLods(std::ofstream& fs, const Mesh& mesh, HeaderDataV2& header, std::vector<char>& block, ProgressReporter& progress) {
+    header.lodCount = mesh.numLods();
+    header.lodTableOffset = 0;
+    if (mesh.numLods() == 0) return;
+
+    std::cout << "Writing levels of detail" << std::endl;
+
+    MeshStreamCodec codec;
+    std::vector<LodEntry> entries(mesh.numLods());
+    for (size_t i = 0; i < mesh.numLods(); ++i) {
+        const MeshIndexBuffer& indices = mesh.lod(i).indices;
+        entries[i] = LodEntry { indices.size(), indices.indexType(), mesh.lod(i).error, MeshFileSection { 0, 0 } };
+        if (indices.empty()) continue;
+
+        if (header.encoding == MeshFileEncoding::COMPRESSED) {
+            block.clear();
+            indices.visit([&] (const auto* data) {
+                codec.encodeIndexStream(data, indices.size(), block);
+            });
+            entries[i].section = MeshFileSection { beginSection(fs), block.size() };
+            fs.write(block.data(), block.size());
+            progress.advance(indices.sizeBytes());
+        } else {
+            entries[i].section = MeshFileSection { beginSection(fs), indices.sizeBytes() };
+            writeBytes(fs, static_cast<const char*>(indices.data()), indices.sizeBytes(), progress);
+        }
+    }
+
+    header.lodTableOffset = beginSection(fs);
+    block.resize(entries.size() * LOD_ENTRY_SIZE);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        packLodEntry(block.data() + i * LOD_ENTRY_SIZE, entries[i]);
+    }
+    fs.write(block.data(), block.size());
+}
+
+// bytes of the indices of every level of detail
+static size_t lodIndexBytes(const Mesh& mesh) {
+    size_t numBytes = 0;
+    for (size_t i = 0; i < mesh.numLods(); ++i) {
+        numBytes += mesh.lod(i).indices.sizeBytes();
+    }
+    return numBytes;
+}
+
+void MeshWriter::setEncoding(Encoding encoding) noexcept {
+    _encoding = encoding;
+}
+
+void MeshReader::setProgressCallback(ProgressCallback callback, std::chrono::milliseconds interval) {
+    _progressCallback = std::move(callback);
+    _progressInterval = interval;
+}
+
+void MeshReader::setMemoryResource(std::pmr::memory_resource* resource) noexcept {
+    _memoryResource = resource;
+}
+
+// the bounds stored in the header, for meshes with vec3 positions
+static std::optional<MeshBounds> storedBounds(const Mesh& mesh) {
+    if (!mesh.hasAttributeBuffer(MeshAttribute::POSITION) || !mesh.getAttributeBuffer(MeshAttribute::POSITION).hasElementType<vec3>()) {
+        return std::nullopt;
+    }
+    return mesh.bounds();
+}
+
+// cache the bounds stored in the file, once every position has been written to the mesh
+static void setStoredBounds(Mesh& mesh, const MeshFileLayout& layout) {
+    if (layout.bounds && mesh.hasAttributeBuffer(MeshAttribute::POSITION) && mesh.getAttributeBuffer(MeshAttribute::POSITION).hasElementType<vec3>()) {
+        mesh.setBounds(*layout.bounds);
+    }
+}
+
+void MeshWriter::writeMesh(const Mesh& mesh, MeshWriter::AttributeWriteScheme scheme) {
+    if (!_fs) {
+        throw std::runtime_error("Write error.");
+    }
+
+    std::cout << "Writing mesh file..." << std::endl;
+
+    HeaderDataV2 header;
+    header.version = MESH_FILE_VERSION;
+    header.headerSize = HEADER_V2_BOUNDS_SIZE;
+    header.encoding = _encoding == Encoding::COMPRESSED ? MeshFileEncoding::COMPRESSED : MeshFileEncoding::RAW;
+    header.indexType = mesh.indexType();
+    header.attribCount = mesh.numAttributes();
+    header.vertexCount = mesh.numVertices();
+    header.indexCount = mesh.indices().size();
+    header.indexSection = MeshFileSection { 0, 0 };
+    header.bounds = storedBounds(mesh);
+
+    std::vector<AttribEntry> entries(mesh.numAttributes());
+    for (auto i = 0u; i < mesh.numAttributes(); ++i) {
+        const auto& attribBuffer = mesh.getAttributeBuffer(i);
+        entries[i].name = getAttributeName(attribBuffer.getAttribute());
+        entries[i].componentType = static_cast<uint8_t>(attribBuffer.componentType());
+        entries[i].numComponents = attribBuffer.numComponents();
+    }
+
+    // the header and attribute table can only be filled in once every section is written,
+    // space is reserved for them up front
+    std::vector<char> table(header.headerSize + ATTRIB_ENTRY_SIZE * entries.size());
+    _fs.write(table.data(), table.size());
+
+    // progress covers the vertex and index buffers, which is where all the time goes
+    const size_t indexBytes = mesh.indices().sizeBytes();
+    ProgressReporter progress(_progressCallback, _progressInterval, mesh.vertexSize() * mesh.numVertices() + indexBytes + lodIndexBytes(mesh));
+
+    if (_encoding == Encoding::COMPRESSED) {
+        writeMeshCompressed(_fs, mesh, entries, header.indexSection, _block, progress);
+    } else {
+        std::cout << "Writing vertex attributes" << std::endl;
+
+        // write vertex buffer based on scheme
+        switch (scheme) {
+        case AttributeWriteScheme::INTERLEAVED:
+            writeMeshAttributesInterleaved(_fs, mesh, entries, _block, progress);
+            break;
+        case AttributeWriteScheme::NON_INTERLEAVED:
+            writeMeshAttributesNonInterleaved(_fs, mesh, entries, progress);
+            break;
+        default:
+            throw std::runtime_error("Unimplemented attribute write scheme.");
+        }
+
+        std::cout << "Writing index buffer" << std::endl;
+
+        if (mesh.hasIndices()) {
+            header.indexSection = MeshFileSection { beginSection(_fs), indexBytes };
+            writeBytes(_fs, reinterpret_cast<const char*>(mesh.indices().data()), indexBytes, progress);
+        }
+    }
+
+    writeMeshLods(_fs, mesh, header, _block, progress);
+
+    std::cout << "Writing header and attribute table" << std::endl;
+
+    packFileHeaderV2(table.data(), header);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        packAttribEntry(table.data() + header.headerSize + i * ATTRIB_ENTRY_SIZE, entries[i]);
+    }
+    _fs.seekp(0);
+    _fs.write(table.data(), table.size());
+    _fs.seekp(0, std::ios::end);
+
+    if (!_fs) {
+        throw std::runtime_error("Write error.");
+    }
+
+    std::cout << "Finished writing mesh." << std::endl;
+}
+
+// files written before 16-bit indices existed store 32-bit indices for every mesh
+// narrow them on load when the vertex count allows it, out of range indices mean the file is corrupt
+static void narrowIndices(Mesh& mesh) {
+    if (mesh.indexType() != MeshIndexType::UINT32 || minimumIndexType(mesh.numVertices()) != MeshIndexType::UINT16) {
+        return;
+    }
+    try {
+        mesh.indices().setIndexType(MeshIndexType::UINT16);
+    } catch (std::out_of_range&) {
+        throw std::runtime_error("Mesh file has indices outside of its vertex range.");
+    }
+}
+
+// add the levels of detail stored in the file, with room for their indices
+static void addFileLods(Mesh& mesh, const MeshFileLayout& layout) {
+    for (const LodEntry& entry : layout.lods) {
+        MeshLod& lod = mesh.addLod(entry.error);
+        lod.indices.setIndexType(entry.indexType);
+        lod.indices.resize(entry.indexCount);
+    }
+}
+
+// create a buffer owning its storage, or referencing externalData if given
+void createMeshAttributeBuffer(Mesh& mesh, MeshAttribute attribute, MeshAttributeComponentType componentType, uint8_t numComponents,
+        void* externalData = nullptr, const std::shared_ptr<const void>& storageOwner = nullptr) {
+    if (!externalData) {
+        mesh.createAttributeBuffer(attribute, componentType, numComponents);
+        return;
+    }
+    dispatchElementType(componentType, numComponents, [&] (auto tag) {
+        using T = typename decltype(tag)::type;
+        mesh.createAttributeBuffer<T>(attribute, static_cast<T*>(externalData), storageOwner);
+    });
+}
+
+Mesh MeshReader::readMesh() {
+    return readSelectedAttributes(nullptr);
+}
+
+Mesh MeshReader::readMesh(const std::set<MeshAttribute>& attributes) {
+    return readSelectedAttributes(&attributes);
+}
+
+Mesh MeshReader::readSelectedAttributes(const std::set<MeshAttribute>* attributes) {
+    if (!_fs) {
+        throw std::runtime_error("Read error.");
+    }
+
+    std::cout << "Reading mesh file..." << std::endl;
+
+    std::cout << "Reading header" << std::endl;
+
+    // section offsets are relative to where the mesh file starts in the stream
+    const std::streamoff start = _fs.tellg();
+    MeshFileLayout layout = readStreamLayout(_fs);
+    const uint8_t attribCount = layout.attribData.size();
+
+    std::cout << "Header data:" << std::endl;
+
+    std::cout << "\tVersion: " << layout.version << std::endl;
+    std::cout << "\tAttribute count: " << (int) attribCount << std::endl;
+    std::cout << "\tVertex count: " << layout.vertexCount << std::endl;
+    std::cout << "\tIndex count: " << layout.indexCount << std::endl;
+
+    std::cout << "Initializing mesh" << std::endl;
+
+    Mesh mesh(0, _memoryResource);
+    mesh.setNumVertices(layout.vertexCount);
+    mesh.indices().setIndexType(layout.indexType);
+    if (layout.indexCount > 0) {
+        mesh.indices().resize(layout.indexCount);
+    }
+    addFileLods(mesh, layout);
+
+    std::cout << "Reading vertex attribute descriptions" << std::endl;
+
+    std::vector<MeshAttribute> attribs(attribCount);
+    std::vector<size_t> attribElementSizes(attribCount);
+    std::vector<uint8_t> selected;
+    
+    size_t selectedVertexSize = 0;
+    bool selectedContiguous = true;
+    for (uint8_t i = 0u; i < attribCount; ++i) {
+        const AttribData& data = layout.attribData[i];
+
+        std::cout << "Attribute " << (i+1) << ":" << std::endl;
+        std::cout << "\tName: " << layout.attribNames[i] << std::endl;
+        std::cout << "\tComponent type: " << (int) data.componentType << std::endl;
+        std::cout << "\tComponent count: " << (int) data.numComponents << std::endl;
+        std::cout << "\tVertex data offset: " << data.vertexBufferOffset << std::endl;
+        std::cout << "\tVertex data stride: " << data.vertexBufferStride << std::endl;
+
+        MeshAttribute attribute = getAttributeFromName(layout.attribNames[i]);
+        MeshAttributeComponentType componentType = static_cast<MeshAttributeComponentType>(data.componentType);
+
+        attribs[i] = attribute;
+        attribElementSizes[i] = attribElementSize(data);
+
+        if (!attributes || attributes->count(attribute) > 0) {
+            createMeshAttributeBuffer(mesh, attribute, componentType, data.numComponents);
+            selected.push_back(i);
+            selectedVertexSize += attribElementSizes[i];
+            selectedContiguous = selectedContiguous && data.vertexBufferStride == attribElementSizes[i];
+        }
+    }
+
+    // sections are read in file order, seeking only to skip what isn't needed
+    std::sort(selected.begin(), selected.end(), [&] (uint8_t a, uint8_t b) {
+        return layout.attribSections[a].offset < layout.attribSections[b].offset;
+    });
+    auto seekSection = [&] (const MeshFileSection& section) {
+        const std::streamoff offset = start + static_cast<std::streamoff>(section.offset);
+        if (_fs.tellg() != offset && !_fs.seekg(offset)) {
+            throw std::runtime_error("Mesh file is truncated.");
+        }
+    };
+
+    // contiguous attributes are read straight into their buffers, interleaved ones from the span of the file covering them all
+    const bool readSections = layout.encoding == MeshFileEncoding::COMPRESSED || selectedContiguous;
+    uint64_t spanBegin = std::numeric_limits<uint64_t>::max(), spanEnd = 0;
+    for (uint8_t i : selected) {
+        spanBegin = std::min(spanBegin, layout.attribSections[i].offset);
+        spanEnd = std::max(spanEnd, layout.attribSections[i].offset + layout.attribSections[i].size);
+    }
+    const size_t vertexBytesRead = readSections ? selectedVertexSize * layout.vertexCount : (selected.empty() ? 0 : spanEnd - spanBegin);
+
+    const size_t indexBytes = layout.indexCount * indexSize(layout.indexType);
+    ProgressReporter progress(_progressCallback, _progressInterval, vertexBytesRead + indexBytes + lodIndexBytes(mesh));
+
+    if (layout.encoding == MeshFileEncoding::COMPRESSED) {
+        std::cout << "Reading compressed buffers" << std::endl;
+
+        MeshStreamCodec codec;
+        std::vector<char> encoded;
+
+        auto readStream = [&] (const MeshFileSection& section) {
+            seekSection(section);
+            encoded.resize(section.size);
+            if (!_fs.read(encoded.data(), section.size)) {
+                throw std::runtime_error("Mesh file is truncated.");
+            }
+        };
+
+        for (uint8_t i : selected) {
+            auto& attribBuffer = mesh.getAttributeBuffer(attribs[i]);
+            const size_t numBytes = attribBuffer.elementSize() * layout.vertexCount;
+            readStream(layout.attribSections[i]);
+            codec.decodeAttributeStream(encoded.data(), encoded.size(), attribBuffer.data(), numBytes, componentSize(attribBuffer.componentType()));
+            progress.advance(numBytes);
+        }
+
+        if (layout.indexCount > 0) {
+            readStream(layout.indexSection);
+            mesh.indices().visit([&] (auto* indices) {
+                codec.decodeIndexStream(encoded.data(), encoded.size(), indices, layout.indexCount);
+            });
+            progress.advance(indexBytes);
+        }
+
+        for (size_t i = 0; i < layout.lods.size(); ++i) {
+            MeshIndexBuffer& lodIndices = mesh.lod(i).indices;
+            if (lodIndices.empty()) continue;
+            readStream(layout.lods[i].section);
+            lodIndices.visit([&] (auto* indices) {
+                codec.decodeIndexStream(encoded.data(), encoded.size(), indices, lodIndices.size());
+            });
+            progress.advance(lodIndices.sizeBytes());
+        }
+
+        narrowIndices(mesh);
+        setStoredBounds(mesh, layout);
+        mesh.markClean();
+        mesh.setFileName(_fileName);
+
+        std::cout << "Finished reading mesh." << std::endl;
+
+        return mesh;
+    }
+
+    if (readSections) {
+        std::cout << "Reading attribute sections" << std::endl;
+
+        for (uint8_t i : selected) {
+            seekSection(layout.attribSections[i]);
+            readBytes(_fs, static_cast<char*>(mesh.getAttributeBuffer(attribs[i]).data()), attribElementSizes[i] * layout.vertexCount, progress);
+        }
+    } else {
+        std::cout << "Reading vertex buffer" << std::endl;
+
+        std::vector<char> vertexBufferBytes(spanEnd - spanBegin);
+        seekSection(MeshFileSection { spanBegin, spanEnd - spanBegin });
+        readBytes(_fs, vertexBufferBytes.data(), vertexBufferBytes.size(), progress);
+
+        std::cout << "Filling attribute buffers" << std::endl;
+
+        std::vector<StridedCopy> copies;
+        for (uint8_t i : selected) {
+            copies.push_back(StridedCopy { mesh.getAttributeBuffer(attribs[i]).data(), vertexBufferBytes.data() + (layout.attribSections[i].offset - spanBegin),
+                layout.attribData[i].vertexBufferStride, attribElementSizes[i] });
+        }
+
+        deinterleave(copies, layout.vertexCount);
+
+        std::cout << "Finished filling attribute buffers" << std::endl;
+    }
+
+    std::cout << "Reading index buffer" << std::endl;
+
+    if (indexBytes > 0) {
+        seekSection(layout.indexSection);
+        readBytes(_fs, reinterpret_cast<char*>(mesh.indices().data()), indexBytes, progress);
+    }
+
+    for (size_t i = 0; i < layout.lods.size(); ++i) {
+        MeshIndexBuffer& lodIndices = mesh.lod(i).indices;
+        if (lodIndices.empty()) continue;
+        seekSection(layout.lods[i].section);
+        readBytes(_fs, static_cast<char*>(lodIndices.data()), lodIndices.sizeBytes(), progress);
+    }
+
+    narrowIndices(mesh);
+    setStoredBounds(mesh, layout);
+    mesh.markClean();
+    mesh.setFileName(_fileName);
+
+    std::cout << "Finished reading mesh." << std::endl;
+
+    return mesh;
+}
+
+// decode the compressed sections of a mapped file
+// sections are independent of each other, so large meshes decode them in parallel
+static Mesh decodeMappedMesh(const char* fileData, const MeshFileLayout& layout, std::pmr::memory_resource* resource) {
+    Mesh mesh(0, resource);
+    mesh.setNumVertices(layout.vertexCount);
+
+    const size_t numAttributes = layout.attribData.size();
+    for (size_t i = 0; i < numAttributes; ++i) {
+        MeshAttributeComponentType componentType = static_cast<MeshAttributeComponentType>(layout.attribData[i].componentType);
+        createMeshAttributeBuffer(mesh, getAttributeFromName(layout.attribNames[i]), componentType, layout.attribData[i].numComponents);
+    }
+
+    if (layout.indexCount > 0) {
+        mesh.indices().setIndexType(layout.indexType);
+        mesh.indices().resize(layout.indexCount);
+    }
+    addFileLods(mesh, layout);
+
+    // attributes, then the indices if there are any, then the levels of detail
+    const size_t lodBegin = numAttributes + (layout.indexCount > 0 ? 1 : 0);
+    const size_t numSections = lodBegin + layout.lods.size();
+    const size_t decodedSize = layout.vertexSize * layout.vertexCount + mesh.indices().sizeBytes() + lodIndexBytes(mesh);
+    const size_t minRangeSize = decodedSize < MIN_PARALLEL_DECODE_SIZE ? numSections : 1;
+
+    parallelFor(numSections, minRangeSize, [&] (size_t begin, size_t end) {
+        MeshStreamCodec codec;
+        for (size_t i = begin; i < end; ++i) {
+            if (i >= lodBegin) {
+                const MeshFileSection& section = layout.lods[i - lodBegin].section;
+                MeshIndexBuffer& lodIndices = mesh.lod(i - lodBegin).indices;
+                if (lodIndices.empty()) continue;
+                lodIndices.visit([&] (auto* indices) {
+                    codec.decodeIndexStream(fileData + section.offset, section.size, indices, lodIndices.size());
+                });
+                continue;
+            }
+            if (i == numAttributes) {
+                mesh.indices().visit([&] (auto* indices) {
+                    codec.decodeIndexStream(fileData + layout.indexSection.offset, layout.indexSection.size, indices, layout.indexCount);
+                });
+                continue;
+            }
+            auto& attribBuffer = mesh.getAttributeBuffer(i);
+            codec.decodeAttributeStream(fileData + layout.attribSections[i].offset, layout.attribSections[i].size,
+                attribBuffer.data(), attribBuffer.elementSize() * layout.vertexCount, componentSize(attribBuffer.componentType()));
+        }
+    });
+
+    narrowIndices(mesh);
+    setStoredBounds(mesh, layout);
+    mesh.markClean();
+
+    std::cout << "Finished decoding mapped mesh." << std::endl;
+
+    return mesh;
+}
+
+void MappedMeshReader::setMemoryResource(std::pmr::memory_resource* resource) noexcept {
+    _memoryResource = resource;
+}
+
+Mesh MappedMeshReader::readMesh() {
+    const char* fileData = _file->data();
+    const size_t fileSize = _file->size();
+
+    std::cout << "Mapping mesh file..." << std::endl;
+
+    MeshFileLayout layout = parseFileLayout(fileData, fileSize);
+    const uint8_t attribCount = layout.attribData.size();
+    const size_t indexBytes = layout.indexCount * indexSize(layout.indexType);
+
+    std::cout << "\tVersion: " << layout.version << std::endl;
+    std::cout << "\tAttribute count: " << (int) attribCount << std::endl;
+    std::cout << "\tVertex count: " << layout.vertexCount << std::endl;
+    std::cout << "\tIndex count: " << layout.indexCount << std::endl;
+
+    if (layout.encoding == MeshFileEncoding::COMPRESSED) {
+        Mesh mesh = decodeMappedMesh(fileData, layout, _memoryResource);
+        mesh.setFileName(_fileName);
+        return mesh;
+    }
+
+    Mesh mesh(0, _memoryResource);
+    mesh.setNumVertices(layout.vertexCount);
+
+    // attributes that can't be mapped in place are gathered together afterwards
+    std::vector<StridedCopy> copies;
+    size_t numMapped = 0;
+    for (uint8_t i = 0u; i < attribCount; ++i) {
+        const AttribData& data = layout.attribData[i];
+        MeshAttribute attribute = getAttributeFromName(layout.attribNames[i]);
+        MeshAttributeComponentType componentType = static_cast<MeshAttributeComponentType>(data.componentType);
+        size_t elementSize = attribElementSize(data);
+
+        char* attribBytes = _file->data() + layout.attribSections[i].offset;
+
+        // elements can only be referenced in place if they're contiguous and properly aligned for the component type
+        // which version 2 sections always are
+        bool contiguous = data.vertexBufferStride == elementSize;
+        bool aligned = reinterpret_cast<uintptr_t>(attribBytes) % componentSize(componentType) == 0;
+        if (contiguous && aligned) {
+            createMeshAttributeBuffer(mesh, attribute, componentType, data.numComponents, attribBytes, _file);
+            ++numMapped;
+            continue;
+        }
+
+        createMeshAttributeBuffer(mesh, attribute, componentType, data.numComponents);
+        copies.push_back(StridedCopy { mesh.getAttributeBuffer(i).data(), attribBytes, data.vertexBufferStride, elementSize });
+    }
+
+    deinterleave(copies, layout.vertexCount);
+
+    std::cout << "Mapped " << numMapped << " / " << (int) attribCount << " attribute buffers without copying" << std::endl;
+
+    if (layout.indexCount > 0) {
+        mesh.indices().setIndexType(layout.indexType);
+        mesh.indices().resize(layout.indexCount);
+        memcpy(mesh.indices().data(), fileData + layout.indexSection.offset, indexBytes);
+        narrowIndices(mesh);
+    }
+    addFileLods(mesh, layout);
+    for (size_t i = 0; i < layout.lods.size(); ++i) {
+        MeshIndexBuffer& lodIndices = mesh.lod(i).indices;
+        if (lodIndices.empty()) continue;
+        memcpy(lodIndices.data(), fileData + layout.lods[i].section.offset, lodIndices.sizeBytes());
+    }
+    setStoredBounds(mesh, layout);
+    mesh.markClean();
+    mesh.setFileName(_fileName);
+
+    std::cout << "Finished mapping mesh." << std::endl;
+
+    return mesh;
+}
+
+// Incremental save
+
+// true if the dirty flags of mesh describe its changes since it matched the file at fileName
+static bool isMeshFile(const Mesh& mesh, const std::string& fileName) {
+    std::error_code ec;
+    return !mesh.fileName().empty() &&
+        std::filesystem::equivalent(std::filesystem::path(std::string_view(mesh.fileName())), fileName, ec);
+}
+
+// true if the file at fs stores exactly the buffers of mesh, in the given encoding, so its sections can be reused
+static bool fileMatchesMesh(std::istream& fs, const Mesh& mesh, MeshFileEncoding encoding, MeshFileLayout& layout) {
+    try {
+        layout = readStreamLayout(fs);
+    } catch (std::runtime_error&) {
+        return false;
+    }
+
+    if (layout.encoding != encoding || layout.vertexCount != mesh.numVertices() || layout.indexCount != mesh.numIndices() ||
+            layout.indexType != mesh.indexType() || layout.attribData.size() != mesh.numAttributes() || layout.lods.size() != mesh.numLods()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < layout.lods.size(); ++i) {
+        const MeshLod& lod = mesh.lod(i);
+        if (layout.lods[i].indexCount != lod.indices.size() || layout.lods[i].indexType != lod.indices.indexType() ||
+                layout.lods[i].error != lod.error) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < layout.attribData.size(); ++i) {
+        try {
+            const auto& attribBuffer = mesh.getAttributeBuffer(getAttributeFromName(layout.attribNames[i]));
+            if (static_cast<uint8_t>(attribBuffer.componentType()) != layout.attribData[i].componentType ||
+                    attribBuffer.numComponents() != layout.attribData[i].numComponents) {
+                return false;
+            }
+        } catch (std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Patch journal
+//
+// An 8 byte id, then records of a uint64 file offset, a uint64 size and the bytes to write there,
+// ended by a record with offset PATCH_JOURNAL_END and the number of records before it as its size.
+// The file is only written once the end record is, so a journal without one is simply discarded.
+
+static constexpr char PATCH_JOURNAL_ID[9] = "meshjrnl";
+static constexpr size_t PATCH_RECORD_SIZE = 16;
+static constexpr uint64_t PATCH_JOURNAL_END = UINT64_MAX;
+
+static std::string patchJournalName(const std::string& fileName) {
+    return fileName + ".patch";
+}
+
+class PatchJournal {
+
+public:
+
+    explicit PatchJournal(const std::string& fileName) :
+            _fileName(fileName),
+            _fs(fileName, std::ios::out | std::ios::binary | std::ios::trunc),
+            _numRecords(0) {
+        if (!_fs) {
+            throw std::runtime_error("Cannot write file: " + fileName);
+        }
+        _fs.write(PATCH_JOURNAL_ID, 8);
+    }
+
+    void add(uint64_t offset, const char* data, uint64_t size) {
+        writeRecord(offset, size);
+        _fs.write(data, size);
+        ++_numRecords;
+    }
+
+    // end the journal, once this returns the patch is bound to be applied
+    void commit() {
+        writeRecord(PATCH_JOURNAL_END, _numRecords);
+        _fs.close();
+        if (!_fs) {
+            throw std::runtime_error("Cannot write file: " + _fileName);
+        }
+    }
+
+private:
+
+    void writeRecord(uint64_t offset, uint64_t size) {
+        char record[PATCH_RECORD_SIZE];
+        storeField(record, 0, offset);
+        storeField(record, 8, size);
+        _fs.write(record, PATCH_RECORD_SIZE);
+    }
+
+    std::string _fileName;
+
+    std::ofstream _fs;
+
+    uint64_t _numRecords;
+
+};
+
+// Exclusive advisory lock on a patch journal, held by the save writing it until it's applied and removed,
+// so readers recovering the file only ever finish or discard the journal of a save that's gone.
+// Whoever held the lock before may have removed the journal meanwhile, so once locked the file is checked
+// to still be the one at the journal's path.
+
+class PatchJournalLock {
+
+public:
+
+    // wait: create the journal if needed and block until it's locked, for the save writing it
+    // otherwise give up at once if it's gone or locked by a save in progress, for readers
+    PatchJournalLock(const std::string& fileName, bool wait);
+
+    ~PatchJournalLock();
+
+    PatchJournalLock(const PatchJournalLock&) = delete;
+    PatchJournalLock& operator=(const PatchJournalLock&) = delete;
+
+    bool locked() const noexcept;
+
+private:
+
+#ifdef _WIN32
+    HANDLE _file;
+#else
+    int _fd;
+#endif
+
+};
+
+#ifdef _WIN32
+
+// the lock covers a byte far past the end of any journal, so it doesn't get in the way of reading and writing it
+static bool lockJournalByte(HANDLE file, bool wait) {
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = 0;
+    overlapped.OffsetHigh = 0x7fffffff;
+    return LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK | (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY), 0, 1, 0, &overlapped);
+}
+
+static bool isFileAt(HANDLE file, const std::string& fileName) {
+    HANDLE current = CreateFileA(fileName.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (current == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    BY_HANDLE_FILE_INFORMATION locked, found;
+    const bool same = GetFileInformationByHandle(file, &locked) && GetFileInformationByHandle(current, &found) &&
+        locked.dwVolumeSerialNumber == found.dwVolumeSerialNumber &&
+        locked.nFileIndexHigh == found.nFileIndexHigh && locked.nFileIndexLow == found.nFileIndexLow;
+    CloseHandle(current);
+    return same;
+}
+
+PatchJournalLock::PatchJournalLock(const std::string& fileName, bool wait) :
+        _file(INVALID_HANDLE_VALUE) {
+    while (true) {
+        HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, wait ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            if (!wait && GetLastError() == ERROR_FILE_NOT_FOUND) return;
+            throw std::runtime_error("Cannot write file: " + fileName);
+        }
+        if (!lockJournalByte(file, wait)) {
+            const bool busy = GetLastError() == ERROR_LOCK_VIOLATION;
+            CloseHandle(file);
+            if (!wait && busy) return;
+            throw std::runtime_error("Cannot lock file: " + fileName);
+        }
+        if (isFileAt(file, fileName)) {
+            _file = file;
+            return;
+        }
+        CloseHandle(file);
+        if (!wait) return;
+    }
+}
+
+PatchJournalLock::~PatchJournalLock() {
+    if (_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(_file);
+    }
+}
+
+bool PatchJournalLock::locked() const noexcept {
+    return _file != INVALID_HANDLE_VALUE;
+}
+
+#else
+
+static bool isFileAt(int fd, const std::string& fileName) {
+    struct stat locked, found;
+    return fstat(fd, &locked) == 0 && stat(fileName.c_str(), &found) == 0 &&
+        locked.st_dev == found.st_dev && locked.st_ino == found.st_ino;
+}
+
+PatchJournalLock::PatchJournalLock(const std::string& fileName, bool wait) :
+        _fd(-1) {
+    while (true) {
+        int fd = open(fileName.c_str(), wait ? O_RDWR | O_CREAT : O_RDWR, 0666);
+        if (fd < 0) {
+            if (!wait && errno == ENOENT) return;
+            throw std::runtime_error("Cannot write file: " + fileName);
+        }
+        // flock locks belong to the open file, so they also exclude other threads of this process
+        if (flock(fd, wait ? LOCK_EX : LOCK_EX | LOCK_NB) != 0) {
+            const bool busy = errno == EWOULDBLOCK;
+            close(fd);
+            if (!wait && busy) return;
+            throw std::runtime_error("Cannot lock file: " + fileName);
+        }
+        if (isFileAt(fd, fileName)) {
+            _fd = fd;
+            return;
+        }
+        close(fd);
+        if (!wait) return;
+    }
+}
+
+PatchJournalLock::~PatchJournalLock() {
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+bool PatchJournalLock::locked() const noexcept {
+    return _fd >= 0;
+}
+
+#endif
+
+// push the contents of a file, once its stream is flushed or closed, through to the disk so they survive a power loss
+// the directory holding a file has to be synced too for a new, removed or renamed entry to survive one
+
+#ifdef _WIN32
+
+static void syncFile(const std::string& fileName) {
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    const bool synced = file != INVALID_HANDLE_VALUE && FlushFileBuffers(file);
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+    if (!synced) {
+        throw std::runtime_error("Cannot sync file: " + fileName);
+    }
+}
+
+// directories can't be flushed on Windows, NTFS commits their changes through its own log
+static void syncDirectoryOf(const std::string&) {
+}
+
+#else
+
+static void syncPath(const std::string& path, int flags) {
+    int fd = open(path.c_str(), flags);
+    const bool synced = fd >= 0 && fsync(fd) == 0;
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!synced) {
+        throw std::runtime_error("Cannot sync file: " + path);
+    }
+}
+
+static void syncFile(const std::string& fileName) {
+    syncPath(fileName, O_RDONLY);
+}
+
+static void syncDirectoryOf(const std::string& fileName) {
+    const std::filesystem::path directory = std::filesystem::path(fileName).parent_path();
+    syncPath(directory.empty() ? "." : directory.string(), O_RDONLY | O_DIRECTORY);
+}
+
+#endif
+
+// write the records of a complete journal to file, returns false without writing anything if the journal is incomplete
+static bool applyPatchJournal(const std::string& journalFileName, std::ostream& file) {
+    std::ifstream journal(journalFileName, std::ios::in | std::ios::binary);
+    char id[8];
+    if (!journal.read(id, 8) || memcmp(id, PATCH_JOURNAL_ID, 8) != 0) {
+        return false;
+    }
+
+    auto readRecord = [&journal] (uint64_t& offset, uint64_t& size) {
+        char record[PATCH_RECORD_SIZE];
+        if (!journal.read(record, PATCH_RECORD_SIZE)) return false;
+        offset = loadField<uint64_t>(record, 0);
+        size = loadField<uint64_t>(record, 8);
+        return true;
+    };
+
+    // check the whole journal is there before touching the file
+    uint64_t offset, size, numRecords = 0;
+    while (true) {
+        if (!readRecord(offset, size)) return false;
+        if (offset == PATCH_JOURNAL_END) break;
+        if (!journal.seekg(size, std::ios::cur)) return false;
+        ++numRecords;
+    }
+    if (size != numRecords) {
+        return false;
+    }
+
+    journal.clear();
+    journal.seekg(8);
+    std::vector<char> block;
+    for (uint64_t r = 0; r < numRecords; ++r) {
+        readRecord(offset, size);
+        file.seekp(offset);
+        while (size > 0) {
+            block.resize(std::min<uint64_t>(size, IO_BLOCK_SIZE));
+            if (!journal.read(block.data(), block.size())) {
+                throw std::runtime_error("Cannot read file: " + journalFileName);
+            }
+            file.write(block.data(), block.size());
+            size -= block.size();
+        }
+    }
+    return true;
+}
+
+bool recoverMeshFile(const std::string& fileName) {
+    const std::string journalFileName = patchJournalName(fileName);
+    std::error_code ec;
+    if (!std::filesystem::exists(journalFileName, ec)) {
+        return false;
+    }
+
+    // a journal that's still locked belongs to a save in progress, which applies and removes it itself
+    PatchJournalLock journalLock(journalFileName, false);
+    if (!journalLock.locked()) {
+        return false;
+    }
+
+    bool applied = false;
+    {
+        std::fstream fs(fileName, std::ios::in | std::ios::out | std::ios::binary);
+        if (fs && applyPatchJournal(journalFileName, fs)) {
+            fs.flush();
+            if (!fs) {
+                throw std::runtime_error("Cannot write file: " + fileName);
+            }
+            syncFile(fileName);
+            applied = true;
+            std::cout << "Finished interrupted patch of " << fileName << std::endl;
+        }
+    }
+    std::filesystem::remove(journalFileName);
+    return applied;
+}
+
+// journal the elements of one attribute in its section
+// interleaved sections are read back a block at a time so the other attributes' bytes are kept
+static void patchAttributeSection(std::istream& fs, PatchJournal& journal, const MeshAttributeBuffer& attribBuffer,
+        const MeshFileSection& section, uint64_t stride, size_t numVertices, std::vector<char>& block) {
+
+    const size_t elementSize = attribBuffer.elementSize();
+    const char* src = static_cast<const char*>(attribBuffer.data());
+
+    if (stride == elementSize) {
+        journal.add(section.offset, src, elementSize * numVertices);
+        return;
+    }
+
+    const size_t blockVertices = std::max<size_t>(1, IO_BLOCK_SIZE / stride);
+    block.resize((blockVertices - 1) * stride + elementSize);
+    for (size_t first = 0; first < numVertices; first += blockVertices) {
+        const size_t count = std::min(blockVertices, numVertices - first);
+        const size_t span = (count - 1) * stride + elementSize;
+        const uint64_t position = section.offset + first * stride;
+
+        fs.seekg(position);
+        if (!fs.read(block.data(), span)) {
+            throw std::runtime_error("Mesh file is truncated.");
+        }
+        for (size_t i = 0; i < count; ++i) {
+            memcpy(block.data() + i * stride, src + (first + i) * elementSize, elementSize);
+        }
+        journal.add(position, block.data(), span);
+    }
+}
+
+MeshSaveResult saveMesh(const std::string& fileName, Mesh& mesh, MeshWriter::AttributeWriteScheme scheme, MeshWriter::Encoding encoding) {
+    const MeshFileEncoding fileEncoding = encoding == MeshWriter::Encoding::COMPRESSED ? MeshFileEncoding::COMPRESSED : MeshFileEncoding::RAW;
+
+    recoverMeshFile(fileName);
+
+    // the dirty flags say nothing about any other file, e.g. one saved over with save as
+    if (isMeshFile(mesh, fileName)) {
+        std::fstream fs(fileName, std::ios::in | std::ios::out | std::ios::binary);
+        MeshFileLayout layout;
+        if (fs && fileMatchesMesh(fs, mesh, fileEncoding, layout)) {
+            if (!mesh.isDirty()) {
+                return MeshSaveResult::UNCHANGED;
+            }
+
+            // compressed sections change size with their contents, so only raw files can be patched
+            // and files without room for the bounds only while the positions are unchanged
+            const bool hasBoundsBlock = layout.version == MESH_FILE_VERSION && layout.headerSize >= HEADER_V2_BOUNDS_SIZE;
+            const bool positionsDirty = mesh.hasAttributeBuffer(MeshAttribute::POSITION) && mesh.getAttributeBuffer(MeshAttribute::POSITION).isDirty();
+            if (fileEncoding == MeshFileEncoding::RAW && (hasBoundsBlock || !positionsDirty)) {
+                std::cout << "Patching mesh file..." << std::endl;
+
+                const std::string journalFileName = patchJournalName(fileName);
+                PatchJournalLock journalLock(journalFileName, true);
+                try {
+                    PatchJournal journal(journalFileName);
+                    std::vector<char> block;
+                    for (size_t i = 0; i < layout.attribData.size(); ++i) {
+                        const auto& attribBuffer = static_cast<const Mesh&>(mesh).getAttributeBuffer(getAttributeFromName(layout.attribNames[i]));
+                        if (attribBuffer.isDirty()) {
+                            patchAttributeSection(fs, journal, attribBuffer, layout.attribSections[i], layout.attribData[i].vertexBufferStride,
+                                mesh.numVertices(), block);
+                        }
+                    }
+                    if (mesh.indices().isDirty() && layout.indexCount > 0) {
+                        journal.add(layout.indexSection.offset, static_cast<const char*>(static_cast<const Mesh&>(mesh).indices().data()),
+                            layout.indexSection.size);
+                    }
+                    for (size_t i = 0; i < layout.lods.size(); ++i) {
+                        const MeshIndexBuffer& lodIndices = static_cast<const Mesh&>(mesh).lod(i).indices;
+                        if (lodIndices.isDirty() && !lodIndices.empty()) {
+                            journal.add(layout.lods[i].section.offset, static_cast<const char*>(lodIndices.data()), layout.lods[i].section.size);
+                        }
+                    }
+                    if (hasBoundsBlock && (positionsDirty || !layout.bounds)) {
+                        char headerBuffer[HEADER_V2_BOUNDS_SIZE];
+                        packFileBoundsV2(headerBuffer, storedBounds(mesh));
+                        journal.add(HEADER_V2_SIZE, headerBuffer + HEADER_V2_SIZE, HEADER_V2_LODS_OFFSET - HEADER_V2_SIZE);
+                    }
+                    journal.commit();
+                    syncFile(journalFileName);
+                    syncDirectoryOf(journalFileName);
+                } catch (...) {
+                    // the file hasn't been touched yet
+                    std::error_code ec;
+                    std::filesystem::remove(journalFileName, ec);
+                    throw;
+                }
+
+                // from here on an interrupted patch is finished by recoverMeshFile
+                fs.clear();
+                if (!applyPatchJournal(journalFileName, fs)) {
+                    // nothing was written, the mesh stays dirty so the save can be tried again
+                    std::error_code ec;
+                    std::filesystem::remove(journalFileName, ec);
+                    throw std::runtime_error("Cannot read file: " + journalFileName);
+                }
+                fs.flush();
+                if (!fs) {
+                    throw std::runtime_error("Cannot write file: " + fileName);
+                }
+                // the patch has to be on disk before its journal is gone
+                syncFile(fileName);
+                std::filesystem::remove(journalFileName);
+
+                std::cout << "Finished patching mesh file." << std::endl;
+
+                mesh.markClean();
+                return MeshSaveResult::PATCHED;
+            }
+        }
+    }
+
+    const std::string tmpFileName = fileName + ".tmp";
+    try {
+        {
+            MeshWriter writer(tmpFileName);
+            writer.setEncoding(encoding);
+            writer.writeMesh(mesh, scheme);
+        }
+        // otherwise the rename could reach the disk before the contents, leaving an empty file after a power loss
+        syncFile(tmpFileName);
+    } catch (...) {
+        std::error_code ec;
+        std::filesystem::remove(tmpFileName, ec);
+        throw;
+    }
+    std::filesystem::rename(tmpFileName, fileName);
+    syncDirectoryOf(fileName);
+
+    mesh.markClean();
+    mesh.setFileName(fileName);
+    return MeshSaveResult::REWRITTEN;
+}
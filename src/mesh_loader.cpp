@@ -0,0 +1,151 @@
+#include <mesh_loader.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+#include <mesh_io.hpp>
+#include <parallel_for.hpp>
+
+
+MeshLoadCancelled::MeshLoadCancelled(const std::string& fileName) :
+        std::runtime_error("Mesh load cancelled: " + fileName) {
+}
+
+// Handle
+
+MeshLoader::Handle::Handle(std::shared_ptr<LoadState> state, std::future<Mesh>&& future) :
+        _state(std::move(state)),
+        _future(std::move(future)) {
+}
+
+bool MeshLoader::Handle::ready() const {
+    return _future.valid() && _future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+float MeshLoader::Handle::progress() const noexcept {
+    if (!_state) return 0.0f;
+    size_t total = _state->totalBytes.load(std::memory_order_relaxed);
+    if (total == 0) return 0.0f;
+    return (float) _state->bytesRead.load(std::memory_order_relaxed) / (float) total;
+}
+
+void MeshLoader::Handle::cancel() noexcept {
+    if (_state) {
+        _state->cancelRequested.store(true, std::memory_order_relaxed);
+    }
+}
+
+Mesh MeshLoader::Handle::get() {
+    if (!_future.valid()) {
+        throw std::logic_error("Mesh load handle has no result.");
+    }
+    return _future.get();
+}
+
+bool MeshLoader::Handle::valid() const noexcept {
+    return _future.valid();
+}
+
+// MeshLoader
+
+MeshLoader::MeshLoader(unsigned int numThreads) :
+        _stopping(false) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    _workers.reserve(numThreads);
+    try {
+        for (auto i = 0u; i < numThreads; ++i) {
+            _workers.emplace_back(&MeshLoader::workerMain, this);
+        }
+    } catch (...) {
+        // the destructor doesn't run for a constructor that throws, stop the workers already started here
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _condition.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+        throw;
+    }
+}
+
+MeshLoader::~MeshLoader() {
+    std::deque<Job> pending;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        pending.swap(_jobs);
+    }
+    _condition.notify_all();
+
+    for (auto& job : pending) {
+        job.promise.set_exception(std::make_exception_ptr(MeshLoadCancelled(job.fileName)));
+    }
+
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+MeshLoader::Handle MeshLoader::load(const std::string& fileName) {
+    Job job { fileName, std::make_shared<LoadState>(), std::promise<Mesh>() };
+    Handle handle(job.state, job.promise.get_future());
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(job));
+    }
+    _condition.notify_one();
+    return handle;
+}
+
+void MeshLoader::workerMain() {
+    // the workers already load meshes in parallel, so the parallel parts of each load run inline
+    ParallelWorkerScope worker;
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+            if (_jobs.empty()) return;
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+        runJob(job);
+    }
+}
+
+void MeshLoader::runJob(Job& job) {
+    LoadState& state = *job.state;
+    try {
+        if (state.cancelRequested.load(std::memory_order_relaxed)) {
+            throw MeshLoadCancelled(job.fileName);
+        }
+
+        MeshReader reader(job.fileName);
+
+        // report every block, it's only a couple of atomic stores
+        // and it's where a cancelled load gets interrupted
+        reader.setProgressCallback([&] (size_t bytesRead, size_t totalBytes) {
+            state.totalBytes.store(totalBytes, std::memory_order_relaxed);
+            state.bytesRead.store(bytesRead, std::memory_order_relaxed);
+            if (state.cancelRequested.load(std::memory_order_relaxed)) {
+                throw MeshLoadCancelled(job.fileName);
+            }
+        }, std::chrono::milliseconds(0));
+
+        Mesh mesh = reader.readMesh();
+
+        // meshes with no vertex or index data never report, make sure they still show as complete
+        if (state.totalBytes.load(std::memory_order_relaxed) == 0) {
+            state.totalBytes.store(1, std::memory_order_relaxed);
+            state.bytesRead.store(1, std::memory_order_relaxed);
+        }
+
+        job.promise.set_value(std::move(mesh));
+    } catch (...) {
+        job.promise.set_exception(std::current_exception());
+    }
+}
@@ -0,0 +1,229 @@
+#include <mesh_normals.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <parallel_for.hpp>
+
+
+// the work is split into a pass over triangles, which computes what every corner of a triangle shares,
+// and a pass over vertices, which sums that up for the triangles around each vertex
+static constexpr size_t MIN_TRIANGLES_PER_THREAD = 16384;
+static constexpr size_t MIN_VERTICES_PER_THREAD = 16384;
+
+static constexpr float PI = 3.14159265358979f;
+
+// corners around each vertex, corner c is entry c of the triangle list, so it belongs to triangle c / 3
+struct VertexCorners {
+    std::vector<uint32_t> offsets;  // corners of vertex v are corners[offsets[v]] to corners[offsets[v + 1]]
+    std::vector<uint32_t> corners;
+};
+
+// counting sort of the corners by vertex, which keeps each vertex's corners in triangle order
+// so the sums below come out the same no matter how the vertices are split between threads
+template<typename Index>
+static VertexCorners buildVertexCorners(const Index* indices, size_t numCorners, size_t numVertices) {
+    if (numCorners > UINT32_MAX) {
+        throw std::invalid_argument("Mesh has too many triangles for normal generation");
+    }
+    VertexCorners adjacency;
+    adjacency.offsets.assign(numVertices + 1, 0);
+    for (size_t c = 0; c < numCorners; ++c) {
+        if (indices[c] >= numVertices) {
+            throw std::invalid_argument("Mesh index out of range: " + std::to_string(indices[c]));
+        }
+        ++adjacency.offsets[indices[c] + 1];
+    }
+    std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+    std::vector<uint32_t> next(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    adjacency.corners.resize(numCorners);
+    for (size_t c = 0; c < numCorners; ++c) {
+        adjacency.corners[next[indices[c]]++] = static_cast<uint32_t>(c);
+    }
+    return adjacency;
+}
+
+// call f(indices, numCorners) with the triangle list of mesh
+// meshes without indices get a list of their vertices in order
+template<typename F>
+static void visitTriangles(const Mesh& mesh, F&& f) {
+    if (mesh.hasIndices()) {
+        if (mesh.numIndices() % 3 != 0) {
+            throw std::invalid_argument("Mesh indices are not a triangle list: " + std::to_string(mesh.numIndices()) + " indices");
+        }
+        mesh.indices().visit([&] (const auto* indices) { f(indices, mesh.numIndices()); });
+    } else {
+        std::vector<uint32_t> indices(mesh.numVertices() - mesh.numVertices() % 3);
+        std::iota(indices.begin(), indices.end(), 0);
+        f(indices.data(), indices.size());
+    }
+}
+
+// the buffer for attribute with elements of type T, created or replaced if needed
+template<typename T>
+static TypedMeshAttributeBuffer<T>& outputBuffer(Mesh& mesh, MeshAttribute attribute) {
+    if (!mesh.hasAttributeBuffer(attribute)) {
+        return mesh.createAttributeBuffer<T>(attribute);
+    }
+    if (!mesh.getAttributeBuffer(attribute).hasElementType<T>()) {
+        mesh.replaceAttributeBuffer(attribute, ComponentTypeHelper<T>::componentType, ComponentTypeHelper<T>::numComponents);
+    }
+    return mesh.getAttributeBuffer<T>(attribute);
+}
+
+// angle of each corner of triangles [begin, end), in the triangle's plane
+// the third angle is what is left of pi, which saves an atan2 per triangle
+template<typename Index>
+static void cornerAngles(const Index* indices, const vec3* positions, float* angles, size_t begin, size_t end) {
+    for (size_t t = begin; t < end; ++t) {
+        const Index* triangle = indices + 3 * t;
+        vec3 e01 = positions[triangle[1]] - positions[triangle[0]];
+        vec3 e02 = positions[triangle[2]] - positions[triangle[0]];
+        vec3 e12 = positions[triangle[2]] - positions[triangle[1]];
+        float twiceArea = vecmath::length(vecmath::cross(e01, e02));
+        if (twiceArea == 0.0f) {
+            angles[3 * t] = angles[3 * t + 1] = angles[3 * t + 2] = 0.0f;
+            continue;
+        }
+        angles[3 * t] = std::atan2(twiceArea, vecmath::dot(e01, e02));
+        angles[3 * t + 1] = std::atan2(twiceArea, -vecmath::dot(e01, e12));
+        angles[3 * t + 2] = std::max(0.0f, PI - angles[3 * t] - angles[3 * t + 1]);
+    }
+}
+
+// normals of triangles [begin, end), unit length for angle weighting and twice the triangle's area long for area weighting
+template<typename Index>
+static void triangleNormals(const Index* indices, const vec3* positions, vec3* normals, NormalWeighting weighting, size_t begin, size_t end) {
+    for (size_t t = begin; t < end; ++t) {
+        const Index* triangle = indices + 3 * t;
+        vec3 normal = vecmath::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]);
+        if (weighting == NormalWeighting::ANGLE) {
+            float length = vecmath::length(normal);
+            normal = length > 0.0f ? normal * (1.0f / length) : vec3(0.0f, 0.0f, 0.0f);
+        }
+        normals[t] = normal;
+    }
+}
+
+// texture space tangent and bitangent of triangles [begin, end), zero where the texture coordinates are degenerate
+// both are flipped for triangles whose mapping is mirrored, like MikkTSpace does before normalizing
+template<typename Index>
+static void triangleTangents(const Index* indices, const vec3* positions, const vec2* texCoords, vec3* tangents, vec3* bitangents,
+        size_t begin, size_t end) {
+    for (size_t t = begin; t < end; ++t) {
+        const Index* triangle = indices + 3 * t;
+        vec3 e1 = positions[triangle[1]] - positions[triangle[0]];
+        vec3 e2 = positions[triangle[2]] - positions[triangle[0]];
+        vec2 d1 = texCoords[triangle[1]] - texCoords[triangle[0]];
+        vec2 d2 = texCoords[triangle[2]] - texCoords[triangle[0]];
+        // twice the signed area in texture space, its sign is whether the mapping preserves orientation
+        float area = d1[0] * d2[1] - d2[0] * d1[1];
+        if (area == 0.0f) {
+            tangents[t] = bitangents[t] = vec3(0.0f, 0.0f, 0.0f);
+            continue;
+        }
+        float sign = area > 0.0f ? 1.0f : -1.0f;
+        tangents[t] = (e1 * d2[1] - e2 * d1[1]) * sign;
+        bitangents[t] = (e2 * d1[0] - e1 * d2[0]) * sign;
+    }
+}
+
+static inline vec3 projectOntoPlane(const vec3& v, const vec3& normal) {
+    return v - normal * vecmath::dot(normal, v);
+}
+
+// any unit vector perpendicular to normal, for vertices without a usable tangent
+static vec3 perpendicular(const vec3& normal) {
+    vec3 axis = std::abs(normal[0]) < 0.9f ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f);
+    return vecmath::normalize(projectOntoPlane(axis, normal));
+}
+
+static void sumNormals(const VertexCorners& adjacency, const vec3* triangleNormals, const float* angles, vec3* normals,
+        size_t begin, size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+        vec3 sum(0.0f, 0.0f, 0.0f);
+        for (uint32_t k = adjacency.offsets[v]; k < adjacency.offsets[v + 1]; ++k) {
+            uint32_t corner = adjacency.corners[k];
+            sum += angles ? triangleNormals[corner / 3] * angles[corner] : triangleNormals[corner / 3];
+        }
+        float length = vecmath::length(sum);
+        normals[v] = length > 0.0f ? sum * (1.0f / length) : vec3(0.0f, 0.0f, 0.0f);
+    }
+}
+
+static void sumTangents(const VertexCorners& adjacency, const vec3* triangleTangents, const vec3* triangleBitangents, const float* angles,
+        const vec3* normals, vec4* tangents, size_t begin, size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+        const vec3& normal = normals[v];
+        vec3 tangentSum(0.0f, 0.0f, 0.0f);
+        vec3 bitangentSum(0.0f, 0.0f, 0.0f);
+        for (uint32_t k = adjacency.offsets[v]; k < adjacency.offsets[v + 1]; ++k) {
+            uint32_t corner = adjacency.corners[k];
+            vec3 tangent = projectOntoPlane(triangleTangents[corner / 3], normal);
+            vec3 bitangent = projectOntoPlane(triangleBitangents[corner / 3], normal);
+            float tangentLength = vecmath::length(tangent);
+            float bitangentLength = vecmath::length(bitangent);
+            if (tangentLength == 0.0f || bitangentLength == 0.0f) {
+                continue;
+            }
+            tangentSum += tangent * (angles[corner] / tangentLength);
+            bitangentSum += bitangent * (angles[corner] / bitangentLength);
+        }
+        vec3 tangent = projectOntoPlane(tangentSum, normal);
+        float length = vecmath::length(tangent);
+        tangent = length > 0.0f ? tangent * (1.0f / length) : perpendicular(normal);
+        float w = vecmath::dot(vecmath::cross(normal, tangent), bitangentSum) < 0.0f ? -1.0f : 1.0f;
+        tangents[v] = vec4(tangent[0], tangent[1], tangent[2], w);
+    }
+}
+
+void generateNormals(Mesh& mesh, NormalWeighting weighting, unsigned numThreads) {
+    const vec3* positions = static_cast<const Mesh&>(mesh).getAttributeBuffer<vec3>(MeshAttribute::POSITION).begin();
+
+    visitTriangles(mesh, [&] (const auto* indices, size_t numCorners) {
+        const size_t numTriangles = numCorners / 3;
+        VertexCorners adjacency = buildVertexCorners(indices, numCorners, mesh.numVertices());
+        // only touch the mesh once the inputs are known to be valid
+        vec3* normals = outputBuffer<vec3>(mesh, MeshAttribute::NORMAL).begin();
+        std::vector<vec3> faceNormals(numTriangles);
+        std::vector<float> angles(weighting == NormalWeighting::ANGLE ? numCorners : 0);
+        parallelFor(numTriangles, MIN_TRIANGLES_PER_THREAD, [&] (size_t begin, size_t end) {
+            triangleNormals(indices, positions, faceNormals.data(), weighting, begin, end);
+            if (!angles.empty()) {
+                cornerAngles(indices, positions, angles.data(), begin, end);
+            }
+        }, numThreads);
+        parallelFor(mesh.numVertices(), MIN_VERTICES_PER_THREAD, [&] (size_t begin, size_t end) {
+            sumNormals(adjacency, faceNormals.data(), angles.empty() ? nullptr : angles.data(), normals, begin, end);
+        }, numThreads);
+    });
+}
+
+void generateTangents(Mesh& mesh, unsigned numThreads) {
+    const Mesh& source = mesh;
+    const vec3* positions = source.getAttributeBuffer<vec3>(MeshAttribute::POSITION).begin();
+    const vec2* texCoords = source.getAttributeBuffer<vec2>(MeshAttribute::TEXCOORD).begin();
+    const vec3* normals = source.getAttributeBuffer<vec3>(MeshAttribute::NORMAL).begin();
+
+    visitTriangles(mesh, [&] (const auto* indices, size_t numCorners) {
+        const size_t numTriangles = numCorners / 3;
+        VertexCorners adjacency = buildVertexCorners(indices, numCorners, mesh.numVertices());
+        // only touch the mesh once the inputs are known to be valid
+        vec4* tangents = outputBuffer<vec4>(mesh, MeshAttribute::TANGENT).begin();
+        std::vector<vec3> faceTangents(numTriangles), faceBitangents(numTriangles);
+        std::vector<float> angles(numCorners);
+        parallelFor(numTriangles, MIN_TRIANGLES_PER_THREAD, [&] (size_t begin, size_t end) {
+            triangleTangents(indices, positions, texCoords, faceTangents.data(), faceBitangents.data(), begin, end);
+            cornerAngles(indices, positions, angles.data(), begin, end);
+        }, numThreads);
+        parallelFor(mesh.numVertices(), MIN_VERTICES_PER_THREAD, [&] (size_t begin, size_t end) {
+            sumTangents(adjacency, faceTangents.data(), faceBitangents.data(), angles.data(), normals, tangents, begin, end);
+        }, numThreads);
+    });
+}
@@ -0,0 +1,399 @@
+#include <mesh_optimize.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <parallel_for.hpp>
+
+
+static constexpr uint32_t NO_VERTEX = UINT32_MAX;
+
+// the triangle list of mesh, widened to 32 bits
+static std::vector<uint32_t> triangleList(const Mesh& mesh) {
+    if (mesh.numIndices() % 3 != 0) {
+        throw std::invalid_argument("Mesh indices are not a triangle list: " + std::to_string(mesh.numIndices()) + " indices");
+    }
+    std::vector<uint32_t> indices(mesh.indices().begin(), mesh.indices().end());
+    for (uint32_t index : indices) {
+        if (index >= mesh.numVertices()) {
+            throw std::invalid_argument("Mesh index out of range: " + std::to_string(index));
+        }
+    }
+    return indices;
+}
+
+// store indices back in mesh, in its index type
+static void setTriangleList(Mesh& mesh, const std::vector<uint32_t>& indices) {
+    mesh.indices().visit([&] (auto* dst) {
+        using Index = std::remove_pointer_t<decltype(dst)>;
+        std::transform(indices.begin(), indices.end(), dst, [] (uint32_t index) { return static_cast<Index>(index); });
+    });
+}
+
+// FIFO cache of vertex timestamps, a vertex is in the cache if fewer than cacheSize vertices were added after it
+class VertexCache {
+
+public:
+
+    VertexCache(size_t numVertices, unsigned cacheSize) :
+            _timestamps(numVertices, 0),
+            _time(cacheSize + 1),
+            _cacheSize(cacheSize) {
+    }
+
+    // the number of vertices added since v, more than the cache size if v is not in the cache
+    uint32_t age(uint32_t v) const {
+        return _time - _timestamps[v];
+    }
+
+    bool contains(uint32_t v) const {
+        return age(v) <= _cacheSize;
+    }
+
+    // add v if it's missing, returns true if it was
+    bool access(uint32_t v) {
+        if (contains(v)) return false;
+        _timestamps[v] = _time++;
+        return true;
+    }
+
+    unsigned accessTriangle(const uint32_t* triangle) {
+        return access(triangle[0]) + access(triangle[1]) + access(triangle[2]);
+    }
+
+    // forget every vertex
+    void flush() {
+        _time += _cacheSize + 1;
+    }
+
+    unsigned cacheSize() const {
+        return _cacheSize;
+    }
+
+private:
+
+    std::vector<uint32_t> _timestamps;
+
+    uint32_t _time;
+
+    unsigned _cacheSize;
+
+};
+
+// triangles around each vertex
+struct VertexTriangles {
+    std::vector<uint32_t> offsets;  // triangles of vertex v are triangles[offsets[v]] to triangles[offsets[v + 1]]
+    std::vector<uint32_t> triangles;
+};
+
+static VertexTriangles buildVertexTriangles(const std::vector<uint32_t>& indices, size_t numVertices) {
+    VertexTriangles adjacency;
+    adjacency.offsets.assign(numVertices + 1, 0);
+    for (uint32_t v : indices) {
+        ++adjacency.offsets[v + 1];
+    }
+    std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+    std::vector<uint32_t> next(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    adjacency.triangles.resize(indices.size());
+    for (size_t c = 0; c < indices.size(); ++c) {
+        adjacency.triangles[next[indices[c]]++] = static_cast<uint32_t>(c / 3);
+    }
+    return adjacency;
+}
+
+// Tipsify state, the triangle order is built by fanning around one vertex at a time
+class Tipsifier {
+
+public:
+
+    Tipsifier(const std::vector<uint32_t>& indices, size_t numVertices, unsigned cacheSize) :
+            _indices(indices),
+            _adjacency(buildVertexTriangles(indices, numVertices)),
+            _live(numVertices),
+            _emitted(indices.size() / 3, false),
+            _cache(numVertices, cacheSize),
+            _cursor(0) {
+        for (size_t v = 0; v < numVertices; ++v) {
+            _live[v] = _adjacency.offsets[v + 1] - _adjacency.offsets[v];
+        }
+    }
+
+    std::vector<uint32_t> run() {
+        std::vector<uint32_t> order;
+        order.reserve(_emitted.size());
+        for (uint32_t fanning = skipDeadEnd(); fanning != NO_VERTEX; fanning = nextVertex()) {
+            _candidates.clear();
+            for (uint32_t k = _adjacency.offsets[fanning]; k < _adjacency.offsets[fanning + 1]; ++k) {
+                uint32_t t = _adjacency.triangles[k];
+                if (_emitted[t]) continue;
+                _emitted[t] = true;
+                order.push_back(t);
+                for (int c = 0; c < 3; ++c) {
+                    uint32_t v = _indices[3 * t + c];
+                    _deadEnd.push_back(v);
+                    _candidates.push_back(v);
+                    --_live[v];
+                    _cache.access(v);
+                }
+            }
+        }
+        return order;
+    }
+
+private:
+
+    // the vertex around which the next fan gives the most hits, preferring vertices that are about to leave the cache
+    // as long as all of their triangles still fit in it
+    uint32_t nextVertex() {
+        uint32_t best = NO_VERTEX;
+        int64_t bestPriority = -1;
+        for (uint32_t v : _candidates) {
+            if (_live[v] == 0) continue;
+            int64_t priority = 0;
+            if (int64_t(_cache.age(v)) + 2 * int64_t(_live[v]) <= _cache.cacheSize()) {
+                priority = _cache.age(v);
+            }
+            if (priority > bestPriority) {
+                best = v;
+                bestPriority = priority;
+            }
+        }
+        return best != NO_VERTEX ? best : skipDeadEnd();
+    }
+
+    // every neighbor is done, continue from the most recently used vertex that isn't, or any vertex that isn't
+    uint32_t skipDeadEnd() {
+        while (!_deadEnd.empty()) {
+            uint32_t v = _deadEnd.back();
+            _deadEnd.pop_back();
+            if (_live[v] > 0) return v;
+        }
+        for (; _cursor < _live.size(); ++_cursor) {
+            if (_live[_cursor] > 0) return static_cast<uint32_t>(_cursor);
+        }
+        return NO_VERTEX;
+    }
+
+    const std::vector<uint32_t>& _indices;
+
+    VertexTriangles _adjacency;
+
+    std::vector<uint32_t> _live;  // triangles of each vertex not emitted yet
+
+    std::vector<bool> _emitted;
+
+    VertexCache _cache;
+
+    std::vector<uint32_t> _deadEnd;
+
+    std::vector<uint32_t> _candidates;
+
+    size_t _cursor;
+
+};
+
+static void checkCacheSize(unsigned cacheSize) {
+    if (cacheSize < 3) {
+        throw std::invalid_argument("Vertex cache must hold at least one triangle: " + std::to_string(cacheSize));
+    }
+}
+
+void optimizeVertexCache(Mesh& mesh, unsigned cacheSize) {
+    checkCacheSize(cacheSize);
+    if (!mesh.hasIndices()) {
+        return;
+    }
+    std::vector<uint32_t> indices = triangleList(mesh);
+    std::vector<uint32_t> order = Tipsifier(indices, mesh.numVertices(), cacheSize).run();
+
+    std::vector<uint32_t> reordered(indices.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        std::copy_n(indices.begin() + 3 * order[i], 3, reordered.begin() + 3 * i);
+    }
+    setTriangleList(mesh, reordered);
+}
+
+// first triangle of each cluster, where the cache starts over: none of the triangle's vertices are in it,
+// which after optimizeVertexCache means a new patch of the mesh
+static std::vector<size_t> hardBoundaries(const std::vector<uint32_t>& indices, VertexCache& cache) {
+    std::vector<size_t> boundaries;
+    for (size_t t = 0; t < indices.size() / 3; ++t) {
+        if (cache.accessTriangle(&indices[3 * t]) == 3 || t == 0) {
+            boundaries.push_back(t);
+        }
+    }
+    return boundaries;
+}
+
+// hard clusters split wherever the cache misses so far are few enough that starting over with an empty cache
+// keeps the cluster within threshold of its own miss ratio
+static std::vector<size_t> softBoundaries(const std::vector<uint32_t>& indices, const std::vector<size_t>& hard, float threshold,
+        VertexCache& cache) {
+    std::vector<size_t> boundaries;
+    const size_t numTriangles = indices.size() / 3;
+    for (size_t h = 0; h < hard.size(); ++h) {
+        const size_t begin = hard[h], end = h + 1 < hard.size() ? hard[h + 1] : numTriangles;
+
+        cache.flush();
+        size_t clusterMisses = 0;
+        for (size_t t = begin; t < end; ++t) {
+            clusterMisses += cache.accessTriangle(&indices[3 * t]);
+        }
+        const double limit = threshold * double(clusterMisses) / double(end - begin);
+
+        cache.flush();
+        boundaries.push_back(begin);
+        size_t misses = 0, start = begin;
+        for (size_t t = begin; t + 1 < end; ++t) {
+            misses += cache.accessTriangle(&indices[3 * t]);
+            if (double(misses) <= limit * double(t + 1 - start)) {
+                boundaries.push_back(t + 1);
+                start = t + 1;
+                misses = 0;
+                cache.flush();
+            }
+        }
+    }
+    return boundaries;
+}
+
+void optimizeOverdraw(Mesh& mesh, float threshold, unsigned cacheSize) {
+    checkCacheSize(cacheSize);
+    if (!(threshold >= 1.0f)) {
+        throw std::invalid_argument("Overdraw threshold must be at least 1: " + std::to_string(threshold));
+    }
+    const vec3 center = mesh.bounds().center;
+    const vec3* positions = static_cast<const Mesh&>(mesh).getAttributeBuffer<vec3>(MeshAttribute::POSITION).begin();
+    if (!mesh.hasIndices()) {
+        return;
+    }
+    std::vector<uint32_t> indices = triangleList(mesh);
+    const size_t numTriangles = indices.size() / 3;
+
+    VertexCache cache(mesh.numVertices(), cacheSize);
+    std::vector<size_t> clusters = softBoundaries(indices, hardBoundaries(indices, cache), threshold, cache);
+    clusters.push_back(numTriangles);
+    const size_t numClusters = clusters.size() - 1;
+
+    // how far each cluster faces away from the center: the area weighted centroid, relative to the center,
+    // along the area weighted normal
+    std::vector<float> facing(numClusters);
+    parallelFor(numClusters, 1024, [&] (size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            vec3 centroid(0.0f, 0.0f, 0.0f), normal(0.0f, 0.0f, 0.0f);
+            float area = 0.0f;
+            for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+                const vec3& p0 = positions[indices[3 * t]];
+                const vec3& p1 = positions[indices[3 * t + 1]];
+                const vec3& p2 = positions[indices[3 * t + 2]];
+                vec3 n = vecmath::cross(p1 - p0, p2 - p0);
+                float a = vecmath::length(n);
+                centroid += (p0 + p1 + p2) * (a / 3.0f);
+                normal += n;
+                area += a;
+            }
+            float length = vecmath::length(normal);
+            facing[c] = area > 0.0f && length > 0.0f ? vecmath::dot(centroid * (1.0f / area) - center, normal) / length : 0.0f;
+        }
+    });
+
+    std::vector<uint32_t> order(numClusters);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&] (uint32_t a, uint32_t b) { return facing[a] > facing[b]; });
+
+    std::vector<uint32_t> reordered;
+    reordered.reserve(indices.size());
+    for (uint32_t c : order) {
+        reordered.insert(reordered.end(), indices.begin() + 3 * clusters[c], indices.begin() + 3 * clusters[c + 1]);
+    }
+    setTriangleList(mesh, reordered);
+}
+
+void optimizeVertexFetch(Mesh& mesh) {
+    if (!mesh.hasIndices()) {
+        return;
+    }
+    std::vector<uint32_t> indices = triangleList(mesh);
+    const size_t numVertices = mesh.numVertices();
+
+    // new index of each vertex, in order of first use, then the unused ones
+    std::vector<uint32_t> remap(numVertices, NO_VERTEX);
+    std::vector<uint32_t> sources;
+    sources.reserve(numVertices);
+    for (uint32_t& index : indices) {
+        if (remap[index] == NO_VERTEX) {
+            remap[index] = static_cast<uint32_t>(sources.size());
+            sources.push_back(index);
+        }
+        index = remap[index];
+    }
+    for (size_t v = 0; v < numVertices; ++v) {
+        if (remap[v] == NO_VERTEX) {
+            remap[v] = static_cast<uint32_t>(sources.size());
+            sources.push_back(static_cast<uint32_t>(v));
+        }
+    }
+
+    // buffers are independent, so each is gathered on its own thread
+    parallelFor(mesh.numAttributes(), 1, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            MeshAttributeBuffer& buffer = mesh.getAttributeBuffer(static_cast<uint32_t>(i));
+            dispatchElementType(buffer.componentType(), buffer.numComponents(), [&] (auto tag) {
+                using T = typename decltype(tag)::type;
+                T* elements = static_cast<T*>(buffer.data());
+                std::vector<T> copy(elements, elements + numVertices);
+                for (size_t v = 0; v < numVertices; ++v) {
+                    elements[v] = copy[sources[v]];
+                }
+            });
+        }
+    });
+    setTriangleList(mesh, indices);
+
+    // levels of detail index the same vertices
+    for (size_t level = 0; level < mesh.numLods(); ++level) {
+        MeshIndexBuffer& lodIndices = mesh.lod(level).indices;
+        lodIndices.visit([&] (auto* dst) {
+            using Index = std::remove_pointer_t<decltype(dst)>;
+            for (size_t i = 0; i < lodIndices.size(); ++i) {
+                dst[i] = static_cast<Index>(remap[dst[i]]);
+            }
+        });
+    }
+}
+
+VertexCacheStats simulateVertexCache(const Mesh& mesh, unsigned cacheSize) {
+    checkCacheSize(cacheSize);
+    VertexCacheStats stats {};
+    if (!mesh.hasIndices()) {
+        stats.numTriangles = mesh.numVertices() / 3;
+        stats.numTransforms = stats.numTriangles * 3;
+        stats.acmr = stats.numTriangles > 0 ? 3.0 : 0.0;
+        stats.atvr = stats.numTriangles > 0 ? 1.0 : 0.0;
+        return stats;
+    }
+
+    std::vector<uint32_t> indices = triangleList(mesh);
+    VertexCache cache(mesh.numVertices(), cacheSize);
+    std::vector<bool> used(mesh.numVertices(), false);
+    size_t numUsed = 0;
+    for (size_t t = 0; t < indices.size() / 3; ++t) {
+        stats.numTransforms += cache.accessTriangle(&indices[3 * t]);
+    }
+    for (uint32_t v : indices) {
+        if (!used[v]) {
+            used[v] = true;
+            ++numUsed;
+        }
+    }
+    stats.numTriangles = indices.size() / 3;
+    stats.acmr = stats.numTriangles > 0 ? double(stats.numTransforms) / double(stats.numTriangles) : 0.0;
+    stats.atvr = numUsed > 0 ? double(stats.numTransforms) / double(numUsed) : 0.0;
+    return stats;
+}
@@ -0,0 +1,283 @@
+#include <mesh_pack.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <mesh_io.hpp>
+
+#include "mesh_file_format.hpp"
+
+
+static constexpr size_t PACK_HEADER_SIZE = 20;
+static constexpr size_t PACK_ENTRY_DATA_SIZE = 33;
+
+static constexpr size_t COPY_BLOCK_SIZE = 4 << 20;
+
+struct PackHeaderData {
+    char fileID[8];
+    uint32_t meshCount;
+    uint64_t tocSize;
+};
+
+static void packPackHeader(char* buffer, const PackHeaderData& header) {
+    memcpy(buffer, header.fileID, sizeof(PackHeaderData::fileID));
+    size_t offset = sizeof(PackHeaderData::fileID);
+    memcpy(buffer + offset, &header.meshCount, sizeof(uint32_t));
+    offset += sizeof(uint32_t);
+    memcpy(buffer + offset, &header.tocSize, sizeof(uint64_t));
+}
+
+static PackHeaderData unpackPackHeader(const char* buffer) {
+    PackHeaderData header;
+    memcpy(header.fileID, buffer, sizeof(PackHeaderData::fileID));
+    size_t offset = sizeof(PackHeaderData::fileID);
+    memcpy(&header.meshCount, buffer + offset, sizeof(uint32_t));
+    offset += sizeof(uint32_t);
+    memcpy(&header.tocSize, buffer + offset, sizeof(uint64_t));
+    return header;
+}
+
+// fixed size part of a table of contents entry, following the entry name
+static void packEntryData(char* buffer, const MeshPackReader::Entry& entry) {
+    memcpy(buffer, &entry.offset, sizeof(uint64_t));
+    size_t offset = sizeof(uint64_t);
+    memcpy(buffer + offset, &entry.size, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(buffer + offset, &entry.vertexCount, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(buffer + offset, &entry.indexCount, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    uint8_t attribCount = entry.attributes.size();
+    memcpy(buffer + offset, &attribCount, sizeof(uint8_t));
+}
+
+static uint8_t unpackEntryData(const char* buffer, MeshPackReader::Entry& entry) {
+    memcpy(&entry.offset, buffer, sizeof(uint64_t));
+    size_t offset = sizeof(uint64_t);
+    memcpy(&entry.size, buffer + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&entry.vertexCount, buffer + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&entry.indexCount, buffer + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    uint8_t attribCount;
+    memcpy(&attribCount, buffer + offset, sizeof(uint8_t));
+    return attribCount;
+}
+
+// read just the header and attribute descriptions of a mesh file
+static MeshPackReader::Entry readMeshFileLayout(std::ifstream& fs, const std::string& meshFileName) {
+    MeshFileLayout fileLayout;
+    try {
+        fileLayout = readStreamLayout(fs);
+    } catch (std::runtime_error& e) {
+        throw std::runtime_error(e.what() + (" " + meshFileName));
+    }
+
+    MeshPackReader::Entry entry;
+    entry.vertexCount = fileLayout.vertexCount;
+    entry.indexCount = fileLayout.indexCount;
+    entry.attributes.resize(fileLayout.attribData.size());
+
+    for (size_t i = 0; i < entry.attributes.size(); ++i) {
+        auto& layout = entry.attributes[i];
+        layout.attribute = getAttributeFromName(fileLayout.attribNames[i]);
+        layout.componentType = static_cast<MeshAttributeComponentType>(fileLayout.attribData[i].componentType);
+        layout.numComponents = fileLayout.attribData[i].numComponents;
+    }
+
+    fs.clear();
+    fs.seekg(0, std::ios::end);
+    entry.size = fs.tellg();
+    fs.seekg(0, std::ios::beg);
+
+    return entry;
+}
+
+// MeshPackWriter
+
+MeshPackWriter::MeshPackWriter(const std::string& fileName) :
+        _fs(fileName, std::ios::out | std::ios::binary) {
+    if (!_fs) {
+        throw std::runtime_error("Cannot write file: " + fileName);
+    }
+}
+
+void MeshPackWriter::addMeshFile(const std::string& name, const std::string& meshFileName) {
+    auto sameName = [&name] (const auto& meshFile) { return meshFile.first == name; };
+    if (std::any_of(_meshFiles.begin(), _meshFiles.end(), sameName)) {
+        throw std::invalid_argument("Mesh pack already has a mesh named: " + name);
+    }
+    _meshFiles.emplace_back(name, meshFileName);
+}
+
+void MeshPackWriter::write() {
+    if (!_fs) {
+        throw std::runtime_error("Write error.");
+    }
+
+    std::vector<MeshPackReader::Entry> entries;
+    entries.reserve(_meshFiles.size());
+
+    // gather the layout of every mesh first, the table of contents has to know where everything goes
+    // each file is closed again right away, packs of thousands of meshes would run out of file descriptors
+    uint64_t tocSize = 0;
+    for (const auto& [name, meshFileName] : _meshFiles) {
+        std::ifstream fs(meshFileName, std::ios::in | std::ios::binary);
+        if (!fs) {
+            throw std::runtime_error("Cannot read file: " + meshFileName);
+        }
+        auto& entry = entries.emplace_back(readMeshFileLayout(fs, meshFileName));
+        entry.name = name;
+
+        tocSize += name.length() + 1 + PACK_ENTRY_DATA_SIZE;
+        for (const auto& layout : entry.attributes) {
+            tocSize += getAttributeName(layout.attribute).length() + 1 + 2;
+        }
+    }
+
+    // embedded files start on a section boundary, so their sections stay aligned within the pack
+    uint64_t offset = PACK_HEADER_SIZE + tocSize;
+    for (auto& entry : entries) {
+        entry.offset = alignFileOffset(offset);
+        offset = entry.offset + entry.size;
+    }
+
+    std::cout << "Writing mesh pack with " << entries.size() << " meshes" << std::endl;
+
+    PackHeaderData header;
+    memcpy(header.fileID, "meshpack", 8);
+    header.meshCount = entries.size();
+    header.tocSize = tocSize;
+
+    char headerBuffer[PACK_HEADER_SIZE];
+    packPackHeader(headerBuffer, header);
+    _fs.write(headerBuffer, PACK_HEADER_SIZE);
+
+    for (const auto& entry : entries) {
+        _fs.write(entry.name.c_str(), entry.name.length() + 1);
+
+        char dataBuffer[PACK_ENTRY_DATA_SIZE];
+        packEntryData(dataBuffer, entry);
+        _fs.write(dataBuffer, PACK_ENTRY_DATA_SIZE);
+
+        for (const auto& layout : entry.attributes) {
+            std::string attribName = getAttributeName(layout.attribute);
+            _fs.write(attribName.c_str(), attribName.length() + 1);
+            uint8_t layoutData[2] = { static_cast<uint8_t>(layout.componentType), static_cast<uint8_t>(layout.numComponents) };
+            _fs.write(reinterpret_cast<const char*>(layoutData), 2);
+        }
+    }
+
+    // mesh files are copied verbatim, so each one can be decoded by MeshReader in place
+    std::vector<char> block(COPY_BLOCK_SIZE);
+    for (auto i = 0u; i < entries.size(); ++i) {
+        const char padding[MESH_FILE_ALIGNMENT] = {};
+        _fs.write(padding, entries[i].offset - static_cast<uint64_t>(_fs.tellp()));
+
+        std::ifstream input(_meshFiles[i].second, std::ios::in | std::ios::binary);
+        uint64_t remaining = entries[i].size;
+        while (remaining > 0) {
+            size_t n = std::min<uint64_t>(remaining, block.size());
+            if (!input.read(block.data(), n)) {
+                throw std::runtime_error("Cannot read file: " + _meshFiles[i].second);
+            }
+            _fs.write(block.data(), n);
+            remaining -= n;
+        }
+    }
+
+    if (!_fs) {
+        throw std::runtime_error("Write error.");
+    }
+
+    std::cout << "Finished writing mesh pack." << std::endl;
+}
+
+// MeshPackReader
+
+MeshPackReader::MeshPackReader(const std::string& fileName) :
+        _fs(fileName, std::ios::in | std::ios::binary) {
+    if (!_fs) {
+        throw std::runtime_error("Cannot read file: " + fileName);
+    }
+
+    char headerBuffer[PACK_HEADER_SIZE];
+    if (!_fs.read(headerBuffer, PACK_HEADER_SIZE)) {
+        throw std::runtime_error("Cannot read mesh pack header: " + fileName);
+    }
+    PackHeaderData header = unpackPackHeader(headerBuffer);
+    if (std::string("meshpack").compare(std::string(header.fileID, 8)) != 0) {
+        throw std::runtime_error("File does not have a valid mesh pack ID: " + fileName);
+    }
+
+    // the table of contents is read with a single read call and parsed in memory
+    std::vector<char> toc(header.tocSize);
+    if (!_fs.read(toc.data(), toc.size())) {
+        throw std::runtime_error("Mesh pack table of contents is truncated: " + fileName);
+    }
+
+    auto checkRange = [&] (size_t position, size_t size) {
+        if (position > toc.size() || size > toc.size() - position) {
+            throw std::runtime_error("Mesh pack table of contents is truncated: " + fileName);
+        }
+    };
+
+    _entries.resize(header.meshCount);
+    _entryIndices.reserve(header.meshCount);
+
+    size_t position = 0;
+
+    auto readString = [&] () {
+        const char* begin = toc.data() + position;
+        const char* end = static_cast<const char*>(memchr(begin, '\0', toc.size() - position));
+        if (!end) {
+            throw std::runtime_error("Mesh pack table of contents is truncated: " + fileName);
+        }
+        position += end - begin + 1;
+        return std::string(begin, end);
+    };
+
+    for (auto i = 0u; i < header.meshCount; ++i) {
+        Entry& entry = _entries[i];
+
+        entry.name = readString();
+
+        checkRange(position, PACK_ENTRY_DATA_SIZE);
+        uint8_t attribCount = unpackEntryData(toc.data() + position, entry);
+        position += PACK_ENTRY_DATA_SIZE;
+
+        entry.attributes.resize(attribCount);
+        for (auto& layout : entry.attributes) {
+            layout.attribute = getAttributeFromName(readString());
+            checkRange(position, 2);
+            layout.componentType = static_cast<MeshAttributeComponentType>(toc[position]);
+            layout.numComponents = static_cast<uint8_t>(toc[position + 1]);
+            position += 2;
+        }
+
+        _entryIndices.emplace(entry.name, i);
+    }
+}
+
+const MeshPackReader::Entry* MeshPackReader::findEntry(const std::string& name) const {
+    if (auto it = _entryIndices.find(name); it != _entryIndices.end()) {
+        return &_entries[it->second];
+    }
+    return nullptr;
+}
+
+Mesh MeshPackReader::readMesh(const std::string& name) {
+    if (const Entry* entry = findEntry(name)) {
+        return readMesh(*entry);
+    }
+    throw std::invalid_argument("Mesh pack has no mesh named: " + name);
+}
+
+Mesh MeshPackReader::readMesh(const Entry& entry) {
+    _fs.clear();
+    _fs.seekg(entry.offset);
+    return MeshReader(_fs).readMesh();
+}
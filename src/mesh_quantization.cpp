@@ -0,0 +1,501 @@
+#include <mesh_quantization.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_QUANTIZATION_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(MESH_QUANTIZATION_SSE2) && defined(__GNUC__)
+#define MESH_QUANTIZATION_F16C
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define MESH_QUANTIZATION_NEON
+#include <arm_neon.h>
+#endif
+
+
+// Normalized types
+//
+// The SIMD and scalar paths use the same scale factors and round to nearest even
+// (the default rounding mode, used by both cvtps2dq and nearbyint), so they produce identical bits.
+// Clamping is written so that NaNs end up at the low end of the range in both paths.
+
+static constexpr float SNORM8_SCALE = 127.0f;
+static constexpr float UNORM8_SCALE = 255.0f;
+static constexpr float SNORM16_SCALE = 32767.0f;
+static constexpr float UNORM16_SCALE = 65535.0f;
+
+static inline float clampScaled(float v, float lo, float hi, float scale) {
+    v = v > lo ? v : lo;
+    v = v < hi ? v : hi;
+    return std::nearbyint(v * scale);
+}
+
+// snorm decoding clamps to -1, since the most negative integer has no positive counterpart
+static inline float decodeSnorm(float v, float scale) {
+    v *= 1.0f / scale;
+    return v > -1.0f ? v : -1.0f;
+}
+
+#ifdef MESH_QUANTIZATION_SSE2
+
+static inline __m128i clampScaled4(const float* src, __m128 lo, __m128 hi, __m128 scale) {
+    __m128 v = _mm_loadu_ps(src);
+    v = _mm_min_ps(_mm_max_ps(v, lo), hi);
+    return _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+}
+
+#endif
+
+void encodeSnorm8(const float* src, Snorm8* dst, size_t count) {
+    size_t i = 0;
+#ifdef MESH_QUANTIZATION_SSE2
+    const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f), scale = _mm_set1_ps(SNORM8_SCALE);
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_packs_epi32(clampScaled4(src + i, lo, hi, scale), clampScaled4(src + i + 4, lo, hi, scale));
+        __m128i b = _mm_packs_epi32(clampScaled4(src + i + 8, lo, hi, scale), clampScaled4(src + i + 12, lo, hi, scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi16(a, b));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i].value = static_cast<int8_t>(clampScaled(src[i], -1.0f, 1.0f, SNORM8_SCALE));
+    }
+}
+
+void decodeSnorm8(const Snorm8* src, float* dst, size_t count) {
+    size_t i = 0;
+#ifdef MESH_QUANTIZATION_SSE2
+    const __m128 lo = _mm_set1_ps(-1.0f), scale = _mm_set1_ps(1.0f / SNORM8_SCALE);
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // sign extend by placing each byte in the top of its lane and shifting back down
+        __m128i l = _mm_unpacklo_epi8(v, v), h = _mm_unpackhi_epi8(v, v);
+        __m128i parts[4] = {
+            _mm_srai_epi32(_mm_unpacklo_epi16(l, l), 24), _mm_srai_epi32(_mm_unpackhi_epi16(l, l), 24),
+            _mm_srai_epi32(_mm_unpacklo_epi16(h, h), 24), _mm_srai_epi32(_mm_unpackhi_epi16(h, h), 24)};
+        for (int j = 0; j < 4; ++j) {
+            _mm_storeu_ps(dst + i + 4 * j, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(parts[j]), scale), lo));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = decodeSnorm(static_cast<float>(src[i].value), SNORM8_SCALE);
+    }
+}
+
+void encodeUnorm8(const float* src, Unorm8* dst, size_t count) {
+    size_t i = 0;
+#ifdef MESH_QUANTIZATION_SSE2
+    const __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(1.0f), scale = _mm_set1_ps(UNORM8_SCALE);
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_packs_epi32(clampScaled4(src + i, lo, hi, scale), clampScaled4(src + i + 4, lo, hi, scale));
+        __m128i b = _mm_packs_epi32(clampScaled4(src + i + 8, lo, hi, scale), clampScaled4(src + i + 12, lo, hi, scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i].value = static_cast<uint8_t>(clampScaled(src[i], 0.0f, 1.0f, UNORM8_SCALE));
+    }
+}
+
+void decodeUnorm8(const Unorm8* src, float* dst, size_t count) {
+    size_t i = 0;
+#ifdef MESH_QUANTIZATION_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(1.0f / UNORM8_SCALE);
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i l = _mm_unpacklo_epi8(v, zero), h = _mm_unpackhi_epi8(v, zero);
+        __m128i parts[4] = {
+            _mm_unpacklo_epi16(l, zero), _mm_unpackhi_epi16(l, zero),
+            _mm_unpacklo_epi16(h, zero), _mm_unpackhi_epi16(h, zero)};
+        for (int j = 0; j < 4; ++j) {
+            _mm_storeu_ps(dst + i + 4 * j, _mm_mul_ps(_mm_cvtepi32_ps(parts[j]), scale));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = static_cast<float>(src[i].value) * (1.0f / UNORM8_SCALE);
+    }
+}
+
+void encodeSnorm16(const float* src, Snorm16* dst, size_t count) {
+    size_t i = 0;
+#ifdef MESH_QUANTIZATION_SSE2
+    const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f), scale = _mm_set1_ps(SNORM16_SCALE);
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_packs_epi32(clampScaled4(src + i, lo, hi, scale), clampScaled4(src + i + 4, lo, hi, scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i].value = static_cast<int16_t>(clampScaled(src[i], -1.0f, 1.0f, SNORM16_SCALE));
+    }
+}
+
+void decodeSnorm16(const Snorm16* src, float* dst, size_t count) {
+    size_t i = 0;
+#ifdef MESH_QUANTIZATION_SSE2
+    const __m128 lo = _mm_set1_ps(-1.0f), scale = _mm_set1_ps(1.0f / SNORM16_SCALE);
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i l = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), h = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(l), scale), lo));
+        _mm_storeu_ps(dst + i + 4, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(h), scale), lo));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = decodeSnorm(static_cast<float>(src[i].value), SNORM16_SCALE);
+    }
+}
+
+void encodeUnorm16(const float* src, Unorm16* dst, size_t count) {
+    size_t i = 0;
+#ifdef MESH_QUANTIZATION_SSE2
+    // SSE2 only has a signed saturating 32 -> 16 bit pack, so bias into the signed range and flip the sign bit back
+    const __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(1.0f), scale = _mm_set1_ps(UNORM16_SCALE);
+    const __m128i bias = _mm_set1_epi32(32768), signBit = _mm_set1_epi16(static_cast<short>(0x8000));
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_sub_epi32(clampScaled4(src + i, lo, hi, scale), bias);
+        __m128i b = _mm_sub_epi32(clampScaled4(src + i + 4, lo, hi, scale), bias);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(_mm_packs_epi32(a, b), signBit));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i].value = static_cast<uint16_t>(clampScaled(src[i], 0.0f, 1.0f, UNORM16_SCALE));
+    }
+}
+
+void decodeUnorm16(const Unorm16* src, float* dst, size_t count) {
+    size_t i = 0;
+#ifdef MESH_QUANTIZATION_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(1.0f / UNORM16_SCALE);
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), scale));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = static_cast<float>(src[i].value) * (1.0f / UNORM16_SCALE);
+    }
+}
+
+// Half floats
+
+static inline uint32_t floatBits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(float));
+    return u;
+}
+
+static inline float bitsFloat(uint32_t u) {
+    float f;
+    memcpy(&f, &u, sizeof(float));
+    return f;
+}
+
+static uint16_t floatToHalf(float f) {
+    uint32_t u = floatBits(f);
+    uint16_t sign = static_cast<uint16_t>((u >> 16) & 0x8000u);
+    u &= 0x7fffffffu;
+
+    if (u >= 0x7f800000u) {
+        // infinity, or NaN made quiet with the top of its payload kept, like the hardware conversion
+        return sign | 0x7c00u | (u > 0x7f800000u ? 0x0200u | ((u >> 13) & 0x03ffu) : 0u);
+    }
+    if (u >= 0x47800000u) {
+        // too large, even before rounding
+        return sign | 0x7c00u;
+    }
+    if (u < 0x38800000u) {
+        // subnormal or zero, let the fpu do the rounding by adding 0.5 which puts the half's lsb at the float's lsb
+        return sign | static_cast<uint16_t>(floatBits(bitsFloat(u) + 0.5f) - 0x3f000000u);
+    }
+    // normal, rebias the exponent and round to nearest even
+    uint32_t mantissaOdd = (u >> 13) & 1u;
+    u += 0xc8000fffu + mantissaOdd;
+    return sign | static_cast<uint16_t>(u >> 13);
+}
+
+static float halfToFloat(uint16_t h) {
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1fu;
+    uint32_t mantissa = h & 0x03ffu;
+
+    if (exponent == 0x1fu) {
+        // NaNs come out quiet, like the hardware conversion
+        return bitsFloat(sign | 0x7f800000u | (mantissa << 13) | (mantissa ? 0x00400000u : 0u));
+    }
+    if (exponent == 0) {
+        // subnormal halfs are exact multiples of 2^-24
+        float f = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+        return sign ? -f : f;
+    }
+    return bitsFloat(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+}
+
+#ifdef MESH_QUANTIZATION_F16C
+
+__attribute__((target("f16c")))
+static size_t encodeHalfF16C(const float* src, Half* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i h = _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    return i;
+}
+
+__attribute__((target("f16c")))
+static size_t decodeHalfF16C(const Half* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(dst + i, _mm_cvtph_ps(h));
+    }
+    return i;
+}
+
+static bool cpuHasF16C() {
+    static const bool hasF16C = __builtin_cpu_supports("f16c");
+    return hasF16C;
+}
+
+#endif
+
+void encodeHalf(const float* src, Half* dst, size_t count) {
+    size_t i = 0;
+#if defined(MESH_QUANTIZATION_F16C)
+    if (cpuHasF16C()) {
+        i = encodeHalfF16C(src, dst, count);
+    }
+#elif defined(MESH_QUANTIZATION_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1_u16(reinterpret_cast<uint16_t*>(dst + i), vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i].bits = floatToHalf(src[i]);
+    }
+}
+
+void decodeHalf(const Half* src, float* dst, size_t count) {
+    size_t i = 0;
+#if defined(MESH_QUANTIZATION_F16C)
+    if (cpuHasF16C()) {
+        i = decodeHalfF16C(src, dst, count);
+    }
+#elif defined(MESH_QUANTIZATION_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(reinterpret_cast<const uint16_t*>(src + i)))));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = halfToFloat(src[i].bits);
+    }
+}
+
+// Octahedral normals
+//
+// The folding runs on floats in blocks, and the normalized kernels above quantize each block,
+// so rounding and clamping are the same as for any other snorm component.
+
+static constexpr size_t OCTAHEDRAL_BLOCK_SIZE = 256;
+
+static inline float signNotZero(float v) {
+    return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+static void foldOctahedral(const float* src, float* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float x = src[3 * i], y = src[3 * i + 1], z = src[3 * i + 2];
+        float sum = std::fabs(x) + std::fabs(y) + std::fabs(z);
+        float scale = sum > 0.0f ? 1.0f / sum : 0.0f;
+        x *= scale;
+        y *= scale;
+        if (z < 0.0f) {
+            float folded = (1.0f - std::fabs(y)) * signNotZero(x);
+            y = (1.0f - std::fabs(x)) * signNotZero(y);
+            x = folded;
+        }
+        dst[2 * i] = x;
+        dst[2 * i + 1] = y;
+    }
+}
+
+static void unfoldOctahedral(const float* src, float* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float x = src[2 * i], y = src[2 * i + 1];
+        float z = 1.0f - std::fabs(x) - std::fabs(y);
+        float t = z < 0.0f ? -z : 0.0f;
+        x += x >= 0.0f ? -t : t;
+        y += y >= 0.0f ? -t : t;
+        float scale = 1.0f / std::sqrt(x * x + y * y + z * z);
+        dst[3 * i] = x * scale;
+        dst[3 * i + 1] = y * scale;
+        dst[3 * i + 2] = z * scale;
+    }
+}
+
+template<typename T, typename ENCODE_F>
+static void encodeOctahedral(const float* src, T* dst, size_t count, const ENCODE_F& encode) {
+    float folded[2 * OCTAHEDRAL_BLOCK_SIZE];
+    for (size_t i = 0; i < count; i += OCTAHEDRAL_BLOCK_SIZE) {
+        size_t n = std::min(count - i, OCTAHEDRAL_BLOCK_SIZE);
+        foldOctahedral(src + 3 * i, folded, n);
+        encode(folded, dst + 2 * i, 2 * n);
+    }
+}
+
+template<typename T, typename DECODE_F>
+static void decodeOctahedral(const T* src, float* dst, size_t count, const DECODE_F& decode) {
+    float folded[2 * OCTAHEDRAL_BLOCK_SIZE];
+    for (size_t i = 0; i < count; i += OCTAHEDRAL_BLOCK_SIZE) {
+        size_t n = std::min(count - i, OCTAHEDRAL_BLOCK_SIZE);
+        decode(src + 2 * i, folded, 2 * n);
+        unfoldOctahedral(folded, dst + 3 * i, n);
+    }
+}
+
+void encodeOctahedralSnorm8(const float* src, Snorm8* dst, size_t count) {
+    encodeOctahedral(src, dst, count, encodeSnorm8);
+}
+
+void decodeOctahedralSnorm8(const Snorm8* src, float* dst, size_t count) {
+    decodeOctahedral(src, dst, count, decodeSnorm8);
+}
+
+void encodeOctahedralSnorm16(const float* src, Snorm16* dst, size_t count) {
+    encodeOctahedral(src, dst, count, encodeSnorm16);
+}
+
+void decodeOctahedralSnorm16(const Snorm16* src, float* dst, size_t count) {
+    decodeOctahedral(src, dst, count, decodeSnorm16);
+}
+
+// Generic conversions
+
+void encodeComponents(const float* src, void* dst, MeshAttributeComponentType componentType, size_t count) {
+    switch (componentType) {
+    case MeshAttributeComponentType::FLOAT:
+        memcpy(dst, src, count * sizeof(float));
+        return;
+    case MeshAttributeComponentType::HALF:
+        encodeHalf(src, static_cast<Half*>(dst), count);
+        return;
+    case MeshAttributeComponentType::SNORM8:
+        encodeSnorm8(src, static_cast<Snorm8*>(dst), count);
+        return;
+    case MeshAttributeComponentType::UNORM8:
+        encodeUnorm8(src, static_cast<Unorm8*>(dst), count);
+        return;
+    case MeshAttributeComponentType::SNORM16:
+        encodeSnorm16(src, static_cast<Snorm16*>(dst), count);
+        return;
+    case MeshAttributeComponentType::UNORM16:
+        encodeUnorm16(src, static_cast<Unorm16*>(dst), count);
+        return;
+    default:
+        throw std::invalid_argument("Component type " + std::to_string(static_cast<int>(componentType)) + " can not be encoded from floats.");
+    }
+}
+
+void decodeComponents(const void* src, MeshAttributeComponentType componentType, float* dst, size_t count) {
+    switch (componentType) {
+    case MeshAttributeComponentType::FLOAT:
+        memcpy(dst, src, count * sizeof(float));
+        return;
+    case MeshAttributeComponentType::HALF:
+        decodeHalf(static_cast<const Half*>(src), dst, count);
+        return;
+    case MeshAttributeComponentType::SNORM8:
+        decodeSnorm8(static_cast<const Snorm8*>(src), dst, count);
+        return;
+    case MeshAttributeComponentType::UNORM8:
+        decodeUnorm8(static_cast<const Unorm8*>(src), dst, count);
+        return;
+    case MeshAttributeComponentType::SNORM16:
+        decodeSnorm16(static_cast<const Snorm16*>(src), dst, count);
+        return;
+    case MeshAttributeComponentType::UNORM16:
+        decodeUnorm16(static_cast<const Unorm16*>(src), dst, count);
+        return;
+    default:
+        throw std::invalid_argument("Component type " + std::to_string(static_cast<int>(componentType)) + " can not be decoded to floats.");
+    }
+}
+
+// Mesh conversions
+
+void quantizeAttribute(Mesh& mesh, MeshAttribute attribute, MeshAttributeComponentType componentType) {
+    const MeshAttributeBuffer& buffer = mesh.getAttributeBuffer(attribute);
+    if (buffer.componentType() != MeshAttributeComponentType::FLOAT) {
+        throw std::invalid_argument(std::string("Only float attributes can be quantized: ") + attributeName(attribute));
+    }
+    if (componentType == MeshAttributeComponentType::INT || componentType == MeshAttributeComponentType::UINT) {
+        throw std::invalid_argument("Attributes can only be quantized to half or normalized component types.");
+    }
+    int numComponents = buffer.numComponents();
+    auto floatBuffer = mesh.replaceAttributeBuffer(attribute, componentType, numComponents);
+    encodeComponents(static_cast<const float*>(floatBuffer->data()), mesh.getAttributeBuffer(attribute).data(),
+        componentType, mesh.numVertices() * numComponents);
+}
+
+void dequantizeAttribute(Mesh& mesh, MeshAttribute attribute) {
+    const MeshAttributeBuffer& buffer = mesh.getAttributeBuffer(attribute);
+    MeshAttributeComponentType componentType = buffer.componentType();
+    if (componentType == MeshAttributeComponentType::INT || componentType == MeshAttributeComponentType::UINT) {
+        throw std::invalid_argument(std::string("Integer attributes can not be dequantized: ") + attributeName(attribute));
+    }
+    if (componentType == MeshAttributeComponentType::FLOAT) {
+        return;
+    }
+    int numComponents = buffer.numComponents();
+    auto packedBuffer = mesh.replaceAttributeBuffer(attribute, MeshAttributeComponentType::FLOAT, numComponents);
+    decodeComponents(packedBuffer->data(), componentType,
+        static_cast<float*>(mesh.getAttributeBuffer(attribute).data()), mesh.numVertices() * numComponents);
+}
+
+void encodeOctahedralNormals(Mesh& mesh, MeshAttributeComponentType componentType) {
+    const MeshAttributeBuffer& buffer = mesh.getAttributeBuffer(MeshAttribute::NORMAL);
+    if (buffer.componentType() != MeshAttributeComponentType::FLOAT || buffer.numComponents() != 3) {
+        throw std::invalid_argument("Only vec3 float normals can be encoded as octahedral normals.");
+    }
+    if (componentType != MeshAttributeComponentType::SNORM8 && componentType != MeshAttributeComponentType::SNORM16) {
+        throw std::invalid_argument("Octahedral normals can only be encoded as SNORM8 or SNORM16.");
+    }
+    auto floatBuffer = mesh.replaceAttributeBuffer(MeshAttribute::NORMAL, componentType, 2);
+    const float* src = static_cast<const float*>(floatBuffer->data());
+    void* dst = mesh.getAttributeBuffer(MeshAttribute::NORMAL).data();
+    if (componentType == MeshAttributeComponentType::SNORM8) {
+        encodeOctahedralSnorm8(src, static_cast<Snorm8*>(dst), mesh.numVertices());
+    } else {
+        encodeOctahedralSnorm16(src, static_cast<Snorm16*>(dst), mesh.numVertices());
+    }
+}
+
+void decodeOctahedralNormals(Mesh& mesh) {
+    const MeshAttributeBuffer& buffer = mesh.getAttributeBuffer(MeshAttribute::NORMAL);
+    MeshAttributeComponentType componentType = buffer.componentType();
+    if ((componentType != MeshAttributeComponentType::SNORM8 && componentType != MeshAttributeComponentType::SNORM16)
+            || buffer.numComponents() != 2) {
+        throw std::invalid_argument("Normals are not octahedral normals.");
+    }
+    auto packedBuffer = mesh.replaceAttributeBuffer(MeshAttribute::NORMAL, MeshAttributeComponentType::FLOAT, 3);
+    float* dst = static_cast<float*>(mesh.getAttributeBuffer(MeshAttribute::NORMAL).data());
+    if (componentType == MeshAttributeComponentType::SNORM8) {
+        decodeOctahedralSnorm8(static_cast<const Snorm8*>(packedBuffer->data()), dst, mesh.numVertices());
+    } else {
+        decodeOctahedralSnorm16(static_cast<const Snorm16*>(packedBuffer->data()), dst, mesh.numVertices());
+    }
+}
@@ -8,6 +8,16 @@ static constexpr GLenum componentTypeGLEnum(MeshAttributeComponentType type) {
         return GL_INT;
     case MeshAttributeComponentType::UINT:
         return GL_UNSIGNED_INT;
+    case MeshAttributeComponentType::HALF:
+        return GL_HALF_FLOAT;
+    case MeshAttributeComponentType::SNORM8:
+        return GL_BYTE;
+    case MeshAttributeComponentType::UNORM8:
+        return GL_UNSIGNED_BYTE;
+    case MeshAttributeComponentType::SNORM16:
+        return GL_SHORT;
+    case MeshAttributeComponentType::UNORM16:
+        return GL_UNSIGNED_SHORT;
     }
     return 0;
 }
@@ -22,6 +32,27 @@ static constexpr bool componentTypeIsInteger(MeshAttributeComponentType type) {
     }
 }
 
+// normalized types are converted to floats in [-1, 1] / [0, 1] by the vertex fetch
+static constexpr bool componentTypeIsNormalized(MeshAttributeComponentType type) {
+    switch (type) {
+    case MeshAttributeComponentType::SNORM8:
+    case MeshAttributeComponentType::UNORM8:
+    case MeshAttributeComponentType::SNORM16:
+    case MeshAttributeComponentType::UNORM16:
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t mappingVertexSize(const RenderMeshMapping& mapping) {
+    size_t vertexSize = 0;
+    for (const auto& attribMapping : mapping.attributeMappings) {
+        vertexSize += componentSize(attribMapping.componentType) * attribMapping.numComponents;
+    }
+    return vertexSize;
+}
+
 static ogu::vertex_buffer_binding createVertexBufferBinding(const ogu::buffer& vbo, const RenderMeshMapping& mapping) {
     std::vector<ogu::vertex_attrib_description> attribDescriptions;
     attribDescriptions.reserve(mapping.attributeMappings.size());
@@ -31,7 +62,8 @@ static ogu::vertex_buffer_binding createVertexBufferBinding(const ogu::buffer& v
         attribDescriptions.push_back(
             ogu::vertex_attrib_description(i, attribMapping.numComponents,
             componentTypeGLEnum(attribMapping.componentType), stride,
-            componentTypeIsInteger(attribMapping.componentType), false));
+            componentTypeIsInteger(attribMapping.componentType),
+            componentTypeIsNormalized(attribMapping.componentType)));
         stride += componentSize(attribMapping.componentType) * attribMapping.numComponents;
     }
     return ogu::vertex_buffer_binding(vbo, attribDescriptions, stride, false);
@@ -48,39 +80,49 @@ MeshRenderer::MeshRenderer(const RenderMeshMapping& mapping, size_t vboSize, siz
         .vboSize = vboSize,
         .iboSize = iboSize,
         .vertexOffset = 0,
-        .indexOffset = 0
+        .indexOffset = 0,
+        .indexType = MeshIndexType::UINT32
     });
-    _vertexSize = 0;
-    for (const auto& attrib : _renderMeshMapping.attributeMappings) {
-        _vertexSize += componentSize(attrib.componentType) * attrib.numComponents;
-    }
-    _indexSize = sizeof(Mesh::index_t);
-    
+    _vertexSize = mappingVertexSize(_renderMeshMapping);
+
     if (iboSize > 0) {
         _vao.bind();
         _ibo.bind(GL_ELEMENT_ARRAY_BUFFER);
     }
 }
 
-MeshRenderer::Block MeshRenderer::allocateMeshBlock(size_t numVertices, size_t numIndices) {
+MeshRenderer::Block MeshRenderer::allocateMeshBlock(size_t numVertices, size_t numIndices, MeshIndexType indexType) {
     size_t vboSize = numVertices * _vertexSize;
-    size_t iboSize = numIndices * _indexSize;
+    size_t iboSize = numIndices * indexSize(indexType);
     for (auto& freeBlock : _freeBlocks) {
-        if (freeBlock.vboSize >= vboSize && freeBlock.iboSize >= iboSize) {
+        // indices have to start at a multiple of their size, blocks without indices take no index space at all
+        size_t iboPadding = iboSize == 0 ? 0 : (indexSize(indexType) - freeBlock.iboOffset % indexSize(indexType)) % indexSize(indexType);
+        if (freeBlock.vboSize >= vboSize && freeBlock.iboSize >= iboSize + iboPadding) {
             Block block = freeBlock;
+            block.iboOffset += iboPadding;
+            block.vboSize = vboSize;
+            block.iboSize = iboSize;
+            block.indexOffset = block.iboOffset / indexSize(indexType);
+            block.indexType = indexType;
 
             freeBlock.vboSize -= vboSize;
-            freeBlock.iboSize -= iboSize;
+            freeBlock.iboSize -= iboSize + iboPadding;
             freeBlock.vboOffset += vboSize;
-            freeBlock.vboOffset += iboSize;
+            freeBlock.iboOffset += iboSize + iboPadding;
             freeBlock.vertexOffset += numVertices;
-            freeBlock.indexOffset += numIndices;
-
-            block.vboSize = vboSize;
-            block.iboSize = iboSize;
 
             return block;
         }
     }
     throw std::runtime_error("No space in MeshRenderer.");
+}
+
+void MeshRenderer::drawBlock(const Block& block) const {
+    if (block.iboSize > 0) {
+        GLenum indexTypeGLEnum = block.indexType == MeshIndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        glDrawElementsBaseVertex(GL_TRIANGLES, block.iboSize / indexSize(block.indexType), indexTypeGLEnum,
+            reinterpret_cast<const void*>(block.iboOffset), block.vertexOffset);
+    } else {
+        glDrawArrays(GL_TRIANGLES, block.vertexOffset, block.vboSize / _vertexSize);
+    }
 }
\ No newline at end of file
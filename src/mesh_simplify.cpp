@@ -0,0 +1,719 @@
+#include <mesh_simplify.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <parallel_for.hpp>
+
+
+static constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+// triangles or vertices each parallel task takes at least
+static constexpr size_t SIMPLIFY_BLOCK_SIZE = 1 << 14;
+
+// weight of the planes holding borders and seams in place, relative to the planes of the triangles
+static constexpr float BORDER_WEIGHT = 10.0f;
+
+// a pass collapses edges up to this factor costlier than the cheapest ones it needs,
+// larger factors take fewer passes but collapse worse edges
+static constexpr float PASS_ERROR_SLACK = 1.5f;
+
+// collapses turning a triangle by more than about 75 degrees count as flipping it
+static constexpr float MIN_NORMAL_COSINE = 0.25f;
+
+// how a vertex may collapse, from the triangles around it and the vertices sharing its position
+enum class VertexKind : uint8_t {
+    MANIFOLD,  // inside the surface and not on a seam: collapses into any neighbour
+    BORDER,    // on an open border: collapses along it
+    SEAM,      // on a seam between two vertices: collapses along it, together with the vertex on the other side
+    LOCKED     // where borders or seams meet or branch: never collapses
+};
+
+// sum of weighted squared distances to planes, as a symmetric 4x4 matrix, with the total weight of the planes
+// in doubles, as the error of flat surfaces would otherwise drown in rounding, and stop collapsing under small error bounds
+struct Quadric {
+    double a00, a11, a22, a10, a20, a21;
+    double b0, b1, b2;
+    double c;
+    double weight;
+};
+
+// the plane of points p with dot(normal, p) + distance = 0
+static Quadric planeQuadric(const vec3& normal, double distance, double weight) {
+    Quadric q;
+    q.a00 = weight * normal[0] * normal[0];
+    q.a11 = weight * normal[1] * normal[1];
+    q.a22 = weight * normal[2] * normal[2];
+    q.a10 = weight * normal[1] * normal[0];
+    q.a20 = weight * normal[2] * normal[0];
+    q.a21 = weight * normal[2] * normal[1];
+    q.b0 = weight * normal[0] * distance;
+    q.b1 = weight * normal[1] * distance;
+    q.b2 = weight * normal[2] * distance;
+    q.c = weight * distance * distance;
+    q.weight = weight;
+    return q;
+}
+
+static void addQuadric(Quadric& q, const Quadric& r) {
+    q.a00 += r.a00;
+    q.a11 += r.a11;
+    q.a22 += r.a22;
+    q.a10 += r.a10;
+    q.a20 += r.a20;
+    q.a21 += r.a21;
+    q.b0 += r.b0;
+    q.b1 += r.b1;
+    q.b2 += r.b2;
+    q.c += r.c;
+    q.weight += r.weight;
+}
+
+static double quadricError(const Quadric& q, const vec3& p) {
+    const double x = p[0], y = p[1], z = p[2];
+    const double rx = q.a00 * x + q.a10 * y + q.a20 * z;
+    const double ry = q.a10 * x + q.a11 * y + q.a21 * z;
+    const double rz = q.a20 * x + q.a21 * y + q.a22 * z;
+    return std::abs(rx * x + ry * y + rz * z + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c);
+}
+
+// the plane of a triangle, weighted by its area
+static Quadric triangleQuadric(const vec3& p0, const vec3& p1, const vec3& p2) {
+    vec3 normal = vecmath::cross(p1 - p0, p2 - p0);
+    const float length = vecmath::length(normal);
+    if (length == 0.0f) {
+        return Quadric {};
+    }
+    normal = normal * (1.0f / length);
+    return planeQuadric(normal, -double(vecmath::dot(normal, p0)), length);
+}
+
+// the plane through the edge from p0 to p1 upright on its triangle with p2, which keeps the edge from moving sideways
+static Quadric edgeQuadric(const vec3& p0, const vec3& p1, const vec3& p2) {
+    vec3 edge = p1 - p0;
+    const float length = vecmath::length(edge);
+    if (length == 0.0f) {
+        return Quadric {};
+    }
+    edge = edge * (1.0f / length);
+    vec3 normal = (p2 - p0) - edge * vecmath::dot(p2 - p0, edge);
+    const float normalLength = vecmath::length(normal);
+    if (normalLength == 0.0f) {
+        return Quadric {};
+    }
+    normal = normal * (1.0f / normalLength);
+    return planeQuadric(normal, -double(vecmath::dot(normal, p0)), double(length) * length * BORDER_WEIGHT);
+}
+
+// the vertex after and before v in a triangle, in winding order
+static inline uint32_t nextVertex(const uint32_t* triangle, uint32_t v) {
+    return triangle[0] == v ? triangle[1] : triangle[1] == v ? triangle[2] : triangle[0];
+}
+
+static inline uint32_t previousVertex(const uint32_t* triangle, uint32_t v) {
+    return triangle[0] == v ? triangle[2] : triangle[1] == v ? triangle[0] : triangle[1];
+}
+
+static inline uint64_t positionHash(const vec3& p) {
+    uint64_t h = 0;
+    for (int c = 0; c < 3; ++c) {
+        uint32_t bits;
+        memcpy(&bits, &p[c], sizeof(bits));
+        h = (h ^ bits) * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+static inline bool samePosition(const vec3& a, const vec3& b) {
+    for (int c = 0; c < 3; ++c) {
+        uint32_t bitsA, bitsB;
+        memcpy(&bitsA, &a[c], sizeof(bitsA));
+        memcpy(&bitsB, &b[c], sizeof(bitsB));
+        if (bitsA != bitsB) return false;
+    }
+    return true;
+}
+
+// the first vertex with bitwise the same position as each vertex
+static std::vector<uint32_t> findPositionGroups(const vec3* positions, size_t numVertices) {
+    size_t tableSize = 16;
+    while (tableSize < 2 * numVertices) tableSize <<= 1;
+    const size_t mask = tableSize - 1;
+
+    std::vector<uint32_t> table(tableSize, NO_VERTEX);
+    std::vector<uint32_t> group(numVertices);
+    for (size_t v = 0; v < numVertices; ++v) {
+        size_t slot = positionHash(positions[v]) & mask;
+        while (table[slot] != NO_VERTEX && !samePosition(positions[table[slot]], positions[v])) {
+            slot = (slot + 1) & mask;
+        }
+        if (table[slot] == NO_VERTEX) {
+            table[slot] = static_cast<uint32_t>(v);
+        }
+        group[v] = table[slot];
+    }
+    return group;
+}
+
+// triangles around each vertex
+class TriangleAdjacency {
+
+public:
+
+    void build(const std::vector<uint32_t>& indices, size_t numVertices) {
+        _offsets.assign(numVertices + 1, 0);
+        for (uint32_t v : indices) {
+            ++_offsets[v + 1];
+        }
+        for (size_t v = 0; v < numVertices; ++v) {
+            _offsets[v + 1] += _offsets[v];
+        }
+        // filling moves each offset to the start of the next vertex's triangles, they're moved back after
+        _triangles.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            _triangles[_offsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+        for (size_t v = numVertices; v > 0; --v) {
+            _offsets[v] = _offsets[v - 1];
+        }
+        _offsets[0] = 0;
+    }
+
+    const uint32_t* begin(uint32_t v) const {
+        return _triangles.data() + _offsets[v];
+    }
+
+    const uint32_t* end(uint32_t v) const {
+        return _triangles.data() + _offsets[v + 1];
+    }
+
+private:
+
+    std::vector<size_t> _offsets;
+
+    std::vector<uint32_t> _triangles;
+
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    float error;
+};
+
+class Simplifier {
+
+public:
+
+    Simplifier(const Mesh& mesh, unsigned numThreads);
+
+    // simplify a triangle list over the vertices of the mesh, error is set to the error of the result
+    std::vector<uint32_t> simplify(const std::vector<uint32_t>& indices, size_t targetTriangles, float maxError, float& error);
+
+private:
+
+    // true if a triangle has the edge from a to b, in that direction
+    bool hasEdge(uint32_t a, uint32_t b) const;
+
+    void findWedges();
+
+    void findOpenEdges();
+
+    void classifyVertices();
+
+    void computeQuadrics();
+
+    // the vertex the other side of a seam collapses into when from collapses into to
+    uint32_t seamPartner(uint32_t from, uint32_t to) const;
+
+    bool canCollapse(uint32_t from, uint32_t to) const;
+
+    float collapseError(uint32_t from, uint32_t to) const;
+
+    // true if moving from onto to would turn a triangle around it over
+    bool flipsTriangles(uint32_t from, uint32_t to) const;
+
+    // the cheaper direction of each edge that can collapse
+    void findCollapses(std::vector<Collapse>& collapses) const;
+
+    // remap the triangles to the collapsed vertices, drop those that collapsed and follow the open edges along
+    void applyCollapses();
+
+    size_t _numVertices;
+
+    unsigned _numThreads;
+
+    // scaled into the unit cube, so the quadrics keep their precision in floats
+    std::vector<vec3> _positions;
+
+    // distances between scaled positions times _scale are distances between the mesh's
+    float _scale;
+
+    // first vertex sharing each vertex's position, quadrics are kept for these
+    std::vector<uint32_t> _group;
+
+    // the rest is for the triangles being simplified
+
+    std::vector<uint32_t> _indices;
+
+    TriangleAdjacency _adjacency;
+
+    // next vertex in use sharing each vertex's position, in a cycle
+    std::vector<uint32_t> _wedge;
+
+    // the vertex across each vertex's open edge in winding order and against it, NO_VERTEX if there is none
+    // and the vertex itself if there are several
+    std::vector<uint32_t> _openNext;
+    std::vector<uint32_t> _openPrevious;
+
+    std::vector<VertexKind> _kinds;
+
+    std::vector<Quadric> _quadrics;
+
+    // what each vertex collapsed into, itself while it hasn't
+    std::vector<uint32_t> _collapsed;
+
+};
+
+Simplifier::Simplifier(const Mesh& mesh, unsigned numThreads) :
+        _numVertices(mesh.numVertices()),
+        _numThreads(numThreads) {
+    const auto& positions = mesh.getAttributeBuffer<vec3>(MeshAttribute::POSITION);
+    const vec3* source = positions.begin();
+    const MeshBounds& bounds = mesh.bounds();
+    const vec3 extent = bounds.max - bounds.min;
+    _scale = std::max({ extent[0], extent[1], extent[2] });
+    if (!(_scale > 0.0f)) {
+        _scale = 1.0f;
+    }
+    const float inverseScale = 1.0f / _scale;
+
+    _positions.resize(_numVertices);
+    parallelFor(_numVertices, SIMPLIFY_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            _positions[v] = (source[v] - bounds.min) * inverseScale;
+        }
+    }, _numThreads);
+    _group = findPositionGroups(source, _numVertices);
+}
+
+bool Simplifier::hasEdge(uint32_t a, uint32_t b) const {
+    for (const uint32_t* t = _adjacency.begin(a); t != _adjacency.end(a); ++t) {
+        if (nextVertex(&_indices[3 * *t], a) == b) return true;
+    }
+    return false;
+}
+
+void Simplifier::findWedges() {
+    // vertices no triangle uses don't count, so they can't lock the vertices sharing their position
+    std::vector<bool> used(_numVertices, false);
+    for (uint32_t v : _indices) {
+        used[v] = true;
+    }
+    _wedge.resize(_numVertices);
+    std::iota(_wedge.begin(), _wedge.end(), 0u);
+    std::vector<uint32_t> first(_numVertices, NO_VERTEX);
+    for (uint32_t v = 0; v < _numVertices; ++v) {
+        if (!used[v]) continue;
+        uint32_t& f = first[_group[v]];
+        if (f == NO_VERTEX) {
+            f = v;
+        } else {
+            _wedge[v] = _wedge[f];
+            _wedge[f] = v;
+        }
+    }
+}
+
+void Simplifier::findOpenEdges() {
+    _openNext.assign(_numVertices, NO_VERTEX);
+    _openPrevious.assign(_numVertices, NO_VERTEX);
+    parallelFor(_numVertices, SIMPLIFY_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+        for (uint32_t a = static_cast<uint32_t>(begin); a < end; ++a) {
+            for (const uint32_t* t = _adjacency.begin(a); t != _adjacency.end(a); ++t) {
+                const uint32_t* triangle = &_indices[3 * *t];
+                const uint32_t b = nextVertex(triangle, a);
+                const uint32_t p = previousVertex(triangle, a);
+                if (!hasEdge(b, a)) {
+                    _openNext[a] = _openNext[a] == NO_VERTEX || _openNext[a] == b ? b : a;
+                }
+                if (!hasEdge(a, p)) {
+                    _openPrevious[a] = _openPrevious[a] == NO_VERTEX || _openPrevious[a] == p ? p : a;
+                }
+            }
+        }
+    }, _numThreads);
+}
+
+void Simplifier::classifyVertices() {
+    auto single = [&] (const std::vector<uint32_t>& open, uint32_t v) {
+        return open[v] != NO_VERTEX && open[v] != v;
+    };
+    _kinds.assign(_numVertices, VertexKind::LOCKED);
+    parallelFor(_numVertices, SIMPLIFY_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+        for (uint32_t v = static_cast<uint32_t>(begin); v < end; ++v) {
+            const uint32_t w = _wedge[v];
+            if (w == v) {
+                if (_openNext[v] == NO_VERTEX && _openPrevious[v] == NO_VERTEX) {
+                    _kinds[v] = VertexKind::MANIFOLD;
+                } else if (single(_openNext, v) && single(_openPrevious, v)) {
+                    _kinds[v] = VertexKind::BORDER;
+                }
+            } else if (_wedge[w] == v) {
+                // the open edges of both vertices run along the same seam, one in each direction
+                if (single(_openNext, v) && single(_openPrevious, v) && single(_openNext, w) && single(_openPrevious, w) &&
+                        _group[_openNext[v]] == _group[_openPrevious[w]] && _group[_openPrevious[v]] == _group[_openNext[w]] &&
+                        _group[_openNext[v]] != _group[_openPrevious[v]]) {
+                    _kinds[v] = VertexKind::SEAM;
+                }
+            }
+        }
+    }, _numThreads);
+}
+
+void Simplifier::computeQuadrics() {
+    // each vertex sums the planes around it, then the vertices sharing a position are summed into the first of them
+    _quadrics.assign(_numVertices, Quadric {});
+    parallelFor(_numVertices, SIMPLIFY_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+        for (uint32_t a = static_cast<uint32_t>(begin); a < end; ++a) {
+            Quadric& q = _quadrics[a];
+            for (const uint32_t* t = _adjacency.begin(a); t != _adjacency.end(a); ++t) {
+                const uint32_t* triangle = &_indices[3 * *t];
+                const uint32_t b = nextVertex(triangle, a);
+                const uint32_t p = previousVertex(triangle, a);
+                addQuadric(q, triangleQuadric(_positions[triangle[0]], _positions[triangle[1]], _positions[triangle[2]]));
+                if (!hasEdge(b, a)) {
+                    addQuadric(q, edgeQuadric(_positions[a], _positions[b], _positions[p]));
+                }
+                if (!hasEdge(a, p)) {
+                    addQuadric(q, edgeQuadric(_positions[p], _positions[a], _positions[b]));
+                }
+            }
+        }
+    }, _numThreads);
+    for (uint32_t v = 0; v < _numVertices; ++v) {
+        if (_group[v] != v) {
+            addQuadric(_quadrics[_group[v]], _quadrics[v]);
+        }
+    }
+}
+
+uint32_t Simplifier::seamPartner(uint32_t from, uint32_t to) const {
+    const uint32_t other = _wedge[from];
+    const uint32_t partner = _openNext[from] == to ? _openPrevious[other] : _openNext[other];
+    if (partner == NO_VERTEX || partner == other || _group[partner] != _group[to]) {
+        return NO_VERTEX;
+    }
+    return partner;
+}
+
+bool Simplifier::canCollapse(uint32_t from, uint32_t to) const {
+    if (_group[from] == _group[to]) {
+        return false;
+    }
+    const bool alongOpenEdge = _openNext[from] == to || _openPrevious[from] == to;
+    switch (_kinds[from]) {
+    case VertexKind::MANIFOLD:
+        return true;
+    case VertexKind::BORDER:
+        return alongOpenEdge && (_kinds[to] == VertexKind::BORDER || _kinds[to] == VertexKind::LOCKED);
+    case VertexKind::SEAM:
+        return alongOpenEdge && (_kinds[to] == VertexKind::SEAM || _kinds[to] == VertexKind::LOCKED) && seamPartner(from, to) != NO_VERTEX;
+    default:
+        return false;
+    }
+}
+
+float Simplifier::collapseError(uint32_t from, uint32_t to) const {
+    const Quadric& qFrom = _quadrics[_group[from]];
+    const Quadric& qTo = _quadrics[_group[to]];
+    const double weight = qFrom.weight + qTo.weight;
+    if (weight == 0.0) {
+        return 0.0f;
+    }
+    return static_cast<float>((quadricError(qFrom, _positions[to]) + quadricError(qTo, _positions[to])) / weight);
+}
+
+bool Simplifier::flipsTriangles(uint32_t from, uint32_t to) const {
+    const uint32_t groupFrom = _group[from];
+    const uint32_t groupTo = _group[to];
+    uint32_t w = from;
+    do {
+        for (const uint32_t* t = _adjacency.begin(w); t != _adjacency.end(w); ++t) {
+            vec3 before[3], after[3];
+            bool collapses = false;
+            for (int c = 0; c < 3; ++c) {
+                // neighbours may have collapsed earlier in the pass
+                const uint32_t v = _collapsed[_indices[3 * *t + c]];
+                collapses = collapses || _group[v] == groupTo;
+                before[c] = _positions[v];
+                after[c] = _group[v] == groupFrom ? _positions[to] : before[c];
+            }
+            if (collapses) continue;
+
+            // triangles that already cover nothing can't turn over, others must not end up covering nothing either
+            const vec3 normalBefore = vecmath::cross(before[1] - before[0], before[2] - before[0]);
+            const vec3 normalAfter = vecmath::cross(after[1] - after[0], after[2] - after[0]);
+            const float lengthBefore = vecmath::dot(normalBefore, normalBefore);
+            if (lengthBefore == 0.0f) continue;
+            const float d = vecmath::dot(normalBefore, normalAfter);
+            if (d <= 0.0f || d * d < MIN_NORMAL_COSINE * MIN_NORMAL_COSINE * lengthBefore * vecmath::dot(normalAfter, normalAfter)) {
+                return true;
+            }
+        }
+        w = _wedge[w];
+    } while (w != from);
+    return false;
+}
+
+void Simplifier::findCollapses(std::vector<Collapse>& collapses) const {
+    // one slot per triangle edge, filled in parallel then compacted
+    const size_t numTriangles = _indices.size() / 3;
+    collapses.resize(3 * numTriangles);
+    parallelFor(numTriangles, SIMPLIFY_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            for (int c = 0; c < 3; ++c) {
+                const uint32_t a = _indices[3 * t + c];
+                const uint32_t b = _indices[3 * t + (c + 1) % 3];
+                Collapse& collapse = collapses[3 * t + c];
+                collapse.from = NO_VERTEX;
+
+                // inner edges are in two triangles, only one of them evaluates the edge
+                if (_group[a] > _group[b] && _openNext[a] != b && _openPrevious[b] != a) continue;
+
+                const bool ab = canCollapse(a, b), ba = canCollapse(b, a);
+                const float errorAB = ab ? collapseError(a, b) : 0.0f;
+                const float errorBA = ba ? collapseError(b, a) : 0.0f;
+                if (ab && (!ba || errorAB <= errorBA)) {
+                    collapse = Collapse { a, b, errorAB };
+                } else if (ba) {
+                    collapse = Collapse { b, a, errorBA };
+                }
+            }
+        }
+    }, _numThreads);
+    collapses.erase(std::remove_if(collapses.begin(), collapses.end(), [] (const Collapse& c) { return c.from == NO_VERTEX; }), collapses.end());
+}
+
+void Simplifier::applyCollapses() {
+    parallelFor(_indices.size(), SIMPLIFY_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            _indices[i] = _collapsed[_indices[i]];
+        }
+    }, _numThreads);
+
+    size_t kept = 0;
+    for (size_t t = 0; t < _indices.size() / 3; ++t) {
+        const uint32_t a = _indices[3 * t], b = _indices[3 * t + 1], c = _indices[3 * t + 2];
+        if (_group[a] != _group[b] && _group[b] != _group[c] && _group[c] != _group[a]) {
+            _indices[kept++] = a;
+            _indices[kept++] = b;
+            _indices[kept++] = c;
+        }
+    }
+    _indices.resize(kept);
+
+    // an open edge now ends where its vertex collapsed into, or at the edge after it if that collapsed into the vertex itself
+    auto follow = [&] (const std::vector<uint32_t>& open, uint32_t v) {
+        const uint32_t u = open[v];
+        if (u == NO_VERTEX || u == v) return u;
+        if (_collapsed[u] != v) return _collapsed[u];
+        const uint32_t after = open[u];
+        return after == NO_VERTEX || after == u ? v : _collapsed[after];
+    };
+    std::vector<uint32_t> openNext(_numVertices), openPrevious(_numVertices);
+    parallelFor(_numVertices, SIMPLIFY_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+        for (uint32_t v = static_cast<uint32_t>(begin); v < end; ++v) {
+            openNext[v] = follow(_openNext, v);
+            openPrevious[v] = follow(_openPrevious, v);
+        }
+    }, _numThreads);
+    _openNext.swap(openNext);
+    _openPrevious.swap(openPrevious);
+}
+
+std::vector<uint32_t> Simplifier::simplify(const std::vector<uint32_t>& indices, size_t targetTriangles, float maxError, float& error) {
+    // triangles with two corners in one place cover nothing, and would look like borders
+    _indices.clear();
+    for (size_t t = 0; t < indices.size() / 3; ++t) {
+        const uint32_t a = indices[3 * t], b = indices[3 * t + 1], c = indices[3 * t + 2];
+        if (_group[a] != _group[b] && _group[b] != _group[c] && _group[c] != _group[a]) {
+            _indices.insert(_indices.end(), { a, b, c });
+        }
+    }
+
+    _adjacency.build(_indices, _numVertices);
+    findWedges();
+    findOpenEdges();
+    classifyVertices();
+    computeQuadrics();
+    _collapsed.resize(_numVertices);
+    std::iota(_collapsed.begin(), _collapsed.end(), 0u);
+
+    // collapse errors are squared distances between scaled positions
+    const float maxCollapseError = (maxError / _scale) * (maxError / _scale);
+    float worstError = 0.0f;
+
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched(_numVertices);
+    while (_indices.size() / 3 > targetTriangles) {
+        findCollapses(collapses);
+
+        // collapses remove two triangles, or one on a border, so about half as many collapses as triangles are needed
+        const size_t triangleGoal = _indices.size() / 3 - targetTriangles;
+        const size_t collapseGoal = std::max<size_t>(1, triangleGoal / 2);
+        auto byError = [] (const Collapse& a, const Collapse& b) { return a.error < b.error; };
+        float errorLimit = maxCollapseError;
+        if (collapseGoal < collapses.size()) {
+            std::nth_element(collapses.begin(), collapses.begin() + collapseGoal, collapses.end(), byError);
+            errorLimit = std::min(errorLimit, collapses[collapseGoal].error * PASS_ERROR_SLACK);
+        }
+        auto last = std::partition(collapses.begin(), collapses.end(), [&] (const Collapse& c) { return c.error <= errorLimit; });
+        std::sort(collapses.begin(), last, [] (const Collapse& a, const Collapse& b) {
+            return a.error < b.error || (a.error == b.error && (a.from < b.from || (a.from == b.from && a.to < b.to)));
+        });
+
+        // each position moves or is moved onto at most once a pass, so the collapses don't interfere
+        std::fill(touched.begin(), touched.end(), false);
+        size_t numRemoved = 0, numCollapses = 0;
+        for (auto it = collapses.begin(); it != last && numRemoved < triangleGoal; ++it) {
+            const uint32_t from = it->from, to = it->to;
+            const uint32_t groupFrom = _group[from], groupTo = _group[to];
+            if (touched[groupFrom] || touched[groupTo] || flipsTriangles(from, to)) continue;
+
+            if (_kinds[from] == VertexKind::SEAM) {
+                _collapsed[_wedge[from]] = seamPartner(from, to);
+            }
+            _collapsed[from] = to;
+            addQuadric(_quadrics[groupTo], _quadrics[groupFrom]);
+            touched[groupFrom] = touched[groupTo] = true;
+            numRemoved += _kinds[from] == VertexKind::BORDER ? 1 : 2;
+            worstError = std::max(worstError, it->error);
+            ++numCollapses;
+        }
+        if (numCollapses == 0) {
+            break;
+        }
+
+        applyCollapses();
+        _adjacency.build(_indices, _numVertices);
+    }
+
+    error = std::sqrt(worstError) * _scale;
+    return std::move(_indices);
+}
+
+// the triangle list of mesh, checked to be one
+static std::vector<uint32_t> triangleList(const Mesh& mesh) {
+    if (!mesh.hasIndices()) {
+        throw std::invalid_argument("Mesh has no indices to simplify, its vertices need to be welded first");
+    }
+    if (mesh.numIndices() % 3 != 0) {
+        throw std::invalid_argument("Mesh indices are not a triangle list: " + std::to_string(mesh.numIndices()) + " indices");
+    }
+    if (mesh.numVertices() >= NO_VERTEX) {
+        throw std::invalid_argument("Mesh has too many vertices to simplify: " + std::to_string(mesh.numVertices()));
+    }
+    std::vector<uint32_t> indices(mesh.indices().begin(), mesh.indices().end());
+    for (uint32_t index : indices) {
+        if (index >= mesh.numVertices()) {
+            throw std::invalid_argument("Mesh index out of range: " + std::to_string(index));
+        }
+    }
+    return indices;
+}
+
+static void checkMaxError(float maxError) {
+    if (!(maxError >= 0.0f)) {
+        throw std::invalid_argument("Simplification error must not be negative: " + std::to_string(maxError));
+    }
+}
+
+Mesh simplifyMesh(const Mesh& mesh, size_t targetTriangles, float maxError, float* error, unsigned numThreads) {
+    checkMaxError(maxError);
+    std::vector<uint32_t> indices = triangleList(mesh);
+    float simplifiedError = 0.0f;
+    indices = Simplifier(mesh, numThreads).simplify(indices, targetTriangles, maxError, simplifiedError);
+    if (error) {
+        *error = simplifiedError;
+    }
+
+    // keep the vertices the triangles use, in the same order
+    std::vector<uint32_t> remap(mesh.numVertices(), NO_VERTEX);
+    for (uint32_t v : indices) {
+        remap[v] = 0;
+    }
+    std::vector<uint32_t> kept;
+    for (size_t v = 0; v < mesh.numVertices(); ++v) {
+        if (remap[v] != NO_VERTEX) {
+            remap[v] = static_cast<uint32_t>(kept.size());
+            kept.push_back(static_cast<uint32_t>(v));
+        }
+    }
+
+    Mesh simplified(kept.size(), mesh.memoryResource());
+    for (uint32_t i = 0; i < mesh.numAttributes(); ++i) {
+        const MeshAttributeBuffer& buffer = mesh.getAttributeBuffer(i);
+        simplified.createAttributeBuffer(buffer.getAttribute(), buffer.componentType(), buffer.numComponents());
+    }
+    parallelFor(mesh.numAttributes(), 1, [&] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const MeshAttributeBuffer& source = mesh.getAttributeBuffer(static_cast<uint32_t>(i));
+            MeshAttributeBuffer& buffer = simplified.getAttributeBuffer(static_cast<uint32_t>(i));
+            dispatchElementType(buffer.componentType(), buffer.numComponents(), [&] (auto tag) {
+                using T = typename decltype(tag)::type;
+                const T* src = static_cast<const T*>(source.data());
+                T* dst = static_cast<T*>(buffer.data());
+                for (size_t v = 0; v < kept.size(); ++v) {
+                    dst[v] = src[kept[v]];
+                }
+            });
+        }
+    }, numThreads);
+
+    simplified.indices().resize(indices.size());
+    simplified.indices().visit([&] (auto* dst) {
+        using Index = std::remove_pointer_t<decltype(dst)>;
+        for (size_t i = 0; i < indices.size(); ++i) {
+            dst[i] = static_cast<Index>(remap[indices[i]]);
+        }
+    });
+    return simplified;
+}
+
+void buildLodChain(Mesh& mesh, unsigned numLevels, float ratio, float maxError, unsigned numThreads) {
+    if (!(ratio > 0.0f && ratio < 1.0f)) {
+        throw std::invalid_argument("Level of detail ratio must be between 0 and 1: " + std::to_string(ratio));
+    }
+    checkMaxError(maxError);
+    std::vector<uint32_t> indices = triangleList(mesh);
+    mesh.clearLods();
+
+    // each level is simplified from the one before, which is faster than starting from the mesh every time
+    // and hardly worse, as the collapses of one level are the cheapest ones for the next too
+    Simplifier simplifier(mesh, numThreads);
+    float error = 0.0f;
+    for (unsigned level = 0; level < numLevels; ++level) {
+        const size_t numTriangles = indices.size() / 3;
+        const size_t targetTriangles = static_cast<size_t>(numTriangles * double(ratio));
+        float stepError = 0.0f;
+        std::vector<uint32_t> simplified = simplifier.simplify(indices, targetTriangles, std::max(0.0f, maxError - error), stepError);
+        if (simplified.empty() || simplified.size() / 3 > (numTriangles + targetTriangles) / 2) {
+            break;
+        }
+
+        error += stepError;
+        MeshLod& lod = mesh.addLod(error);
+        lod.indices.assign(simplified.begin(), simplified.end());
+        indices = std::move(simplified);
+    }
+}
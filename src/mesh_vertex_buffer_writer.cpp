@@ -41,22 +41,24 @@ static void writeMeshBlock(const Mesh& mesh, MeshRenderer& meshRenderer, const M
         }
     });
 
-    ogu::buffer& ib = meshRenderer.getIndexBuffer();
-    ib.write(block.iboOffset, block.iboSize, [&] (void* bufferData) {
-        Mesh::index_t* ibData = static_cast<Mesh::index_t*>(bufferData);
-        for (Mesh::index_t index : mesh.indices()) {
-            *(ibData++) = index + block.vertexOffset;
-        }
-    });
+    // indices are drawn relative to the block's base vertex, so they are copied as they are
+    if (block.iboSize > 0) {
+        ogu::buffer& ib = meshRenderer.getIndexBuffer();
+        ib.write(block.iboOffset, block.iboSize, [&] (void* bufferData) {
+            memcpy(bufferData, mesh.indices().data(), block.iboSize);
+        });
+    }
 }
 
-void MeshVertexBufferWriter::write(MeshRenderer& meshRenderer) const {
+MeshRenderer::Block MeshVertexBufferWriter::write(MeshRenderer& meshRenderer) const {
     // this is commented out since the exceptions thrown by Mesh are more helpful anyway
     // if (!validateRenderMeshMapping(_mesh, mapping)) {
     //     throw std::invalid_argument("Mesh does not contain all the attributes required for the given MeshRenderer.");
     // }
 
-    auto block = meshRenderer.allocateMeshBlock(_mesh.numVertices(), _mesh.indices().size());
+    auto block = meshRenderer.allocateMeshBlock(_mesh.numVertices(), _mesh.indices().size(), _mesh.indexType());
 
     writeMeshBlock(_mesh, meshRenderer, block);
+
+    return block;
 }
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include <mesh_weld.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <parallel_for.hpp>
+
+
+// vertices each hashing task takes, fixed so the shards come out the same for any number of threads
+static constexpr size_t WELD_BLOCK_SIZE = 1 << 20;
+
+// the hash table is split into 2^WELD_SHARD_BITS shards, each filled by one task
+static constexpr unsigned WELD_SHARD_BITS = 6;
+
+static constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+// grid cells further out than this are clamped, far beyond any meaningful epsilon
+static constexpr double MAX_GRID_CELL = 4611686018427387904.0;  // 2^62
+
+static inline uint64_t mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint64_t combine(uint64_t h, uint64_t value) {
+    return mix64(h ^ value) + 0x9e3779b97f4a7c15ull;
+}
+
+// one attribute buffer, as the weld reads it
+struct WeldBuffer {
+    const unsigned char* data;
+    size_t elementSize;
+    int numGridComponents;  // float components snapped to the grid, 0 to compare the element bitwise
+};
+
+// cell of x on a grid of spacing 1 / inverseEpsilon, NaNs share a cell of their own
+static inline int64_t gridCell(float x, double inverseEpsilon) {
+    if (std::isnan(x)) {
+        return std::numeric_limits<int64_t>::min();
+    }
+    return static_cast<int64_t>(std::clamp(std::floor(double(x) * inverseEpsilon), -MAX_GRID_CELL, MAX_GRID_CELL));
+}
+
+class VertexKeys {
+
+public:
+
+    VertexKeys(const Mesh& mesh, float epsilon) :
+            _inverseEpsilon(epsilon > 0.0f ? 1.0 / double(epsilon) : 0.0) {
+        for (uint32_t i = 0; i < mesh.numAttributes(); ++i) {
+            const MeshAttributeBuffer& buffer = mesh.getAttributeBuffer(i);
+            const bool grid = epsilon > 0.0f && buffer.componentType() == MeshAttributeComponentType::FLOAT;
+            _buffers.push_back(WeldBuffer { static_cast<const unsigned char*>(buffer.data()), buffer.elementSize(),
+                grid ? buffer.numComponents() : 0 });
+        }
+    }
+
+    uint64_t hash(uint32_t v) const {
+        uint64_t h = 0;
+        for (const WeldBuffer& buffer : _buffers) {
+            const unsigned char* element = buffer.data + size_t(v) * buffer.elementSize;
+            if (buffer.numGridComponents > 0) {
+                for (int c = 0; c < buffer.numGridComponents; ++c) {
+                    h = combine(h, static_cast<uint64_t>(gridCell(component(element, c), _inverseEpsilon)));
+                }
+                continue;
+            }
+            size_t offset = 0;
+            for (; offset + sizeof(uint64_t) <= buffer.elementSize; offset += sizeof(uint64_t)) {
+                uint64_t word;
+                memcpy(&word, element + offset, sizeof(word));
+                h = combine(h, word);
+            }
+            if (offset < buffer.elementSize) {
+                uint64_t word = 0;
+                memcpy(&word, element + offset, buffer.elementSize - offset);
+                h = combine(h, word);
+            }
+        }
+        return mix64(h);
+    }
+
+    bool equal(uint32_t a, uint32_t b) const {
+        for (const WeldBuffer& buffer : _buffers) {
+            const unsigned char* ea = buffer.data + size_t(a) * buffer.elementSize;
+            const unsigned char* eb = buffer.data + size_t(b) * buffer.elementSize;
+            if (buffer.numGridComponents == 0) {
+                if (memcmp(ea, eb, buffer.elementSize) != 0) return false;
+                continue;
+            }
+            for (int c = 0; c < buffer.numGridComponents; ++c) {
+                if (gridCell(component(ea, c), _inverseEpsilon) != gridCell(component(eb, c), _inverseEpsilon)) return false;
+            }
+        }
+        return true;
+    }
+
+private:
+
+    static float component(const unsigned char* element, int c) {
+        float x;
+        memcpy(&x, element + c * sizeof(float), sizeof(float));
+        return x;
+    }
+
+    std::vector<WeldBuffer> _buffers;
+
+    double _inverseEpsilon;
+
+};
+
+// the first vertex equal to each vertex
+static std::vector<uint32_t> findRepresentatives(const VertexKeys& keys, size_t numVertices, unsigned numThreads) {
+    const size_t numBlocks = (numVertices + WELD_BLOCK_SIZE - 1) / WELD_BLOCK_SIZE;
+    const size_t numShards = size_t(1) << WELD_SHARD_BITS;
+    auto blockEnd = [&] (size_t b) { return std::min(numVertices, (b + 1) * WELD_BLOCK_SIZE); };
+
+    std::vector<uint64_t> hashes(numVertices);
+    std::vector<size_t> shardOffsets(numBlocks * numShards, 0);
+    parallelFor(numBlocks, 1, [&] (size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            size_t* counts = &shardOffsets[b * numShards];
+            for (size_t v = b * WELD_BLOCK_SIZE; v < blockEnd(b); ++v) {
+                hashes[v] = keys.hash(static_cast<uint32_t>(v));
+                ++counts[hashes[v] >> (64 - WELD_SHARD_BITS)];
+            }
+        }
+    }, numThreads);
+
+    // stable scatter of the vertices into shards, so each shard lists its vertices in order
+    std::vector<size_t> shardBegin(numShards + 1, 0);
+    size_t offset = 0;
+    for (size_t s = 0; s < numShards; ++s) {
+        shardBegin[s] = offset;
+        for (size_t b = 0; b < numBlocks; ++b) {
+            const size_t count = shardOffsets[b * numShards + s];
+            shardOffsets[b * numShards + s] = offset;
+            offset += count;
+        }
+    }
+    shardBegin[numShards] = offset;
+
+    std::vector<uint32_t> order(numVertices);
+    parallelFor(numBlocks, 1, [&] (size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            size_t* offsets = &shardOffsets[b * numShards];
+            for (size_t v = b * WELD_BLOCK_SIZE; v < blockEnd(b); ++v) {
+                order[offsets[hashes[v] >> (64 - WELD_SHARD_BITS)]++] = static_cast<uint32_t>(v);
+            }
+        }
+    }, numThreads);
+
+    // table entries hold the low half of the vertex's hash next to it, so probing rarely has to look up either
+    std::vector<uint32_t> representative(numVertices);
+    parallelFor(numShards, 1, [&] (size_t begin, size_t end) {
+        std::vector<uint64_t> table;
+        for (size_t s = begin; s < end; ++s) {
+            const size_t count = shardBegin[s + 1] - shardBegin[s];
+            size_t tableSize = 16;
+            while (tableSize < 2 * count) tableSize <<= 1;
+            table.assign(tableSize, NO_VERTEX);
+            const size_t mask = tableSize - 1;
+
+            for (size_t i = shardBegin[s]; i < shardBegin[s + 1]; ++i) {
+                const uint32_t v = order[i];
+                const uint64_t entry = (hashes[v] << 32) | v;
+                size_t slot = hashes[v] & mask;
+                while (table[slot] != NO_VERTEX &&
+                        ((table[slot] ^ entry) >> 32 != 0 || !keys.equal(static_cast<uint32_t>(table[slot]), v))) {
+                    slot = (slot + 1) & mask;
+                }
+                if (table[slot] == NO_VERTEX) {
+                    table[slot] = entry;
+                }
+                representative[v] = static_cast<uint32_t>(table[slot]);
+            }
+        }
+    }, numThreads);
+    return representative;
+}
+
+void weldVertices(Mesh& mesh, float epsilon, unsigned numThreads) {
+    if (!(epsilon >= 0.0f)) {
+        throw std::invalid_argument("Weld epsilon must not be negative: " + std::to_string(epsilon));
+    }
+    const size_t numVertices = mesh.numVertices();
+    if (numVertices >= NO_VERTEX) {
+        throw std::invalid_argument("Mesh has too many vertices to weld: " + std::to_string(numVertices));
+    }
+    for (uint32_t index : mesh.indices()) {
+        if (index >= numVertices) {
+            throw std::invalid_argument("Mesh index out of range: " + std::to_string(index));
+        }
+    }
+    for (size_t level = 0; level < mesh.numLods(); ++level) {
+        for (uint32_t index : static_cast<const Mesh&>(mesh).lod(level).indices) {
+            if (index >= numVertices) {
+                throw std::invalid_argument("Mesh level of detail index out of range: " + std::to_string(index));
+            }
+        }
+    }
+
+    const Mesh& source = mesh;
+    std::vector<uint32_t> representative = findRepresentatives(VertexKeys(source, epsilon), numVertices, numThreads);
+
+    // number the representatives in order, then give the others the number of theirs
+    const size_t numBlocks = (numVertices + WELD_BLOCK_SIZE - 1) / WELD_BLOCK_SIZE;
+    auto blockEnd = [&] (size_t b) { return std::min(numVertices, (b + 1) * WELD_BLOCK_SIZE); };
+    std::vector<size_t> blockKept(numBlocks + 1, 0);
+    parallelFor(numBlocks, 1, [&] (size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            for (size_t v = b * WELD_BLOCK_SIZE; v < blockEnd(b); ++v) {
+                blockKept[b + 1] += representative[v] == v;
+            }
+        }
+    }, numThreads);
+    for (size_t b = 0; b < numBlocks; ++b) {
+        blockKept[b + 1] += blockKept[b];
+    }
+
+    std::vector<uint32_t> remap(numVertices);
+    std::vector<uint32_t> kept(blockKept[numBlocks]);
+    parallelFor(numBlocks, 1, [&] (size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            uint32_t vertex = static_cast<uint32_t>(blockKept[b]);
+            for (size_t v = b * WELD_BLOCK_SIZE; v < blockEnd(b); ++v) {
+                if (representative[v] != v) continue;
+                kept[vertex] = static_cast<uint32_t>(v);
+                remap[v] = vertex++;
+            }
+        }
+    }, numThreads);
+    parallelFor(numVertices, WELD_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            remap[v] = remap[representative[v]];
+        }
+    }, numThreads);
+
+    // kept[i] >= i, so each buffer can be compacted in place from the front, the buffers on their own threads
+    if (kept.size() < numVertices) {
+        parallelFor(mesh.numAttributes(), 1, [&] (size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                MeshAttributeBuffer& buffer = mesh.getAttributeBuffer(static_cast<uint32_t>(i));
+                dispatchElementType(buffer.componentType(), buffer.numComponents(), [&] (auto tag) {
+                    using T = typename decltype(tag)::type;
+                    T* elements = static_cast<T*>(buffer.data());
+                    for (size_t v = 0; v < kept.size(); ++v) {
+                        elements[v] = elements[kept[v]];
+                    }
+                });
+            }
+        }, numThreads);
+    }
+
+    if (!mesh.hasIndices()) {
+        mesh.indices().setIndexType(minimumIndexType(kept.size()));
+        mesh.indices().resize(numVertices - numVertices % 3);
+        mesh.indices().visit([&] (auto* indices) {
+            using Index = std::remove_pointer_t<decltype(indices)>;
+            parallelFor(mesh.numIndices(), WELD_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+                for (size_t c = begin; c < end; ++c) {
+                    indices[c] = static_cast<Index>(remap[c]);
+                }
+            }, numThreads);
+        });
+    } else {
+        mesh.indices().visit([&] (auto* indices) {
+            using Index = std::remove_pointer_t<decltype(indices)>;
+            parallelFor(mesh.numIndices(), WELD_BLOCK_SIZE, [&] (size_t begin, size_t end) {
+                for (size_t c = begin; c < end; ++c) {
+                    indices[c] = static_cast<Index>(remap[indices[c]]);
+                }
+            }, numThreads);
+        });
+    }
+    for (size_t level = 0; level < mesh.numLods(); ++level) {
+        MeshIndexBuffer& lodIndices = mesh.lod(level).indices;
+        lodIndices.visit([&] (auto* indices) {
+            using Index = std::remove_pointer_t<decltype(indices)>;
+            for (size_t c = 0; c < lodIndices.size(); ++c) {
+                indices[c] = static_cast<Index>(remap[indices[c]]);
+            }
+        });
+    }
+    mesh.setNumVertices(kept.size());
+}
@@ -0,0 +1,436 @@
+#include <render_mesh_cache.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <mapped_file.hpp>
+#include <mesh_io.hpp>
+#include <render_mesh_loader.hpp>
+
+#include "mesh_file_format.hpp"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+
+// bump whenever the entry layout or the way entries are produced changes, so old entries are never hit
+static constexpr uint32_t CACHE_VERSION = 2;
+
+static constexpr char ENTRY_ID[9] = "rmeshblk";
+static constexpr size_t ENTRY_HEADER_SIZE = 40;
+static constexpr const char* ENTRY_EXTENSION = ".rmc";
+static constexpr const char* SOURCE_HASHES_FILE = "sources.txt";
+
+// a source modified this close to when it was hashed may have been written again within the same timestamp,
+// so its recorded hash isn't trusted until it's re-hashed later
+static constexpr std::chrono::seconds RACY_SOURCE_WINDOW(2);
+
+// 64-bit hash in the style of xxHash64, four independent lanes over 32 byte blocks so it runs near memory speed
+// not cryptographic, but 64 bits make an accidental collision between cached meshes vanishingly unlikely
+
+static constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ull;
+static constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(uint64_t));
+    return v;
+}
+
+static inline uint64_t round64(uint64_t lane, uint64_t word) {
+    return rotl(lane + word * PRIME_2, 31) * PRIME_1;
+}
+
+static inline uint64_t mergeLane(uint64_t h, uint64_t lane) {
+    return (h ^ round64(0, lane)) * PRIME_1 + PRIME_4;
+}
+
+static uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t lanes[4] = { seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1 };
+        for (; end - p >= 32; p += 32) {
+            lanes[0] = round64(lanes[0], read64(p));
+            lanes[1] = round64(lanes[1], read64(p + 8));
+            lanes[2] = round64(lanes[2], read64(p + 16));
+            lanes[3] = round64(lanes[3], read64(p + 24));
+        }
+        h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+        for (uint64_t lane : lanes) {
+            h = mergeLane(h, lane);
+        }
+    } else {
+        h = seed + PRIME_5;
+    }
+
+    h += size;
+    for (; end - p >= 8; p += 8) {
+        h = rotl(h ^ round64(0, read64(p)), 27) * PRIME_1 + PRIME_4;
+    }
+    for (; p < end; ++p) {
+        h = rotl(h ^ (*p * PRIME_5), 11) * PRIME_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME_2;
+    h ^= h >> 29;
+    h *= PRIME_3;
+    h ^= h >> 32;
+    return h;
+}
+
+static std::string hexString(uint64_t value) {
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << value;
+    return ss.str();
+}
+
+RenderMeshCache::RenderMeshCache(const fs::path& directory, uint64_t maxBytes) :
+        _directory(directory),
+        _maxBytes(maxBytes),
+        _totalBytes(0),
+        _sourceHashesChanged(false) {
+    fs::create_directories(_directory);
+
+    for (const auto& file : fs::directory_iterator(_directory)) {
+        if (!file.is_regular_file()) continue;
+        const fs::path& path = file.path();
+        if (path.extension() == ENTRY_EXTENSION) {
+            Entry entry { file.file_size(), file.last_write_time() };
+            _entries.emplace(path.stem().string(), entry);
+            _totalBytes += entry.size;
+        } else if (path.extension() == ".tmp") {
+            // left behind by a store that never finished
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+    }
+
+    loadSourceHashes();
+    evict();
+}
+
+RenderMeshCache::~RenderMeshCache() {
+    try {
+        saveSourceHashes();
+    } catch (std::exception& e) {
+        std::cerr << "Failed to save render mesh cache source hashes: " << e.what() << std::endl;
+    }
+}
+
+// inode and status change time of a file, which unlike the modification time can't be set back by tools rewriting it in place
+static void statSource(const fs::path& path, int64_t& changeTime, uint64_t& fileId) {
+    changeTime = 0;
+    fileId = 0;
+#ifndef _WIN32
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        throw std::runtime_error("Cannot read file: " + path.string());
+    }
+#ifdef __APPLE__
+    changeTime = static_cast<int64_t>(st.st_ctimespec.tv_sec) * 1000000000 + st.st_ctimespec.tv_nsec;
+#else
+    changeTime = static_cast<int64_t>(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+#endif
+    fileId = static_cast<uint64_t>(st.st_ino);
+#endif
+}
+
+uint64_t RenderMeshCache::sourceHash(const std::string& meshFileName) {
+    const fs::path path = fs::canonical(meshFileName);
+    const uint64_t size = fs::file_size(path);
+    const int64_t modificationTime = fs::last_write_time(path).time_since_epoch().count();
+    int64_t changeTime;
+    uint64_t fileId;
+    statSource(path, changeTime, fileId);
+
+    auto it = _sourceHashes.find(path.string());
+    if (it != _sourceHashes.end()) {
+        const SourceHash& known = it->second;
+        const int64_t racyWindow = std::chrono::duration_cast<fs::file_time_type::duration>(RACY_SOURCE_WINDOW).count();
+        if (known.size == size && known.modificationTime == modificationTime && known.changeTime == changeTime &&
+                known.fileId == fileId && known.hashTime - known.modificationTime > racyWindow) {
+            return known.hash;
+        }
+    }
+
+    const int64_t hashTime = fs::file_time_type::clock::now().time_since_epoch().count();
+    MappedFile file(path.string());
+    SourceHash sourceHash { size, modificationTime, changeTime, fileId, hashTime, hashBytes(file.data(), file.size()) };
+    _sourceHashes[path.string()] = sourceHash;
+    _sourceHashesChanged = true;
+    return sourceHash.hash;
+}
+
+std::string RenderMeshCache::entryKey(const std::string& meshFileName, const RenderMeshMapping& mapping) {
+    std::vector<uint64_t> keyData = { sourceHash(meshFileName), CACHE_VERSION, MESH_FILE_VERSION };
+    for (const auto& attribMapping : mapping.attributeMappings) {
+        // attribute ids are only stable within a process, the name is what identifies the attribute in a file
+        const std::string& name = attributeIdentifier(attribMapping.attribute);
+        keyData.push_back(hashBytes(name.data(), name.size()));
+        keyData.push_back(static_cast<uint64_t>(attribMapping.componentType));
+        keyData.push_back(static_cast<uint64_t>(attribMapping.numComponents));
+    }
+    return hexString(hashBytes(keyData.data(), keyData.size() * sizeof(uint64_t)));
+}
+
+fs::path RenderMeshCache::entryPath(const std::string& key) const {
+    return _directory / (key + ENTRY_EXTENSION);
+}
+
+// entry layout: id, cache version, vertex size, vertex count, index count, index size, padding,
+// then the vertex and index bytes exactly as they go into the renderer's buffers
+std::optional<MeshRenderer::Block> RenderMeshCache::readEntry(const std::string& key, const std::string& meshFileName, MeshRenderer& meshRenderer) {
+    std::ifstream file(entryPath(key), std::ios::in | std::ios::binary);
+    char header[ENTRY_HEADER_SIZE];
+    if (!file.read(header, ENTRY_HEADER_SIZE) || memcmp(header, ENTRY_ID, 8) != 0 || loadField<uint32_t>(header, 8) != CACHE_VERSION) {
+        return std::nullopt;
+    }
+
+    const size_t vertexSize = loadField<uint32_t>(header, 12);
+    const uint64_t numVertices = loadField<uint64_t>(header, 16);
+    const uint64_t numIndices = loadField<uint64_t>(header, 24);
+    const uint8_t indexBytes = loadField<uint8_t>(header, 32);
+    if (vertexSize != mappingVertexSize(meshRenderer.getRenderMeshMapping()) || (indexBytes != 2 && indexBytes != 4) ||
+            ENTRY_HEADER_SIZE + numVertices * vertexSize + numIndices * indexBytes != _entries.at(key).size) {
+        return std::nullopt;
+    }
+
+    MeshRenderer::Block block = meshRenderer.allocateMeshBlock(numVertices, numIndices, static_cast<MeshIndexType>(indexBytes));
+
+    bool complete = true;
+    meshRenderer.getVertexBuffer().write(block.vboOffset, block.vboSize, [&] (void* bufferData) {
+        complete = static_cast<bool>(file.read(static_cast<char*>(bufferData), block.vboSize));
+    });
+    if (complete && block.iboSize > 0) {
+        meshRenderer.getIndexBuffer().write(block.iboOffset, block.iboSize, [&] (void* bufferData) {
+            complete = static_cast<bool>(file.read(static_cast<char*>(bufferData), block.iboSize));
+        });
+    }
+
+    // the entry changed under us, the block is already allocated so fill it from the source instead
+    if (!complete) {
+        RenderMeshLoader loader(meshFileName);
+        meshRenderer.getVertexBuffer().write(block.vboOffset, block.vboSize, [&] (void* bufferData) {
+            loader.loadVertices(meshRenderer.getRenderMeshMapping(), bufferData);
+        });
+        if (block.iboSize > 0) {
+            meshRenderer.getIndexBuffer().write(block.iboOffset, block.iboSize, [&] (void* bufferData) {
+                loader.loadIndices(bufferData, block.indexType);
+            });
+        }
+        removeEntry(key);
+        ++_stats.misses;
+        return block;
+    }
+
+    _stats.bytesRead += ENTRY_HEADER_SIZE + block.vboSize + block.iboSize;
+    return block;
+}
+
+void RenderMeshCache::storeEntry(const std::string& key, const char* vertices, size_t numVertices, size_t vertexSize,
+        const char* indices, size_t numIndices, MeshIndexType indexType) {
+    const uint64_t size = ENTRY_HEADER_SIZE + numVertices * vertexSize + numIndices * indexSize(indexType);
+    if (size > _maxBytes) {
+        return;
+    }
+
+    char header[ENTRY_HEADER_SIZE] = {};
+    memcpy(header, ENTRY_ID, 8);
+    storeField<uint32_t>(header, 8, CACHE_VERSION);
+    storeField<uint32_t>(header, 12, vertexSize);
+    storeField<uint64_t>(header, 16, numVertices);
+    storeField<uint64_t>(header, 24, numIndices);
+    storeField<uint8_t>(header, 32, indexSize(indexType));
+
+    // written under a temporary name first, so a crash never leaves a partial entry behind
+    const fs::path path = entryPath(key);
+    fs::path tmpPath = path;
+    tmpPath.replace_extension(".tmp");
+    {
+        std::ofstream file(tmpPath, std::ios::out | std::ios::binary);
+        file.write(header, ENTRY_HEADER_SIZE);
+        file.write(vertices, numVertices * vertexSize);
+        file.write(indices, numIndices * indexSize(indexType));
+        if (!file) {
+            file.close();
+            fs::remove(tmpPath);
+            throw std::runtime_error("Cannot write render mesh cache entry: " + tmpPath.string());
+        }
+    }
+    fs::rename(tmpPath, path);
+
+    _entries[key] = Entry { size, fs::last_write_time(path) };
+    _totalBytes += size;
+    _stats.bytesWritten += size;
+    ++_stats.stores;
+
+    evict();
+}
+
+void RenderMeshCache::removeEntry(const std::string& key) {
+    auto it = _entries.find(key);
+    if (it == _entries.end()) return;
+    std::error_code ec;
+    fs::remove(entryPath(key), ec);
+    _totalBytes -= it->second.size;
+    _entries.erase(it);
+}
+
+// least recently used first, an entry's last use is its modification time so it survives restarts
+void RenderMeshCache::evict() {
+    if (_totalBytes <= _maxBytes) return;
+
+    std::vector<std::pair<fs::file_time_type, std::string>> byLastUse;
+    byLastUse.reserve(_entries.size());
+    for (const auto& [key, entry] : _entries) {
+        byLastUse.emplace_back(entry.lastUse, key);
+    }
+    std::sort(byLastUse.begin(), byLastUse.end());
+
+    for (const auto& [lastUse, key] : byLastUse) {
+        if (_totalBytes <= _maxBytes) break;
+        removeEntry(key);
+        ++_stats.evictions;
+    }
+}
+
+MeshRenderer::Block RenderMeshCache::load(const std::string& meshFileName, MeshRenderer& meshRenderer) {
+    // the key hashes the file's contents, which an interrupted save may have left unfinished
+    recoverMeshFile(meshFileName);
+
+    const RenderMeshMapping& mapping = meshRenderer.getRenderMeshMapping();
+    const std::string key = entryKey(meshFileName, mapping);
+
+    if (auto it = _entries.find(key); it != _entries.end()) {
+        if (std::optional<MeshRenderer::Block> block = readEntry(key, meshFileName, meshRenderer)) {
+            if (auto hit = _entries.find(key); hit != _entries.end()) {
+                ++_stats.hits;
+                std::error_code ec;
+                hit->second.lastUse = fs::file_time_type::clock::now();
+                fs::last_write_time(entryPath(key), hit->second.lastUse, ec);
+            }
+            return *block;
+        }
+        // unreadable entries are rebuilt from the source
+        removeEntry(key);
+    }
+
+    ++_stats.misses;
+
+    RenderMeshLoader loader(meshFileName);
+    const size_t vertexSize = mappingVertexSize(mapping);
+    const MeshIndexType indexType = std::min(loader.indexType(), minimumIndexType(loader.numVertices()));
+
+    std::vector<char> vertices(loader.numVertices() * vertexSize);
+    loader.loadVertices(mapping, vertices.data());
+    std::vector<char> indices(loader.numIndices() * indexSize(indexType));
+    loader.loadIndices(indices.data(), indexType);
+
+    try {
+        storeEntry(key, vertices.data(), loader.numVertices(), vertexSize, indices.data(), loader.numIndices(), indexType);
+    } catch (std::exception& e) {
+        std::cerr << "Failed to store render mesh cache entry for " << meshFileName << ": " << e.what() << std::endl;
+    }
+
+    MeshRenderer::Block block = meshRenderer.allocateMeshBlock(loader.numVertices(), loader.numIndices(), indexType);
+    meshRenderer.getVertexBuffer().write(block.vboOffset, block.vboSize, [&] (void* bufferData) {
+        memcpy(bufferData, vertices.data(), vertices.size());
+    });
+    if (block.iboSize > 0) {
+        meshRenderer.getIndexBuffer().write(block.iboOffset, block.iboSize, [&] (void* bufferData) {
+            memcpy(bufferData, indices.data(), indices.size());
+        });
+    }
+    return block;
+}
+
+void RenderMeshCache::clear() {
+    while (!_entries.empty()) {
+        removeEntry(_entries.begin()->first);
+    }
+}
+
+RenderMeshCache::Stats RenderMeshCache::stats() const noexcept {
+    Stats stats = _stats;
+    stats.numEntries = _entries.size();
+    stats.totalBytes = _totalBytes;
+    stats.maxBytes = _maxBytes;
+    return stats;
+}
+
+void RenderMeshCache::reportStats(std::ostream& os) const {
+    Stats s = stats();
+    const uint64_t lookups = s.hits + s.misses;
+    os << "Render mesh cache: " << _directory.string() << std::endl;
+    os << "\tEntries: " << s.numEntries << std::endl;
+    os << "\tSize: " << s.totalBytes << " / " << s.maxBytes << " bytes" << std::endl;
+    os << "\tHits: " << s.hits << " / " << lookups;
+    if (lookups > 0) {
+        os << " (" << (100 * s.hits / lookups) << "%)";
+    }
+    os << std::endl;
+    os << "\tStores: " << s.stores << std::endl;
+    os << "\tEvictions: " << s.evictions << std::endl;
+    os << "\tBytes read: " << s.bytesRead << std::endl;
+    os << "\tBytes written: " << s.bytesWritten << std::endl;
+}
+
+// one line per source file: hash, size, modification time, change time, file id, hash time, path
+// lines in an older layout don't parse and are dropped, so those sources are simply hashed again
+
+void RenderMeshCache::loadSourceHashes() {
+    std::ifstream file(_directory / SOURCE_HASHES_FILE);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        SourceHash sourceHash;
+        std::string path;
+        if (ss >> std::hex >> sourceHash.hash >> std::dec >> sourceHash.size >> sourceHash.modificationTime >>
+                sourceHash.changeTime >> sourceHash.fileId >> sourceHash.hashTime && ss.get() == ' ' && std::getline(ss, path)) {
+            _sourceHashes[path] = sourceHash;
+        }
+    }
+}
+
+void RenderMeshCache::saveSourceHashes() const {
+    if (!_sourceHashesChanged) return;
+
+    const fs::path path = _directory / SOURCE_HASHES_FILE;
+    fs::path tmpPath = path;
+    tmpPath.replace_extension(".tmp");
+    {
+        std::ofstream file(tmpPath);
+        for (const auto& [sourcePath, sourceHash] : _sourceHashes) {
+            // files that are gone will never be looked up again
+            std::error_code ec;
+            if (!fs::exists(sourcePath, ec)) continue;
+            file << hexString(sourceHash.hash) << ' ' << sourceHash.size << ' ' << sourceHash.modificationTime << ' ' <<
+                sourceHash.changeTime << ' ' << sourceHash.fileId << ' ' << sourceHash.hashTime << ' ' << sourcePath << '\n';
+        }
+        if (!file) {
+            throw std::runtime_error("Cannot write file: " + tmpPath.string());
+        }
+    }
+    fs::rename(tmpPath, path);
+}
@@ -0,0 +1,203 @@
+#include <render_mesh_loader.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <mapped_file.hpp>
+#include <mesh_codec.hpp>
+#include <mesh_io.hpp>
+#include <strided_copy.hpp>
+
+#include "mesh_file_format.hpp"
+
+
+// finish or discard an interrupted saveMesh patch of fileName before mapping it
+static const std::string& recoveredFileName(const std::string& fileName) {
+    recoverMeshFile(fileName);
+    return fileName;
+}
+
+RenderMeshLoader::RenderMeshLoader(const std::string& fileName) :
+        _file(std::make_unique<MappedFile>(recoveredFileName(fileName))),
+        _layout(std::make_unique<MeshFileLayout>(parseFileLayout(_file->data(), _file->size()))) {
+}
+
+RenderMeshLoader::~RenderMeshLoader() = default;
+
+size_t RenderMeshLoader::numVertices() const noexcept {
+    return _layout->vertexCount;
+}
+
+size_t RenderMeshLoader::numIndices() const noexcept {
+    return _layout->indexCount;
+}
+
+MeshIndexType RenderMeshLoader::indexType() const noexcept {
+    return _layout->indexType;
+}
+
+RenderMeshMapping::AttributeMapping RenderMeshLoader::attributeMapping(MeshAttribute attribute) const {
+    for (size_t i = 0; i < _layout->attribNames.size(); ++i) {
+        if (getAttributeFromName(_layout->attribNames[i]) == attribute) {
+            const AttribData& data = _layout->attribData[i];
+            return {
+                .attribute = attribute,
+                .componentType = static_cast<MeshAttributeComponentType>(data.componentType),
+                .numComponents = data.numComponents
+            };
+        }
+    }
+    throw std::invalid_argument(std::string("Mesh file has no buffer for attribute: ") + attributeName(attribute));
+}
+
+// index of the file attribute for each attribute mapping
+static std::vector<size_t> findMappedAttributes(const MeshFileLayout& layout, const RenderMeshMapping& mapping) {
+    std::vector<size_t> fileAttributes;
+    fileAttributes.reserve(mapping.attributeMappings.size());
+    for (const auto& attribMapping : mapping.attributeMappings) {
+        size_t i = 0;
+        while (i < layout.attribNames.size() && getAttributeFromName(layout.attribNames[i]) != attribMapping.attribute) {
+            ++i;
+        }
+        if (i == layout.attribNames.size()) {
+            throw std::invalid_argument(std::string("Mesh file has no buffer for attribute: ") + attributeName(attribMapping.attribute));
+        }
+        const AttribData& data = layout.attribData[i];
+        if (static_cast<MeshAttributeComponentType>(data.componentType) != attribMapping.componentType ||
+                data.numComponents != attribMapping.numComponents) {
+            throw std::invalid_argument(std::string("Mesh file stores attribute with a different type than the mapping: ") +
+                attributeName(attribMapping.attribute));
+        }
+        fileAttributes.push_back(i);
+    }
+    return fileAttributes;
+}
+
+bool RenderMeshLoader::matchesLayout(const RenderMeshMapping& mapping) const {
+    if (_layout->encoding != MeshFileEncoding::RAW || _layout->attribData.size() != mapping.attributeMappings.size()) {
+        return false;
+    }
+    std::vector<size_t> fileAttributes = findMappedAttributes(*_layout, mapping);
+    const size_t vertexSize = mappingVertexSize(mapping);
+    size_t offset = 0;
+    for (size_t i = 0; i < fileAttributes.size(); ++i) {
+        const AttribData& data = _layout->attribData[fileAttributes[i]];
+        if (fileAttributes[i] != i || data.vertexBufferOffset != offset || data.vertexBufferStride != vertexSize) {
+            return false;
+        }
+        offset += componentSize(mapping.attributeMappings[i].componentType) * mapping.attributeMappings[i].numComponents;
+    }
+    return true;
+}
+
+void RenderMeshLoader::loadVertices(const RenderMeshMapping& mapping, void* vertexData) const {
+    const size_t numVertices = _layout->vertexCount;
+    const size_t vertexSize = mappingVertexSize(mapping);
+    const char* vertexBuffer = _file->data() + _layout->vertexBufferPosition;
+
+    if (matchesLayout(mapping)) {
+        memcpy(vertexData, vertexBuffer, numVertices * vertexSize);
+        return;
+    }
+
+    std::vector<size_t> fileAttributes = findMappedAttributes(*_layout, mapping);
+    std::vector<StridedCopy> copies;
+    copies.reserve(fileAttributes.size());
+
+    // compressed attributes are decoded tightly packed, then scattered like any other
+    MeshStreamCodec codec;
+    std::vector<std::vector<char>> decoded(_layout->encoding == MeshFileEncoding::COMPRESSED ? fileAttributes.size() : 0);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < fileAttributes.size(); ++i) {
+        const AttribData& data = _layout->attribData[fileAttributes[i]];
+        const size_t elementSize = componentSize(mapping.attributeMappings[i].componentType) * mapping.attributeMappings[i].numComponents;
+        void* dst = static_cast<char*>(vertexData) + offset;
+        offset += elementSize;
+
+        const MeshFileSection& section = _layout->attribSections[fileAttributes[i]];
+        if (_layout->encoding == MeshFileEncoding::RAW) {
+            copies.push_back(StridedCopy { dst, _file->data() + section.offset, data.vertexBufferStride, elementSize, vertexSize });
+            continue;
+        }
+
+        decoded[i].resize(numVertices * elementSize);
+        codec.decodeAttributeStream(_file->data() + section.offset, section.size,
+            decoded[i].data(), decoded[i].size(), componentSize(mapping.attributeMappings[i].componentType));
+        copies.push_back(StridedCopy { dst, decoded[i].data(), elementSize, elementSize, vertexSize });
+    }
+
+    deinterleave(copies, numVertices);
+}
+
+template<typename SRC_T, typename DST_T>
+static void rebaseIndices(const char* src, DST_T* dst, size_t numIndices, uint32_t baseVertex) {
+    for (size_t i = 0; i < numIndices; ++i) {
+        // the mapped index buffer has no alignment guarantees
+        SRC_T index;
+        memcpy(&index, src + i * sizeof(SRC_T), sizeof(SRC_T));
+        uint64_t rebased = uint64_t(index) + baseVertex;
+        if (rebased > std::numeric_limits<DST_T>::max()) {
+            throw std::out_of_range("Rebased mesh index does not fit in the index type.");
+        }
+        dst[i] = static_cast<DST_T>(rebased);
+    }
+}
+
+template<typename SRC_T>
+static void rebaseIndices(const char* src, void* dst, MeshIndexType indexType, size_t numIndices, uint32_t baseVertex) {
+    if (indexType == MeshIndexType::UINT16) {
+        rebaseIndices<SRC_T>(src, static_cast<uint16_t*>(dst), numIndices, baseVertex);
+    } else {
+        rebaseIndices<SRC_T>(src, static_cast<uint32_t*>(dst), numIndices, baseVertex);
+    }
+}
+
+void RenderMeshLoader::loadIndices(void* indexData, MeshIndexType indexType, uint32_t baseVertex) const {
+    const size_t numIndices = _layout->indexCount;
+    const MeshIndexType fileIndexType = _layout->indexType;
+    if (numIndices == 0) {
+        return;
+    }
+
+    const char* indices = _file->data() + _layout->indexSection.offset;
+    std::vector<char> decoded;
+    if (_layout->encoding == MeshFileEncoding::COMPRESSED) {
+        decoded.resize(numIndices * ::indexSize(fileIndexType));
+        MeshStreamCodec codec;
+        if (fileIndexType == MeshIndexType::UINT16) {
+            codec.decodeIndexStream(indices, _layout->indexSection.size, reinterpret_cast<uint16_t*>(decoded.data()), numIndices);
+        } else {
+            codec.decodeIndexStream(indices, _layout->indexSection.size, reinterpret_cast<uint32_t*>(decoded.data()), numIndices);
+        }
+        indices = decoded.data();
+    }
+
+    if (indexType == fileIndexType && baseVertex == 0) {
+        memcpy(indexData, indices, numIndices * ::indexSize(indexType));
+    } else if (fileIndexType == MeshIndexType::UINT16) {
+        rebaseIndices<uint16_t>(indices, indexData, indexType, numIndices, baseVertex);
+    } else {
+        rebaseIndices<uint32_t>(indices, indexData, indexType, numIndices, baseVertex);
+    }
+}
+
+MeshRenderer::Block RenderMeshLoader::load(MeshRenderer& meshRenderer) const {
+    const MeshIndexType blockIndexType = std::min(indexType(), minimumIndexType(numVertices()));
+    MeshRenderer::Block block = meshRenderer.allocateMeshBlock(numVertices(), numIndices(), blockIndexType);
+
+    meshRenderer.getVertexBuffer().write(block.vboOffset, block.vboSize, [&] (void* bufferData) {
+        loadVertices(meshRenderer.getRenderMeshMapping(), bufferData);
+    });
+
+    if (block.iboSize > 0) {
+        meshRenderer.getIndexBuffer().write(block.iboOffset, block.iboSize, [&] (void* bufferData) {
+            loadIndices(bufferData, blockIndexType);
+        });
+    }
+
+    return block;
+}
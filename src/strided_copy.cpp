@@ -0,0 +1,159 @@
+#include <strided_copy.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <parallel_for.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STRIDED_COPY_SSE2
+#include <emmintrin.h>
+#endif
+
+
+// source bytes gathered per block, small enough to stay in L1/L2 while each attribute takes its share
+static constexpr size_t BLOCK_SOURCE_BYTES = 64 << 10;
+
+// source bytes below which a range is not worth a thread of its own
+static constexpr size_t MIN_RANGE_SOURCE_BYTES = 1 << 20;
+
+// fixed size element copies, which compile to plain moves
+template<size_t N>
+static void gatherFixed(unsigned char* dst, size_t dstStride, const unsigned char* src, size_t stride, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        memcpy(dst + i * dstStride, src + i * stride, N);
+    }
+}
+
+#ifdef STRIDED_COPY_SSE2
+
+static inline __m128i load16(const unsigned char* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+static inline void store16(unsigned char* p, __m128i v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+static size_t gather8(unsigned char* dst, const unsigned char* src, size_t stride, size_t begin, size_t end) {
+    size_t i = begin;
+    for (; i + 2 <= end; i += 2) {
+        __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * stride));
+        __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + (i + 1) * stride));
+        store16(dst + i * 8, _mm_unpacklo_epi64(a, b));
+    }
+    return i;
+}
+
+// four 12 byte elements are loaded as 16 bytes each and packed into three 16 byte stores
+// the loads read 4 bytes past each element, so the last element of the range is left to the scalar loop
+static size_t gather12(unsigned char* dst, const unsigned char* src, size_t stride, size_t begin, size_t end) {
+    size_t i = begin;
+    for (; i + 4 < end; i += 4) {
+        __m128i e0 = load16(src + i * stride);
+        __m128i e1 = load16(src + (i + 1) * stride);
+        __m128i e2 = load16(src + (i + 2) * stride);
+        __m128i e3 = load16(src + (i + 3) * stride);
+        // e0[0..11] e1[0..3]
+        __m128i out0 = _mm_or_si128(_mm_srli_si128(_mm_slli_si128(e0, 4), 4), _mm_slli_si128(e1, 12));
+        // e1[4..11] e2[0..7]
+        __m128i out1 = _mm_or_si128(_mm_srli_si128(_mm_slli_si128(e1, 4), 8), _mm_slli_si128(e2, 8));
+        // e2[8..11] e3[0..11]
+        __m128i out2 = _mm_or_si128(_mm_srli_si128(_mm_slli_si128(e2, 4), 12), _mm_slli_si128(e3, 4));
+        unsigned char* d = dst + i * 12;
+        store16(d, out0);
+        store16(d + 16, out1);
+        store16(d + 32, out2);
+    }
+    return i;
+}
+
+static size_t gather16(unsigned char* dst, const unsigned char* src, size_t stride, size_t begin, size_t end) {
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128i e0 = load16(src + i * stride);
+        __m128i e1 = load16(src + (i + 1) * stride);
+        __m128i e2 = load16(src + (i + 2) * stride);
+        __m128i e3 = load16(src + (i + 3) * stride);
+        unsigned char* d = dst + i * 16;
+        store16(d, e0);
+        store16(d + 16, e1);
+        store16(d + 32, e2);
+        store16(d + 48, e3);
+    }
+    return i;
+}
+
+#endif
+
+void gatherStrided(const StridedCopy& copy, size_t begin, size_t end) {
+    if (begin >= end) {
+        return;
+    }
+    unsigned char* dst = static_cast<unsigned char*>(copy.dst);
+    const unsigned char* src = static_cast<const unsigned char*>(copy.src);
+    const size_t stride = copy.srcStride;
+    const size_t dstStride = copy.dstStride == 0 ? copy.elementSize : copy.dstStride;
+
+    if (stride == copy.elementSize && dstStride == copy.elementSize) {
+        memcpy(dst + begin * stride, src + begin * stride, (end - begin) * stride);
+        return;
+    }
+
+#ifdef STRIDED_COPY_SSE2
+    if (dstStride == copy.elementSize) {
+        switch (copy.elementSize) {
+        case 8:
+            begin = gather8(dst, src, stride, begin, end);
+            break;
+        case 12:
+            begin = gather12(dst, src, stride, begin, end);
+            break;
+        case 16:
+            begin = gather16(dst, src, stride, begin, end);
+            break;
+        }
+    }
+#endif
+
+    switch (copy.elementSize) {
+    case 4:
+        gatherFixed<4>(dst, dstStride, src, stride, begin, end);
+        return;
+    case 8:
+        gatherFixed<8>(dst, dstStride, src, stride, begin, end);
+        return;
+    case 12:
+        gatherFixed<12>(dst, dstStride, src, stride, begin, end);
+        return;
+    case 16:
+        gatherFixed<16>(dst, dstStride, src, stride, begin, end);
+        return;
+    default:
+        for (size_t i = begin; i < end; ++i) {
+            memcpy(dst + i * dstStride, src + i * stride, copy.elementSize);
+        }
+    }
+}
+
+void deinterleave(const std::vector<StridedCopy>& copies, size_t numElements, unsigned numThreads) {
+    if (copies.empty() || numElements == 0) {
+        return;
+    }
+
+    size_t maxStride = 1;
+    for (const auto& copy : copies) {
+        maxStride = std::max(maxStride, copy.srcStride);
+    }
+    const size_t blockSize = std::max<size_t>(1, BLOCK_SOURCE_BYTES / maxStride);
+    const size_t minRangeSize = std::max<size_t>(1, MIN_RANGE_SOURCE_BYTES / maxStride);
+
+    parallelFor(numElements, minRangeSize, [&] (size_t begin, size_t end) {
+        for (size_t blockBegin = begin; blockBegin < end; blockBegin += blockSize) {
+            size_t blockEnd = std::min(end, blockBegin + blockSize);
+            for (const auto& copy : copies) {
+                gatherStrided(copy, blockBegin, blockEnd);
+            }
+        }
+    }, numThreads);
+}
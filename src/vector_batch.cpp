@@ -0,0 +1,687 @@
+#include <vector_batch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VECTOR_BATCH_SSE
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define VECTOR_BATCH_AVX2
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define VECTOR_BATCH_NEON
+#include <arm_neon.h>
+#endif
+
+// gcc and clang only emit AVX2 instructions in functions marked for it, msvc emits them anywhere
+#if defined(VECTOR_BATCH_AVX2) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+
+static_assert(sizeof(vec3) == 3 * sizeof(float), "Batch math needs vec3 to be tightly packed.");
+static_assert(sizeof(mat4) == 16 * sizeof(float), "Batch math needs mat4 to be tightly packed.");
+
+namespace batch {
+
+// matrices are column major, element (row r, column c) is at c * 4 + r
+static inline const float* matrixData(const mat4& matrix) {
+    return reinterpret_cast<const float*>(&matrix);
+}
+
+static inline const float* floatData(const vec3* v) {
+    return reinterpret_cast<const float*>(v);
+}
+
+static inline float* floatData(vec3* v) {
+    return reinterpret_cast<float*>(v);
+}
+
+// Scalar reference, the vvm operations one vector at a time over [begin, end)
+
+static void transformPointsScalar(const mat4& matrix, const vec3* in, vec3* out, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        vec4 r = matrix * vec4(in[i][0], in[i][1], in[i][2], 1.0f);
+        out[i] = vec3(r[0], r[1], r[2]);
+    }
+}
+
+static void transformDirectionsScalar(const mat4& matrix, const vec3* in, vec3* out, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        vec4 r = matrix * vec4(in[i][0], in[i][1], in[i][2], 0.0f);
+        out[i] = vec3(r[0], r[1], r[2]);
+    }
+}
+
+static void normalizeScalar(const vec3* in, vec3* out, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        out[i] = vecmath::normalize(in[i]);
+    }
+}
+
+static void dotScalar(const vec3* a, const vec3* b, float* out, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        out[i] = vecmath::dot(a[i], b[i]);
+    }
+}
+
+static void crossScalar(const vec3* a, const vec3* b, vec3* out, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        out[i] = vecmath::cross(a[i], b[i]);
+    }
+}
+
+static void minMaxScalar(const vec3* in, size_t begin, size_t end, vec3& min, vec3& max) {
+    for (size_t i = begin; i < end; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            min[c] = std::min(min[c], in[i][c]);
+            max[c] = std::max(max[c], in[i][c]);
+        }
+    }
+}
+
+static void maxDistanceSquaredScalar(const vec3* in, size_t begin, size_t end, const vec3& point, float& max) {
+    for (size_t i = begin; i < end; ++i) {
+        vec3 d = in[i] - point;
+        max = std::max(max, vecmath::dot(d, d));
+    }
+}
+
+// SIMD kernels handle as many vectors as fit their width from the start of the range and return how many,
+// the scalar functions take the rest
+
+struct Kernels {
+    size_t (*transformPoints)(const mat4& matrix, const vec3* in, vec3* out, size_t count);
+    size_t (*transformDirections)(const mat4& matrix, const vec3* in, vec3* out, size_t count);
+    size_t (*normalize)(const vec3* in, vec3* out, size_t count);
+    size_t (*dot)(const vec3* a, const vec3* b, float* out, size_t count);
+    size_t (*cross)(const vec3* a, const vec3* b, vec3* out, size_t count);
+    // folds the vectors it handles into min and max
+    size_t (*minMax)(const vec3* in, size_t count, vec3& min, vec3& max);
+    size_t (*maxDistanceSquared)(const vec3* in, size_t count, const vec3& point, float& max);
+};
+
+static size_t noTransform(const mat4&, const vec3*, vec3*, size_t) { return 0; }
+static size_t noUnary(const vec3*, vec3*, size_t) { return 0; }
+static size_t noDot(const vec3*, const vec3*, float*, size_t) { return 0; }
+static size_t noCross(const vec3*, const vec3*, vec3*, size_t) { return 0; }
+static size_t noMinMax(const vec3*, size_t, vec3&, vec3&) { return 0; }
+static size_t noMaxDistance(const vec3*, size_t, const vec3&, float&) { return 0; }
+
+static const Kernels SCALAR_KERNELS = { noTransform, noTransform, noUnary, noDot, noCross, noMinMax, noMaxDistance };
+
+#ifdef VECTOR_BATCH_SSE
+
+// four vec3 as x, y and z registers
+struct Sse3 {
+    __m128 x, y, z;
+};
+
+// the 12 floats of four vectors are loaded as three registers and shuffled apart
+// v0 = x0 y0 z0 x1, v1 = y1 z1 x2 y2, v2 = z2 x3 y3 z3
+static inline Sse3 loadSse(const vec3* p) {
+    const float* f = floatData(p);
+    __m128 v0 = _mm_loadu_ps(f);
+    __m128 v1 = _mm_loadu_ps(f + 4);
+    __m128 v2 = _mm_loadu_ps(f + 8);
+    __m128 xy = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 1, 3, 2));  // x2 y2 x3 y3
+    __m128 yz = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 0, 2, 1));  // y0 z0 y1 z1
+    return {
+        _mm_shuffle_ps(v0, xy, _MM_SHUFFLE(2, 0, 3, 0)),
+        _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)),
+        _mm_shuffle_ps(yz, v2, _MM_SHUFFLE(3, 0, 3, 1))
+    };
+}
+
+static inline void storeSse(vec3* p, const Sse3& v) {
+    __m128 xy = _mm_shuffle_ps(v.x, v.y, _MM_SHUFFLE(2, 0, 2, 0));  // x0 x2 y0 y2
+    __m128 yz = _mm_shuffle_ps(v.y, v.z, _MM_SHUFFLE(3, 1, 3, 1));  // y1 y3 z1 z3
+    __m128 zx = _mm_shuffle_ps(v.z, v.x, _MM_SHUFFLE(3, 1, 2, 0));  // z0 z2 x1 x3
+    float* f = floatData(p);
+    _mm_storeu_ps(f, _mm_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(f + 4, _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm_storeu_ps(f + 8, _mm_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+// rows 0-2 of the matrix, broadcast, in the same order vvm sums them
+struct SseMatrix {
+    __m128 m[4][3];
+
+    explicit SseMatrix(const mat4& matrix) {
+        const float* data = matrixData(matrix);
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 3; ++r) {
+                m[c][r] = _mm_set1_ps(data[c * 4 + r]);
+            }
+        }
+    }
+
+    __m128 row(int r, const Sse3& v) const {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][r], v.x), _mm_mul_ps(m[1][r], v.y)), _mm_mul_ps(m[2][r], v.z));
+    }
+};
+
+static size_t transformPointsSse(const mat4& matrix, const vec3* in, vec3* out, size_t count) {
+    const SseMatrix m(matrix);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Sse3 v = loadSse(in + i);
+        storeSse(out + i, { _mm_add_ps(m.row(0, v), m.m[3][0]), _mm_add_ps(m.row(1, v), m.m[3][1]), _mm_add_ps(m.row(2, v), m.m[3][2]) });
+    }
+    return i;
+}
+
+static size_t transformDirectionsSse(const mat4& matrix, const vec3* in, vec3* out, size_t count) {
+    const SseMatrix m(matrix);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Sse3 v = loadSse(in + i);
+        storeSse(out + i, { m.row(0, v), m.row(1, v), m.row(2, v) });
+    }
+    return i;
+}
+
+static inline __m128 dotSse(const Sse3& a, const Sse3& b) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
+
+static size_t normalizeSse(const vec3* in, vec3* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Sse3 v = loadSse(in + i);
+        __m128 length = _mm_sqrt_ps(dotSse(v, v));
+        storeSse(out + i, { _mm_div_ps(v.x, length), _mm_div_ps(v.y, length), _mm_div_ps(v.z, length) });
+    }
+    return i;
+}
+
+static size_t dotSse(const vec3* a, const vec3* b, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, dotSse(loadSse(a + i), loadSse(b + i)));
+    }
+    return i;
+}
+
+static size_t crossSse(const vec3* a, const vec3* b, vec3* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Sse3 u = loadSse(a + i);
+        Sse3 v = loadSse(b + i);
+        storeSse(out + i, {
+            _mm_sub_ps(_mm_mul_ps(u.y, v.z), _mm_mul_ps(u.z, v.y)),
+            _mm_sub_ps(_mm_mul_ps(u.z, v.x), _mm_mul_ps(u.x, v.z)),
+            _mm_sub_ps(_mm_mul_ps(u.x, v.y), _mm_mul_ps(u.y, v.x))
+        });
+    }
+    return i;
+}
+
+static inline float horizontalMinSse(__m128 v) {
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+static inline float horizontalMaxSse(__m128 v) {
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+static inline void foldMinMax(const float (&lo)[3], const float (&hi)[3], vec3& min, vec3& max) {
+    for (int c = 0; c < 3; ++c) {
+        min[c] = std::min(min[c], lo[c]);
+        max[c] = std::max(max[c], hi[c]);
+    }
+}
+
+static size_t minMaxSse(const vec3* in, size_t count, vec3& min, vec3& max) {
+    if (count < 4) {
+        return 0;
+    }
+    Sse3 lo = loadSse(in);
+    Sse3 hi = lo;
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4) {
+        Sse3 v = loadSse(in + i);
+        lo = { _mm_min_ps(lo.x, v.x), _mm_min_ps(lo.y, v.y), _mm_min_ps(lo.z, v.z) };
+        hi = { _mm_max_ps(hi.x, v.x), _mm_max_ps(hi.y, v.y), _mm_max_ps(hi.z, v.z) };
+    }
+    foldMinMax({ horizontalMinSse(lo.x), horizontalMinSse(lo.y), horizontalMinSse(lo.z) },
+        { horizontalMaxSse(hi.x), horizontalMaxSse(hi.y), horizontalMaxSse(hi.z) }, min, max);
+    return i;
+}
+
+static size_t maxDistanceSquaredSse(const vec3* in, size_t count, const vec3& point, float& max) {
+    const __m128 px = _mm_set1_ps(point[0]), py = _mm_set1_ps(point[1]), pz = _mm_set1_ps(point[2]);
+    __m128 hi = _mm_set1_ps(max);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Sse3 v = loadSse(in + i);
+        Sse3 d = { _mm_sub_ps(v.x, px), _mm_sub_ps(v.y, py), _mm_sub_ps(v.z, pz) };
+        hi = _mm_max_ps(hi, dotSse(d, d));
+    }
+    max = horizontalMaxSse(hi);
+    return i;
+}
+
+static const Kernels SSE_KERNELS = { transformPointsSse, transformDirectionsSse, normalizeSse, dotSse, crossSse, minMaxSse, maxDistanceSquaredSse };
+
+#endif
+
+#ifdef VECTOR_BATCH_AVX2
+
+// eight vec3 as x, y and z registers
+struct Avx3 {
+    __m256 x, y, z;
+};
+
+// the same shuffles as loadSse, on four vectors in each 128 bit lane
+TARGET_AVX2 static inline Avx3 loadAvx(const vec3* p) {
+    const float* f = floatData(p);
+    __m256 v0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f)), _mm_loadu_ps(f + 12), 1);
+    __m256 v1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 4)), _mm_loadu_ps(f + 16), 1);
+    __m256 v2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 8)), _mm_loadu_ps(f + 20), 1);
+    __m256 xy = _mm256_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 1, 3, 2));
+    __m256 yz = _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 0, 2, 1));
+    return {
+        _mm256_shuffle_ps(v0, xy, _MM_SHUFFLE(2, 0, 3, 0)),
+        _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)),
+        _mm256_shuffle_ps(yz, v2, _MM_SHUFFLE(3, 0, 3, 1))
+    };
+}
+
+TARGET_AVX2 static inline void storeAvx(vec3* p, const Avx3& v) {
+    __m256 xy = _mm256_shuffle_ps(v.x, v.y, _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 yz = _mm256_shuffle_ps(v.y, v.z, _MM_SHUFFLE(3, 1, 3, 1));
+    __m256 zx = _mm256_shuffle_ps(v.z, v.x, _MM_SHUFFLE(3, 1, 2, 0));
+    __m256 r0 = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 r1 = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    __m256 r2 = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+    float* f = floatData(p);
+    _mm_storeu_ps(f, _mm256_castps256_ps128(r0));
+    _mm_storeu_ps(f + 4, _mm256_castps256_ps128(r1));
+    _mm_storeu_ps(f + 8, _mm256_castps256_ps128(r2));
+    _mm_storeu_ps(f + 12, _mm256_extractf128_ps(r0, 1));
+    _mm_storeu_ps(f + 16, _mm256_extractf128_ps(r1, 1));
+    _mm_storeu_ps(f + 20, _mm256_extractf128_ps(r2, 1));
+}
+
+TARGET_AVX2 static inline __m256 transformRowAvx(const __m256 (&m)[4][3], int r, const Avx3& v) {
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0][r], v.x), _mm256_mul_ps(m[1][r], v.y)), _mm256_mul_ps(m[2][r], v.z));
+}
+
+TARGET_AVX2 static inline void broadcastMatrixAvx(const mat4& matrix, __m256 (&m)[4][3]) {
+    const float* data = matrixData(matrix);
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 3; ++r) {
+            m[c][r] = _mm256_set1_ps(data[c * 4 + r]);
+        }
+    }
+}
+
+TARGET_AVX2 static size_t transformPointsAvx(const mat4& matrix, const vec3* in, vec3* out, size_t count) {
+    __m256 m[4][3];
+    broadcastMatrixAvx(matrix, m);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        Avx3 v = loadAvx(in + i);
+        storeAvx(out + i, {
+            _mm256_add_ps(transformRowAvx(m, 0, v), m[3][0]),
+            _mm256_add_ps(transformRowAvx(m, 1, v), m[3][1]),
+            _mm256_add_ps(transformRowAvx(m, 2, v), m[3][2])
+        });
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t transformDirectionsAvx(const mat4& matrix, const vec3* in, vec3* out, size_t count) {
+    __m256 m[4][3];
+    broadcastMatrixAvx(matrix, m);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        Avx3 v = loadAvx(in + i);
+        storeAvx(out + i, { transformRowAvx(m, 0, v), transformRowAvx(m, 1, v), transformRowAvx(m, 2, v) });
+    }
+    return i;
+}
+
+TARGET_AVX2 static inline __m256 dotAvx(const Avx3& a, const Avx3& b) {
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y)), _mm256_mul_ps(a.z, b.z));
+}
+
+TARGET_AVX2 static size_t normalizeAvx(const vec3* in, vec3* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        Avx3 v = loadAvx(in + i);
+        __m256 length = _mm256_sqrt_ps(dotAvx(v, v));
+        storeAvx(out + i, { _mm256_div_ps(v.x, length), _mm256_div_ps(v.y, length), _mm256_div_ps(v.z, length) });
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t dotAvx(const vec3* a, const vec3* b, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, dotAvx(loadAvx(a + i), loadAvx(b + i)));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t crossAvx(const vec3* a, const vec3* b, vec3* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        Avx3 u = loadAvx(a + i);
+        Avx3 v = loadAvx(b + i);
+        storeAvx(out + i, {
+            _mm256_sub_ps(_mm256_mul_ps(u.y, v.z), _mm256_mul_ps(u.z, v.y)),
+            _mm256_sub_ps(_mm256_mul_ps(u.z, v.x), _mm256_mul_ps(u.x, v.z)),
+            _mm256_sub_ps(_mm256_mul_ps(u.x, v.y), _mm256_mul_ps(u.y, v.x))
+        });
+    }
+    return i;
+}
+
+TARGET_AVX2 static inline float horizontalMinAvx(__m256 v) {
+    return horizontalMinSse(_mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+TARGET_AVX2 static inline float horizontalMaxAvx(__m256 v) {
+    return horizontalMaxSse(_mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+TARGET_AVX2 static size_t minMaxAvx(const vec3* in, size_t count, vec3& min, vec3& max) {
+    if (count < 8) {
+        return 0;
+    }
+    Avx3 lo = loadAvx(in);
+    Avx3 hi = lo;
+    size_t i = 8;
+    for (; i + 8 <= count; i += 8) {
+        Avx3 v = loadAvx(in + i);
+        lo = { _mm256_min_ps(lo.x, v.x), _mm256_min_ps(lo.y, v.y), _mm256_min_ps(lo.z, v.z) };
+        hi = { _mm256_max_ps(hi.x, v.x), _mm256_max_ps(hi.y, v.y), _mm256_max_ps(hi.z, v.z) };
+    }
+    foldMinMax({ horizontalMinAvx(lo.x), horizontalMinAvx(lo.y), horizontalMinAvx(lo.z) },
+        { horizontalMaxAvx(hi.x), horizontalMaxAvx(hi.y), horizontalMaxAvx(hi.z) }, min, max);
+    return i;
+}
+
+TARGET_AVX2 static size_t maxDistanceSquaredAvx(const vec3* in, size_t count, const vec3& point, float& max) {
+    const __m256 px = _mm256_set1_ps(point[0]), py = _mm256_set1_ps(point[1]), pz = _mm256_set1_ps(point[2]);
+    __m256 hi = _mm256_set1_ps(max);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        Avx3 v = loadAvx(in + i);
+        Avx3 d = { _mm256_sub_ps(v.x, px), _mm256_sub_ps(v.y, py), _mm256_sub_ps(v.z, pz) };
+        hi = _mm256_max_ps(hi, dotAvx(d, d));
+    }
+    max = horizontalMaxAvx(hi);
+    return i;
+}
+
+static const Kernels AVX2_KERNELS = { transformPointsAvx, transformDirectionsAvx, normalizeAvx, dotAvx, crossAvx, minMaxAvx, maxDistanceSquaredAvx };
+
+#endif
+
+#ifdef VECTOR_BATCH_NEON
+
+// vld3q/vst3q deinterleave and interleave four vec3 directly
+
+static inline float32x4_t transformRowNeon(const float* m, int r, const float32x4x3_t& v) {
+    return vaddq_f32(vaddq_f32(vmulq_n_f32(v.val[0], m[r]), vmulq_n_f32(v.val[1], m[4 + r])), vmulq_n_f32(v.val[2], m[8 + r]));
+}
+
+static size_t transformPointsNeon(const mat4& matrix, const vec3* in, vec3* out, size_t count) {
+    const float* m = matrixData(matrix);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x3_t v = vld3q_f32(floatData(in + i));
+        float32x4x3_t r;
+        for (int c = 0; c < 3; ++c) {
+            r.val[c] = vaddq_f32(transformRowNeon(m, c, v), vdupq_n_f32(m[12 + c]));
+        }
+        vst3q_f32(floatData(out + i), r);
+    }
+    return i;
+}
+
+static size_t transformDirectionsNeon(const mat4& matrix, const vec3* in, vec3* out, size_t count) {
+    const float* m = matrixData(matrix);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x3_t v = vld3q_f32(floatData(in + i));
+        float32x4x3_t r;
+        for (int c = 0; c < 3; ++c) {
+            r.val[c] = transformRowNeon(m, c, v);
+        }
+        vst3q_f32(floatData(out + i), r);
+    }
+    return i;
+}
+
+static inline float32x4_t dotNeon(const float32x4x3_t& a, const float32x4x3_t& b) {
+    return vaddq_f32(vaddq_f32(vmulq_f32(a.val[0], b.val[0]), vmulq_f32(a.val[1], b.val[1])), vmulq_f32(a.val[2], b.val[2]));
+}
+
+static size_t normalizeNeon(const vec3* in, vec3* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x3_t v = vld3q_f32(floatData(in + i));
+        float32x4_t length = vsqrtq_f32(dotNeon(v, v));
+        for (int c = 0; c < 3; ++c) {
+            v.val[c] = vdivq_f32(v.val[c], length);
+        }
+        vst3q_f32(floatData(out + i), v);
+    }
+    return i;
+}
+
+static size_t dotNeon(const vec3* a, const vec3* b, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, dotNeon(vld3q_f32(floatData(a + i)), vld3q_f32(floatData(b + i))));
+    }
+    return i;
+}
+
+static size_t crossNeon(const vec3* a, const vec3* b, vec3* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x3_t u = vld3q_f32(floatData(a + i));
+        float32x4x3_t v = vld3q_f32(floatData(b + i));
+        float32x4x3_t r;
+        r.val[0] = vsubq_f32(vmulq_f32(u.val[1], v.val[2]), vmulq_f32(u.val[2], v.val[1]));
+        r.val[1] = vsubq_f32(vmulq_f32(u.val[2], v.val[0]), vmulq_f32(u.val[0], v.val[2]));
+        r.val[2] = vsubq_f32(vmulq_f32(u.val[0], v.val[1]), vmulq_f32(u.val[1], v.val[0]));
+        vst3q_f32(floatData(out + i), r);
+    }
+    return i;
+}
+
+static size_t minMaxNeon(const vec3* in, size_t count, vec3& min, vec3& max) {
+    if (count < 4) {
+        return 0;
+    }
+    float32x4x3_t lo = vld3q_f32(floatData(in));
+    float32x4x3_t hi = lo;
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x3_t v = vld3q_f32(floatData(in + i));
+        for (int c = 0; c < 3; ++c) {
+            lo.val[c] = vminq_f32(lo.val[c], v.val[c]);
+            hi.val[c] = vmaxq_f32(hi.val[c], v.val[c]);
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        min[c] = std::min(min[c], vminvq_f32(lo.val[c]));
+        max[c] = std::max(max[c], vmaxvq_f32(hi.val[c]));
+    }
+    return i;
+}
+
+static size_t maxDistanceSquaredNeon(const vec3* in, size_t count, const vec3& point, float& max) {
+    float32x4x3_t p;
+    for (int c = 0; c < 3; ++c) {
+        p.val[c] = vdupq_n_f32(point[c]);
+    }
+    float32x4_t hi = vdupq_n_f32(max);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x3_t d = vld3q_f32(floatData(in + i));
+        for (int c = 0; c < 3; ++c) {
+            d.val[c] = vsubq_f32(d.val[c], p.val[c]);
+        }
+        hi = vmaxq_f32(hi, dotNeon(d, d));
+    }
+    max = vmaxvq_f32(hi);
+    return i;
+}
+
+static const Kernels NEON_KERNELS = { transformPointsNeon, transformDirectionsNeon, normalizeNeon, dotNeon, crossNeon, minMaxNeon, maxDistanceSquaredNeon };
+
+#endif
+
+// Dispatch
+
+static SimdLevel detectSimdLevel() {
+#if defined(VECTOR_BATCH_AVX2) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+#elif defined(VECTOR_BATCH_AVX2) && defined(_MSC_VER)
+    // avx2 needs both the cpu and the os, which has to save the ymm registers
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    if (osSavesYmm && (info[1] & (1 << 5))) {
+        return SimdLevel::AVX2;
+    }
+#endif
+#if defined(VECTOR_BATCH_SSE)
+    return SimdLevel::SSE;
+#elif defined(VECTOR_BATCH_NEON)
+    return SimdLevel::NEON;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+static bool isSupported(SimdLevel level) {
+    SimdLevel supported = supportedSimdLevel();
+    switch (level) {
+    case SimdLevel::SCALAR:
+        return true;
+    case SimdLevel::SSE:
+        return supported == SimdLevel::SSE || supported == SimdLevel::AVX2;
+    default:
+        return level == supported;
+    }
+}
+
+static const Kernels& kernelsFor(SimdLevel level) {
+    switch (level) {
+#ifdef VECTOR_BATCH_SSE
+    case SimdLevel::SSE:
+        return SSE_KERNELS;
+#endif
+#ifdef VECTOR_BATCH_AVX2
+    case SimdLevel::AVX2:
+        return AVX2_KERNELS;
+#endif
+#ifdef VECTOR_BATCH_NEON
+    case SimdLevel::NEON:
+        return NEON_KERNELS;
+#endif
+    default:
+        return SCALAR_KERNELS;
+    }
+}
+
+static std::atomic<SimdLevel>& currentLevel() {
+    static std::atomic<SimdLevel> level(supportedSimdLevel());
+    return level;
+}
+
+static const Kernels& kernels() {
+    return kernelsFor(currentLevel().load(std::memory_order_relaxed));
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SCALAR:
+        return "scalar";
+    case SimdLevel::SSE:
+        return "sse";
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::NEON:
+        return "neon";
+    default:
+        return "unknown";
+    }
+}
+
+SimdLevel supportedSimdLevel() {
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+SimdLevel simdLevel() {
+    return currentLevel().load(std::memory_order_relaxed);
+}
+
+void setSimdLevel(SimdLevel level) {
+    if (!isSupported(level)) {
+        throw std::invalid_argument(std::string("SIMD level is not supported on this CPU: ") + simdLevelName(level));
+    }
+    currentLevel().store(level, std::memory_order_relaxed);
+}
+
+void transformPoints(const mat4& matrix, const vec3* in, vec3* out, size_t count) {
+    transformPointsScalar(matrix, in, out, kernels().transformPoints(matrix, in, out, count), count);
+}
+
+void transformDirections(const mat4& matrix, const vec3* in, vec3* out, size_t count) {
+    transformDirectionsScalar(matrix, in, out, kernels().transformDirections(matrix, in, out, count), count);
+}
+
+void normalize(const vec3* in, vec3* out, size_t count) {
+    normalizeScalar(in, out, kernels().normalize(in, out, count), count);
+}
+
+void dot(const vec3* a, const vec3* b, float* out, size_t count) {
+    dotScalar(a, b, out, kernels().dot(a, b, out, count), count);
+}
+
+void cross(const vec3* a, const vec3* b, vec3* out, size_t count) {
+    crossScalar(a, b, out, kernels().cross(a, b, out, count), count);
+}
+
+void minMax(const vec3* in, size_t count, vec3& min, vec3& max) {
+    if (count == 0) {
+        throw std::invalid_argument("Min and max of no vectors");
+    }
+    min = in[0];
+    max = in[0];
+    minMaxScalar(in, kernels().minMax(in, count, min, max), count, min, max);
+}
+
+float maxDistanceSquared(const vec3* in, size_t count, const vec3& point) {
+    float max = 0.0f;
+    maxDistanceSquaredScalar(in, kernels().maxDistanceSquared(in, count, point, max), count, point, max);
+    return max;
+}
+
+}
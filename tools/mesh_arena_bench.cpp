@@ -0,0 +1,128 @@
+// Benchmark of loading and unloading a scene of many meshes, with meshes allocated from the default heap
+// and from one std::pmr::monotonic_buffer_resource per scene
+// Meshes are copied from a mesh file if one is given, otherwise from generated meshes of varying size
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <mesh_io.hpp>
+
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// a source mesh with position, normal and texture coordinate buffers, and a triangle list
+static Mesh generateMesh(size_t numVertices) {
+    Mesh mesh(numVertices);
+    mesh.createAttributeBuffer(MeshAttribute::POSITION, MeshAttributeComponentType::FLOAT, 3);
+    mesh.createAttributeBuffer(MeshAttribute::NORMAL, MeshAttributeComponentType::FLOAT, 3);
+    mesh.createAttributeBuffer(MeshAttribute::TEXCOORD, MeshAttributeComponentType::FLOAT, 2);
+    for (uint32_t i = 0; i < mesh.numAttributes(); ++i) {
+        auto& buffer = mesh.getAttributeBuffer(i);
+        memset(buffer.data(), 0, buffer.elementSize() * numVertices);
+    }
+    mesh.indices().resize(numVertices / 2 * 3);
+    return mesh;
+}
+
+// copy of source allocated from resource, standing in for reading it from a file
+static Mesh copyMesh(const Mesh& source, std::pmr::memory_resource* resource) {
+    Mesh mesh(source.numVertices(), resource);
+    for (uint32_t i = 0; i < source.numAttributes(); ++i) {
+        const auto& src = source.getAttributeBuffer(i);
+        auto& dst = mesh.createAttributeBuffer(src.getAttribute(), src.componentType(), src.numComponents());
+        memcpy(dst.data(), src.data(), src.elementSize() * source.numVertices());
+    }
+    mesh.indices().setIndexType(source.indexType());
+    mesh.indices().resize(source.numIndices());
+    memcpy(mesh.indices().data(), source.indices().data(), source.indices().sizeBytes());
+    return mesh;
+}
+
+struct SceneTimes {
+    double load, unload;
+};
+
+template<typename LOAD_F>
+static SceneTimes runScene(size_t numMeshes, std::pmr::memory_resource* resource, const LOAD_F& load) {
+    SceneTimes times;
+    std::vector<Mesh> scene;
+    scene.reserve(numMeshes);
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < numMeshes; ++i) {
+        scene.push_back(load(i, resource));
+    }
+    times.load = millisecondsSince(start);
+
+    start = Clock::now();
+    scene.clear();
+    if (auto* arena = dynamic_cast<std::pmr::monotonic_buffer_resource*>(resource)) {
+        arena->release();
+    }
+    times.unload = millisecondsSince(start);
+
+    return times;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " [mesh file] [mesh count]" << std::endl;
+        return 1;
+    }
+
+    try {
+        const std::string fileName = argc > 1 ? argv[1] : "";
+        const size_t numMeshes = argc > 2 ? std::stoul(argv[2]) : 2000;
+        const int numRuns = 5;
+
+        // generated meshes vary in size, like the meshes of a real scene, so the default heap fragments
+        std::vector<Mesh> sources;
+        if (fileName.empty()) {
+            for (size_t n : { 24, 300, 1500, 8000 }) {
+                sources.push_back(generateMesh(n));
+            }
+        }
+
+        auto load = [&] (size_t i, std::pmr::memory_resource* resource) {
+            if (fileName.empty()) {
+                return copyMesh(sources[i % sources.size()], resource);
+            }
+            MeshReader reader(fileName);
+            reader.setMemoryResource(resource);
+            return reader.readMesh();
+        };
+
+        // the readers log every mesh, which would drown out the allocation cost
+        std::cout.setstate(std::ios::failbit);
+
+        SceneTimes heap { 0, 0 }, arena { 0, 0 };
+        for (int run = 0; run < numRuns; ++run) {
+            SceneTimes times = runScene(numMeshes, std::pmr::new_delete_resource(), load);
+            heap.load += times.load / numRuns;
+            heap.unload += times.unload / numRuns;
+
+            std::pmr::monotonic_buffer_resource resource(64 << 20);
+            times = runScene(numMeshes, &resource, load);
+            arena.load += times.load / numRuns;
+            arena.unload += times.unload / numRuns;
+        }
+
+        std::cout.clear();
+        std::cout << numMeshes << " meshes, average of " << numRuns << " runs" << std::endl;
+        std::cout << "default heap:     load " << heap.load << " ms, unload " << heap.unload << " ms" << std::endl;
+        std::cout << "monotonic arena:  load " << arena.load << " ms, unload " << arena.unload << " ms" << std::endl;
+    } catch (std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Command line tool to reorder a mesh file for the GPU's vertex cache, overdraw and vertex fetch
+// Meshes without indices are welded first, other meshes only if asked to
+// Optionally simplifies the mesh first, and builds levels of detail before the vertices are reordered, so they're reordered along
+// Prints the simulated vertex cache efficiency before and after, at the cache size optimized for and a few others
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <mesh_io.hpp>
+#include <mesh_optimize.hpp>
+#include <mesh_simplify.hpp>
+#include <mesh_weld.hpp>
+
+
+using Clock = std::chrono::steady_clock;
+
+static void printStats(const std::string& label, const Mesh& mesh, const std::vector<unsigned>& cacheSizes) {
+    std::cout << std::left << std::setw(10) << label;
+    for (unsigned cacheSize : cacheSizes) {
+        VertexCacheStats stats = simulateVertexCache(mesh, cacheSize);
+        std::cout << std::fixed << std::setprecision(3) << std::setw(10) << stats.acmr << std::setw(10) << stats.atvr;
+    }
+    std::cout << std::endl;
+}
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> files;
+    float overdrawThreshold = 0.0f;
+    float weldEpsilon = -1.0f;
+    float simplifyRatio = 1.0f;
+    unsigned numLods = 0;
+    unsigned cacheSize = DEFAULT_VERTEX_CACHE_SIZE;
+    bool usage = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--overdraw" && i + 1 < argc) {
+            overdrawThreshold = std::stof(argv[++i]);
+        } else if (arg == "--cache-size" && i + 1 < argc) {
+            cacheSize = std::stoul(argv[++i]);
+        } else if (arg == "--weld" && i + 1 < argc) {
+            weldEpsilon = std::stof(argv[++i]);
+        } else if (arg == "--simplify" && i + 1 < argc) {
+            simplifyRatio = std::stof(argv[++i]);
+        } else if (arg == "--lods" && i + 1 < argc) {
+            numLods = std::stoul(argv[++i]);
+        } else if (arg.rfind("--", 0) == 0) {
+            usage = true;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (usage || files.empty() || files.size() > 2) {
+        std::cerr << "Usage: " << argv[0] << " [--cache-size <vertices>] [--overdraw <threshold, e.g. 1.05>] [--weld <epsilon, 0 for exact>]" <<
+            " [--simplify <fraction of triangles to keep>] [--lods <levels of detail>] <input mesh> [output mesh]" << std::endl;
+        return 1;
+    }
+
+    try {
+        Mesh mesh = MeshReader(files[0]).readMesh();
+        if (weldEpsilon >= 0.0f || !mesh.hasIndices()) {
+            const size_t numVertices = mesh.numVertices();
+            auto start = Clock::now();
+            weldVertices(mesh, std::max(0.0f, weldEpsilon));
+            std::cout << std::fixed << std::setprecision(1) << "Welded " << numVertices << " vertices to " << mesh.numVertices() <<
+                " in " << millisecondsSince(start) << " ms" << std::endl;
+        }
+
+        if (simplifyRatio < 1.0f) {
+            const size_t numTriangles = mesh.numIndices() / 3;
+            auto start = Clock::now();
+            float error = 0.0f;
+            mesh = simplifyMesh(mesh, static_cast<size_t>(numTriangles * double(simplifyRatio)), std::numeric_limits<float>::infinity(), &error);
+            std::cout << std::fixed << std::setprecision(1) << "Simplified " << numTriangles << " triangles to " << mesh.numIndices() / 3 <<
+                " in " << millisecondsSince(start) << " ms, error " << std::setprecision(6) << error << std::endl;
+        }
+
+        std::vector<unsigned> cacheSizes = { cacheSize, 8, 32 };
+        std::cout << mesh.numIndices() / 3 << " triangles, " << mesh.numVertices() << " vertices" << std::endl;
+        std::cout << std::setw(10) << "";
+        for (unsigned size : cacheSizes) {
+            std::cout << std::setw(20) << ("cache " + std::to_string(size) + (size == cacheSize ? " *" : ""));
+        }
+        std::cout << std::endl << std::setw(10) << "";
+        for (size_t i = 0; i < cacheSizes.size(); ++i) {
+            std::cout << std::setw(10) << "ACMR" << std::setw(10) << "ATVR";
+        }
+        std::cout << std::endl;
+
+        printStats("before", mesh, cacheSizes);
+
+        auto start = Clock::now();
+        optimizeVertexCache(mesh, cacheSize);
+        double cacheMs = millisecondsSince(start);
+        printStats("cache", mesh, cacheSizes);
+
+        double overdrawMs = 0;
+        if (overdrawThreshold > 0.0f) {
+            start = Clock::now();
+            optimizeOverdraw(mesh, overdrawThreshold, cacheSize);
+            overdrawMs = millisecondsSince(start);
+            printStats("overdraw", mesh, cacheSizes);
+        }
+
+        if (numLods > 0) {
+            start = Clock::now();
+            buildLodChain(mesh, numLods);
+            std::cout << std::setprecision(1) << "Built " << mesh.numLods() << " levels of detail in " << millisecondsSince(start) << " ms" << std::endl;
+            for (size_t level = 0; level < mesh.numLods(); ++level) {
+                std::cout << "\tLevel " << level + 1 << ": " << mesh.lod(level).indices.size() / 3 << " triangles, error " <<
+                    std::setprecision(6) << mesh.lod(level).error << std::endl;
+            }
+        }
+
+        start = Clock::now();
+        optimizeVertexFetch(mesh);
+        double fetchMs = millisecondsSince(start);
+
+        std::cout << std::setprecision(1) << "vertex cache " << cacheMs << " ms, overdraw " << overdrawMs << " ms, vertex fetch " << fetchMs << " ms" << std::endl;
+
+        if (files.size() > 1) {
+            MeshWriter(files[1]).writeMesh(mesh);
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+// Command line tool to build a mesh pack from existing mesh files
+// Each mesh is stored under its file name without the extension, unless given as name=path
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include <mesh_pack.hpp>
+
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <output pack> <mesh file | name=mesh file>..." << std::endl;
+        return 1;
+    }
+
+    try {
+        MeshPackWriter writer(argv[1]);
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (auto eq = arg.find('='); eq != std::string::npos) {
+                writer.addMeshFile(arg.substr(0, eq), arg.substr(eq + 1));
+            } else {
+                writer.addMeshFile(std::filesystem::path(arg).stem().string(), arg);
+            }
+        }
+        writer.write();
+    } catch (std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
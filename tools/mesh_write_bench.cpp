@@ -0,0 +1,106 @@
+// Benchmark of MeshWriter throughput with each attribute write scheme
+// Writes a generated mesh to a temporary file several times with INTERLEAVED and NON_INTERLEAVED attributes,
+// and reports the best run of each in MB/s of file written
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <mesh_io.hpp>
+
+
+using Clock = std::chrono::steady_clock;
+
+// a mesh with position, normal and texture coordinate buffers, and a triangle list
+static Mesh generateMesh(size_t numVertices) {
+    Mesh mesh(numVertices);
+    mesh.createAttributeBuffer(MeshAttribute::POSITION, MeshAttributeComponentType::FLOAT, 3);
+    mesh.createAttributeBuffer(MeshAttribute::NORMAL, MeshAttributeComponentType::FLOAT, 3);
+    mesh.createAttributeBuffer(MeshAttribute::TEXCOORD, MeshAttributeComponentType::FLOAT, 2);
+    for (uint32_t i = 0; i < mesh.numAttributes(); ++i) {
+        auto& buffer = mesh.getAttributeBuffer(i);
+        float* data = static_cast<float*>(buffer.data());
+        size_t numFloats = buffer.elementSize() / sizeof(float) * numVertices;
+        for (size_t j = 0; j < numFloats; ++j) {
+            data[j] = static_cast<float>(j % 1021) * 0.001f;
+        }
+    }
+    mesh.indices().setIndexType(MeshIndexType::UINT32);
+    mesh.indices().resize(numVertices / 2 * 3);
+    uint32_t* indices = static_cast<uint32_t*>(mesh.indices().data());
+    for (size_t i = 0; i < mesh.numIndices(); ++i) {
+        indices[i] = static_cast<uint32_t>(i % numVertices);
+    }
+    return mesh;
+}
+
+// best of numRuns writes of mesh to fileName, in seconds
+static double timeWrite(const Mesh& mesh, const std::string& fileName, MeshWriter::AttributeWriteScheme scheme, int numRuns) {
+    double best = 0;
+    for (int run = 0; run < numRuns; ++run) {
+        auto start = Clock::now();
+        {
+            MeshWriter writer(fileName);
+            writer.writeMesh(mesh, scheme);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (run == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+static size_t fileSize(const std::string& fileName) {
+    std::ifstream fs(fileName, std::ios::binary | std::ios::ate);
+    return static_cast<size_t>(fs.tellg());
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " [vertex count] [output file]" << std::endl;
+        return 1;
+    }
+
+    try {
+        const size_t numVertices = argc > 1 ? std::stoul(argv[1]) : 4000000;
+        const std::string fileName = argc > 2 ? argv[2] : "mesh_write_bench.mbin";
+        const int numRuns = 5;
+
+        Mesh mesh = generateMesh(numVertices);
+
+        struct Scheme {
+            const char* name;
+            MeshWriter::AttributeWriteScheme scheme;
+        };
+        const Scheme schemes[] = {
+            { "interleaved:     ", MeshWriter::AttributeWriteScheme::INTERLEAVED },
+            { "non-interleaved: ", MeshWriter::AttributeWriteScheme::NON_INTERLEAVED }
+        };
+
+        // the writer logs every mesh, which would drown out the write cost
+        std::cout.setstate(std::ios::failbit);
+
+        std::vector<double> seconds;
+        std::vector<size_t> sizes;
+        for (const auto& scheme : schemes) {
+            seconds.push_back(timeWrite(mesh, fileName, scheme.scheme, numRuns));
+            sizes.push_back(fileSize(fileName));
+        }
+        std::remove(fileName.c_str());
+
+        std::cout.clear();
+        std::cout << numVertices << " vertices, best of " << numRuns << " runs" << std::endl;
+        for (size_t i = 0; i < seconds.size(); ++i) {
+            double megabytes = static_cast<double>(sizes[i]) / (1 << 20);
+            std::cout << schemes[i].name << megabytes << " MB in " << seconds[i] * 1000.0 << " ms, "
+                << megabytes / seconds[i] << " MB/s" << std::endl;
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
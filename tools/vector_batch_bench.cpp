@@ -0,0 +1,159 @@
+// Benchmark of the batch vector math against a plain loop over the vvm operations
+// Runs every batch function at each SIMD level the CPU supports, and checks the results against the scalar level
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <vector_batch.hpp>
+
+
+using Clock = std::chrono::steady_clock;
+
+// best of several runs, in milliseconds
+static double timeBest(int numRuns, const std::function<void()>& f) {
+    double best = 0;
+    for (int run = 0; run < numRuns; ++run) {
+        auto start = Clock::now();
+        f();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (run == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+static size_t countMismatches(const void* a, const void* b, size_t numFloats) {
+    const float* fa = static_cast<const float*>(a);
+    const float* fb = static_cast<const float*>(b);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < numFloats; ++i) {
+        if (memcmp(fa + i, fb + i, sizeof(float)) != 0) ++mismatches;
+    }
+    return mismatches;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2) {
+        std::cerr << "Usage: " << argv[0] << " [vector count]" << std::endl;
+        return 1;
+    }
+
+    try {
+        const size_t count = argc > 1 ? std::stoul(argv[1]) : 1 << 20;
+        const int numRuns = 10;
+
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+        std::vector<vec3> a(count), b(count);
+        for (size_t i = 0; i < count; ++i) {
+            a[i] = vec3(dist(rng), dist(rng), dist(rng));
+            b[i] = vec3(dist(rng), dist(rng), dist(rng));
+        }
+        mat4 matrix;
+        float* m = reinterpret_cast<float*>(&matrix);
+        for (int i = 0; i < 16; ++i) {
+            m[i] = dist(rng);
+        }
+
+        std::vector<vec3> out(count), reference(count);
+        std::vector<float> dots(count), referenceDots(count);
+
+        struct Kernel {
+            std::string name;
+            std::function<void()> loop;   // one vvm operation per vector
+            std::function<void()> batch;
+            const void* result;
+            const void* referenceResult;
+            size_t numFloats;
+        };
+
+        vec3 min, max;
+        float radiusSquared, referenceRadiusSquared;
+        std::vector<Kernel> kernels = {
+            { "transformPoints",
+                [&] { for (size_t i = 0; i < count; ++i) { vec4 r = matrix * vec4(a[i][0], a[i][1], a[i][2], 1.0f); out[i] = vec3(r[0], r[1], r[2]); } },
+                [&] { batch::transformPoints(matrix, a.data(), out.data(), count); }, out.data(), reference.data(), count * 3 },
+            { "transformDirections",
+                [&] { for (size_t i = 0; i < count; ++i) { vec4 r = matrix * vec4(a[i][0], a[i][1], a[i][2], 0.0f); out[i] = vec3(r[0], r[1], r[2]); } },
+                [&] { batch::transformDirections(matrix, a.data(), out.data(), count); }, out.data(), reference.data(), count * 3 },
+            { "normalize",
+                [&] { for (size_t i = 0; i < count; ++i) out[i] = vecmath::normalize(a[i]); },
+                [&] { batch::normalize(a.data(), out.data(), count); }, out.data(), reference.data(), count * 3 },
+            { "dot",
+                [&] { for (size_t i = 0; i < count; ++i) dots[i] = vecmath::dot(a[i], b[i]); },
+                [&] { batch::dot(a.data(), b.data(), dots.data(), count); }, dots.data(), referenceDots.data(), count },
+            { "cross",
+                [&] { for (size_t i = 0; i < count; ++i) out[i] = vecmath::cross(a[i], b[i]); },
+                [&] { batch::cross(a.data(), b.data(), out.data(), count); }, out.data(), reference.data(), count * 3 },
+            { "minMax",
+                [&] {
+                    min = max = a[0];
+                    for (size_t i = 1; i < count; ++i) {
+                        for (int c = 0; c < 3; ++c) {
+                            min[c] = std::min(min[c], a[i][c]);
+                            max[c] = std::max(max[c], a[i][c]);
+                        }
+                    }
+                },
+                [&] { batch::minMax(a.data(), count, min, max); }, &min, nullptr, 3 },
+            { "maxDistanceSquared",
+                [&] {
+                    radiusSquared = 0.0f;
+                    for (size_t i = 0; i < count; ++i) {
+                        vec3 d = a[i] - b[0];
+                        radiusSquared = std::max(radiusSquared, vecmath::dot(d, d));
+                    }
+                },
+                [&] { radiusSquared = batch::maxDistanceSquared(a.data(), count, b[0]); }, &radiusSquared, &referenceRadiusSquared, 1 }
+        };
+
+        std::vector<batch::SimdLevel> levels = { batch::SimdLevel::SCALAR };
+        for (batch::SimdLevel level : { batch::SimdLevel::SSE, batch::SimdLevel::AVX2, batch::SimdLevel::NEON }) {
+            try {
+                batch::setSimdLevel(level);
+                levels.push_back(level);
+            } catch (std::invalid_argument&) {
+            }
+        }
+
+        std::cout << count << " vectors, best of " << numRuns << " runs, in ms" << std::endl;
+        std::cout << std::left << std::setw(22) << "" << std::setw(10) << "vvm loop";
+        for (batch::SimdLevel level : levels) {
+            std::cout << std::setw(10) << batch::simdLevelName(level);
+        }
+        std::cout << "mismatched floats" << std::endl;
+
+        vec3 referenceMin, referenceMax;
+        for (const auto& kernel : kernels) {
+            std::cout << std::setw(22) << kernel.name << std::setw(10) << timeBest(numRuns, kernel.loop);
+            size_t mismatches = 0;
+            for (batch::SimdLevel level : levels) {
+                batch::setSimdLevel(level);
+                std::cout << std::setw(10) << timeBest(numRuns, kernel.batch);
+                if (level == batch::SimdLevel::SCALAR) {
+                    if (kernel.referenceResult) {
+                        memcpy(const_cast<void*>(kernel.referenceResult), kernel.result, kernel.numFloats * sizeof(float));
+                    } else {
+                        referenceMin = min;
+                        referenceMax = max;
+                    }
+                } else if (kernel.referenceResult) {
+                    mismatches += countMismatches(kernel.result, kernel.referenceResult, kernel.numFloats);
+                } else {
+                    mismatches += countMismatches(&min, &referenceMin, 3) + countMismatches(&max, &referenceMax, 3);
+                }
+            }
+            std::cout << mismatches << std::endl;
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}